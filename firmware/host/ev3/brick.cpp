@@ -0,0 +1,347 @@
+//Emulates the EV3 brick side of the UART sensor link on a serial device or a pseudo terminal.
+//
+//  brick <device> [mode] [seconds]
+//
+//It follows the brick sequence: it reads the sensor descriptor at 2400 bps (TYPE, MODES,
+//SPEED and INFO messages up to the sensor ACK), answers ACK, switches to the announced speed,
+//selects the mode and keeps the link alive by NACK every 100 ms while it receives the data.
+//At the end it prints the descriptor and the link measurements: the time from the start
+//and from ACK to the first DATA message of the mode, the frame rate, the checksum errors
+//and the jitter of the frame intervals.
+//
+//The pseudo terminal ignores the line speed, the sensor side paces the bytes itself
+//(see lsm6ds3/pty_sensor.cpp).
+
+#include "ev3_protocol.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace host::ev3;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    static const unsigned HANDSHAKE_TIMEOUT = 10000; //ms
+    static const unsigned KEEP_ALIVE_PERIOD = 100;   //ms, the sensor restarts after 1000 ms of silence
+    static const uint32_t START_SPEED = 2400;
+
+    double milliseconds(clock_type::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    //Descriptor of the sensor mode collected from INFO messages
+    struct ModeInfo {
+        std::string name;
+        float raw[2];
+        float si[2];
+        uint8_t samples;
+        uint8_t dataType;
+        uint8_t figures;
+        uint8_t decimals;
+        bool hasFormat;
+
+        ModeInfo()
+            : samples(0), dataType(0), figures(0), decimals(0), hasFormat(false)
+        {
+            raw[0] = raw[1] = si[0] = si[1] = 0;
+        }
+    };
+
+    struct SensorDescriptor {
+        uint8_t type;
+        uint8_t modes;
+        uint8_t views;
+        uint32_t speed;
+        ModeInfo mode[UartProtocol::MAX_MODES];
+
+        SensorDescriptor()
+            : type(0), modes(0), views(0), speed(0)
+        {
+        }
+    };
+
+    uint32_t readLittleEndian(const uint8_t* data, uint8_t size) {
+        uint32_t value = 0;
+        for (uint8_t i = size; i != 0; --i) {
+            value = (value << 8) | data[i - 1];
+        }
+        return value;
+    }
+
+    float readFloat(const uint8_t* data) {
+        uint32_t bits = readLittleEndian(data, 4);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    speed_t getSpeedCode(uint32_t speed) {
+        switch (speed) {
+        case 2400:   return B2400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        default:     return B9600;
+        }
+    }
+
+    class SerialPort {
+    private:
+        int fd;
+
+    public:
+        SerialPort()
+            : fd(-1)
+        {
+        }
+
+        ~SerialPort() {
+            if (fd >= 0)
+                close(fd);
+        }
+
+        bool open(const char* path) {
+            fd = ::open(path, O_RDWR | O_NOCTTY);
+            return fd >= 0 && setSpeed(START_SPEED);
+        }
+
+        //The raw mode with the read timeout of 10 ms
+        bool setSpeed(uint32_t speed) {
+            termios settings;
+            if (tcgetattr(fd, &settings) != 0)
+                return false;
+            cfmakeraw(&settings);
+            settings.c_cc[VMIN] = 0;
+            settings.c_cc[VTIME] = 1;
+            cfsetispeed(&settings, getSpeedCode(speed));
+            cfsetospeed(&settings, getSpeedCode(speed));
+            return tcsetattr(fd, TCSANOW, &settings) == 0;
+        }
+
+        int read(uint8_t* data, size_t size) {
+            return int(::read(fd, data, size));
+        }
+
+        bool write(const uint8_t* data, size_t size) {
+            return ::write(fd, data, size) == ssize_t(size);
+        }
+
+        void writeByte(uint8_t byte) {
+            write(&byte, 1);
+        }
+    };
+
+    //Adds the message of the descriptor. Returns false if the message is not the part of it.
+    bool addInfo(const Message& message, SensorDescriptor& descriptor) {
+        if (message.type() == UartProtocol::MESSAGE_CMD) {
+            const uint8_t* payload = message.payload();
+            switch (UartProtocol::getCommand(message.command())) {
+            case UartProtocol::CMD_TYPE:
+                descriptor.type = payload[0];
+                return true;
+            case UartProtocol::CMD_MODES:
+                descriptor.modes = uint8_t(payload[0] + 1);
+                descriptor.views = uint8_t(payload[1] + 1);
+                return true;
+            case UartProtocol::CMD_SPEED:
+                descriptor.speed = readLittleEndian(payload, 4);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        if (message.type() != UartProtocol::MESSAGE_INFO)
+            return false;
+
+        ModeInfo& mode = descriptor.mode[message.mode()];
+        const uint8_t* payload = message.payload();
+        switch (message.data[1]) {
+        case UartProtocol::InfoByte::NAME:
+            mode.name.assign((const char*)payload, strnlen((const char*)payload, message.payloadSize()));
+            break;
+        case UartProtocol::InfoByte::RAW:
+            mode.raw[0] = readFloat(payload);
+            mode.raw[1] = readFloat(payload + 4);
+            break;
+        case UartProtocol::InfoByte::SI:
+            mode.si[0] = readFloat(payload);
+            mode.si[1] = readFloat(payload + 4);
+            break;
+        case UartProtocol::InfoByte::FORMAT:
+            mode.samples = payload[0];
+            mode.dataType = payload[1];
+            mode.figures = payload[2];
+            mode.decimals = payload[3];
+            mode.hasFormat = true;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    void printDescriptor(const SensorDescriptor& descriptor) {
+        static const char* const typeNames[] = { "DATA8", "DATA16", "DATA32", "DATAF" };
+
+        printf("type %u, %u modes, %u views, speed %u bps\n", descriptor.type, descriptor.modes, descriptor.views, descriptor.speed);
+        for (uint8_t i = 0; i < descriptor.modes && i < UartProtocol::MAX_MODES; ++i) {
+            const ModeInfo& mode = descriptor.mode[i];
+            printf("  %u %-12s raw %g..%g si %g..%g", i, mode.name.c_str(), mode.raw[0], mode.raw[1], mode.si[0], mode.si[1]);
+            if (mode.hasFormat) {
+                printf(" %u x %s, %u figures, %u decimals\n", mode.samples,
+                    mode.dataType < 4 ? typeNames[mode.dataType] : "?", mode.figures, mode.decimals);
+            } else {
+                printf(" no FORMAT\n");
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: brick <device> [mode] [seconds]\n");
+        return 2;
+    }
+    uint8_t selectedMode = argc > 2 ? uint8_t(atoi(argv[2])) : 0;
+    double seconds = argc > 3 ? atof(argv[3]) : 10;
+
+    SerialPort port;
+    if (!port.open(argv[1])) {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    clock_type::time_point start = clock_type::now();
+    MessageParser parser;
+    SensorDescriptor descriptor;
+    Message message;
+    unsigned long checksumErrors = 0;
+    unsigned long restarts = 0;
+    uint8_t buffer[256];
+
+    //The descriptor starts with TYPE message, the bytes before it are not the part of it
+    bool typeReceived = false;
+    bool acknowledged = false;
+    while (!acknowledged) {
+        if (clock_type::now() - start > std::chrono::milliseconds(HANDSHAKE_TIMEOUT)) {
+            fprintf(stderr, "The sensor has not sent the descriptor\n");
+            return 1;
+        }
+        int count = port.read(buffer, sizeof(buffer));
+        for (int i = 0; i < count && !acknowledged; ++i) {
+            if (!typeReceived) {
+                if (buffer[i] != ::ev3::EV3Command::CMD_TYPE)
+                    continue;
+                typeReceived = true;
+                parser.reset();
+            }
+            if (!parser.receive(buffer[i], message))
+                continue;
+            if (!message.valid) {
+                //The brick starts over on the error, the sensor restarts after the ACK timeout.
+                //The data frames of the previous connection may look like TYPE message.
+                ++restarts;
+                typeReceived = false;
+                descriptor = SensorDescriptor();
+            } else if (message.command() == UartProtocol::BYTE_ACK) {
+                acknowledged = descriptor.type != 0;
+            } else {
+                addInfo(message, descriptor);
+            }
+        }
+    }
+
+    port.writeByte(UartProtocol::BYTE_ACK);
+    clock_type::time_point ackTime = clock_type::now();
+    //The sensor switches the speed 10 ms after ACK
+    usleep(2000);
+    port.setSpeed(descriptor.speed);
+    parser.reset();
+
+    uint8_t select[3];
+    port.write(select, makeSelect(selectedMode, select));
+
+    clock_type::time_point firstData;
+    clock_type::time_point lastFrame;
+    clock_type::time_point lastKeepAlive = clock_type::now();
+    bool dataReceived = false;
+    unsigned long frames = 0;
+    unsigned long otherFrames = 0;
+    double intervalSum = 0;
+    double intervalSquares = 0;
+    double intervalMin = 0;
+    double intervalMax = 0;
+    clock_type::time_point end = clock_type::now() + std::chrono::microseconds(long(seconds * 1e6));
+
+    while (clock_type::now() < end) {
+        clock_type::time_point now = clock_type::now();
+        if (now - lastKeepAlive >= std::chrono::milliseconds(KEEP_ALIVE_PERIOD)) {
+            port.writeByte(UartProtocol::BYTE_NACK);
+            lastKeepAlive = now;
+        }
+
+        int count = port.read(buffer, sizeof(buffer));
+        now = clock_type::now();
+        for (int i = 0; i < count; ++i) {
+            if (!parser.receive(buffer[i], message))
+                continue;
+            if (!message.valid) {
+                ++checksumErrors;
+                //Resynchronizes on the next byte
+                parser.reset();
+                continue;
+            }
+            if (message.type() != UartProtocol::MESSAGE_DATA)
+                continue;
+            if (message.mode() != selectedMode) {
+                ++otherFrames;
+                continue;
+            }
+
+            if (!dataReceived) {
+                dataReceived = true;
+                firstData = now;
+            } else {
+                double interval = std::chrono::duration<double, std::micro>(now - lastFrame).count();
+                if (frames == 1 || interval < intervalMin)
+                    intervalMin = interval;
+                if (interval > intervalMax)
+                    intervalMax = interval;
+                intervalSum += interval;
+                intervalSquares += interval * interval;
+            }
+            lastFrame = now;
+            ++frames;
+        }
+    }
+
+    printDescriptor(descriptor);
+    printf("%lu descriptor restarts\n", restarts);
+    if (!dataReceived) {
+        printf("no DATA of mode %u, %lu frames of other modes, %lu checksum errors\n", selectedMode, otherFrames, checksumErrors);
+        return 1;
+    }
+
+    double duration = std::chrono::duration<double>(lastFrame - firstData).count();
+    unsigned long intervals = frames - 1;
+    double mean = intervals != 0 ? intervalSum / intervals : 0;
+    double deviation = intervals != 0 ? sqrt(intervalSquares / intervals - mean * mean) : 0;
+    printf("first DATA of mode %u: %.1f ms from the start, %.1f ms from ACK\n", selectedMode,
+        milliseconds(firstData - start), milliseconds(firstData - ackTime));
+    printf("%lu frames, %.1f frames/s, %lu frames of other modes, %lu checksum errors\n",
+        frames, duration > 0 ? intervals / duration : 0.0, otherFrames, checksumErrors);
+    printf("frame interval %.1f us mean, %.1f us deviation, %.1f..%.1f us\n", mean, deviation, intervalMin, intervalMax);
+    return 0;
+}
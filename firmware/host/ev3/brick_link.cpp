@@ -0,0 +1,86 @@
+#include "brick_link.h"
+
+#include <thread>
+
+namespace host {
+namespace ev3 {
+
+    //std::chrono::milliseconds takes the period by reference
+    const unsigned BrickLink::KEEP_ALIVE_PERIOD;
+
+    BrickLink::BrickLink(UartModel& uart_)
+        : uart(uart_), lastKeepAlive(clock_type::now()), dataFrames(0), checksumErrors(0)
+    {
+    }
+
+    void BrickLink::send(const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            uart.receive(data[i]);
+        }
+    }
+
+    bool BrickLink::connect(unsigned timeout) {
+        clock_type::time_point deadline = clock_type::now() + std::chrono::milliseconds(timeout);
+        while (clock_type::now() < deadline) {
+            uint8_t byte;
+            if (!uart.transmit(byte)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+
+            Message received;
+            if (parser.receive(byte, received) && received.command() == UartProtocol::BYTE_ACK) {
+                uint8_t ack = UartProtocol::BYTE_ACK;
+                send(&ack, 1);
+                //The sensor waits 10 ms before it starts at the new speed
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                lastKeepAlive = clock_type::now();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void BrickLink::select(uint8_t mode) {
+        uint8_t data[3];
+        send(data, makeSelect(mode, data));
+    }
+
+    void BrickLink::write(const uint8_t* data, uint8_t size) {
+        uint8_t buffer[UartProtocol::UART_DATA_LENGTH + 2];
+        send(buffer, makeWrite(data, size, buffer));
+    }
+
+    unsigned BrickLink::poll() {
+        unsigned count = 0;
+        uint8_t byte;
+        while (uart.transmit(byte)) {
+            if (receive(byte))
+                ++count;
+        }
+        keepAlive();
+        return count;
+    }
+
+    bool BrickLink::receive(uint8_t byte) {
+        if (!parser.receive(byte, message))
+            return false;
+
+        if (!message.valid) {
+            ++checksumErrors;
+        } else if (message.type() == UartProtocol::MESSAGE_DATA) {
+            ++dataFrames;
+        }
+        return true;
+    }
+
+    void BrickLink::keepAlive() {
+        clock_type::time_point now = clock_type::now();
+        if (now - lastKeepAlive >= std::chrono::milliseconds(KEEP_ALIVE_PERIOD)) {
+            uint8_t nack = UartProtocol::BYTE_NACK;
+            send(&nack, 1);
+            lastKeepAlive = now;
+        }
+    }
+}
+}
@@ -0,0 +1,66 @@
+#ifndef __HOST_EV3_BRICK_LINK_H
+#define __HOST_EV3_BRICK_LINK_H
+
+#include <stdint.h>
+#include <chrono>
+
+#include "ev3_protocol.h"
+#include <model/uart_model.h>
+
+namespace host {
+namespace ev3 {
+
+    //Plays the EV3 brick on the UART model in the same process.
+    //The bytes are taken from the sensor as soon as it sends them, so the link
+    //measures the firmware, not the line speed.
+    class BrickLink {
+    public:
+        typedef std::chrono::steady_clock clock_type;
+
+        //The sensor restarts if the brick is silent for 1000 ms
+        static const unsigned KEEP_ALIVE_PERIOD = 200; //ms
+
+    private:
+        UartModel& uart;
+        MessageParser parser;
+        Message message;
+        clock_type::time_point lastKeepAlive;
+
+        unsigned long dataFrames;
+        unsigned long checksumErrors;
+
+        void send(const uint8_t* data, size_t size);
+
+    public:
+        explicit BrickLink(UartModel& uart);
+
+        //Waits for the sensor ACK, answers it and waits for the speed switch.
+        //Returns false if the sensor has not finished the handshake within the timeout.
+        bool connect(unsigned timeout); //ms
+
+        //Sends SELECT command
+        void select(uint8_t mode);
+
+        //Sends WRITE command
+        void write(const uint8_t* data, uint8_t size);
+
+        //Takes all bytes the sensor has to send and sends NACK when it is due.
+        //Returns the number of the complete messages, the last one is available by getMessage.
+        unsigned poll();
+
+        //Passes the byte the sensor has sent. Returns true if the byte completes the message.
+        //It is used by the drivers that pace the transmitter themselves.
+        bool receive(uint8_t byte);
+
+        //Sends NACK if it is due
+        void keepAlive();
+
+        const Message& getMessage() const { return message; }
+
+        unsigned long getDataFrames() const { return dataFrames; }
+        unsigned long getChecksumErrors() const { return checksumErrors; }
+    };
+}
+}
+
+#endif //__HOST_EV3_BRICK_LINK_H
@@ -0,0 +1,66 @@
+#include "ev3_protocol.h"
+
+#include <string.h>
+
+namespace host {
+namespace ev3 {
+
+    uint8_t checksum(const uint8_t* data, size_t size) {
+        uint8_t result = 0xFF;
+        for (size_t i = 0; i < size; ++i) {
+            result ^= data[i];
+        }
+        return result;
+    }
+
+    bool MessageParser::receive(uint8_t byte, Message& message) {
+        if (current.size == 0) {
+            switch (UartProtocol::getMessageType(byte)) {
+            case UartProtocol::MESSAGE_SYS:
+                message.data[0] = byte;
+                message.size = 1;
+                message.valid = true;
+                return true;
+
+            case UartProtocol::MESSAGE_INFO:
+                expected = uint8_t(UartProtocol::getMessageLength(byte) + 3);
+                break;
+
+            default:
+                expected = uint8_t(UartProtocol::getMessageLength(byte) + 2);
+                break;
+            }
+        }
+
+        current.data[current.size++] = byte;
+        if (current.size < expected)
+            return false;
+
+        current.valid = checksum(current.data, current.size - 1) == current.data[current.size - 1];
+        message = current;
+        current.size = 0;
+        return true;
+    }
+
+    size_t makeSelect(uint8_t mode, uint8_t* out) {
+        out[0] = ::ev3::EV3Command::CMD_SELECT;
+        out[1] = mode;
+        out[2] = checksum(out, 2);
+        return 3;
+    }
+
+    size_t makeWrite(const uint8_t* data, uint8_t size, uint8_t* out) {
+        uint8_t length = 0;
+        while ((1 << length) < size) {
+            ++length;
+        }
+        uint8_t payload = uint8_t(1 << length);
+
+        out[0] = UartProtocol::makeCommandMessage(UartProtocol::CMD_WRITE, length);
+        memset(out + 1, 0, payload);
+        memcpy(out + 1, data, size);
+        out[payload + 1] = checksum(out, payload + 1);
+        return payload + 2;
+    }
+}
+}
@@ -0,0 +1,64 @@
+#ifndef __HOST_EV3_PROTOCOL_H
+#define __HOST_EV3_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ev3/ev3_uart.h>
+
+namespace host {
+namespace ev3 {
+
+    using ::ev3::UartProtocol;
+
+    //Message received from the sensor
+    struct Message {
+        //The longest one is INFO: command, info type, 32 bytes of payload and checksum
+        static const uint8_t MAX_SIZE = UartProtocol::UART_DATA_LENGTH + 3;
+
+        uint8_t data[MAX_SIZE];
+        uint8_t size;
+        //The checksum matches the content. The single byte system messages do not have it.
+        bool valid;
+
+        uint8_t command() const { return data[0]; }
+        uint8_t type() const { return UartProtocol::getMessageType(data[0]); }
+        //Mode of INFO and DATA messages
+        uint8_t mode() const { return data[0] & 0x07; }
+        //Payload of the message, INFO payload follows the info type byte
+        const uint8_t* payload() const { return data + (type() == UartProtocol::MESSAGE_INFO ? 2 : 1); }
+        uint8_t payloadSize() const { return UartProtocol::getMessageLength(data[0]); }
+    };
+
+    //Splits the byte stream from the sensor into messages (see ev3/ev3_uart.h)
+    class MessageParser {
+    private:
+        Message current;
+        uint8_t expected;
+
+    public:
+        MessageParser()
+            : expected(0)
+        {
+            current.size = 0;
+        }
+
+        void reset() {
+            current.size = 0;
+            expected = 0;
+        }
+
+        //Returns true and fills the message when the byte completes it
+        bool receive(uint8_t byte, Message& message);
+    };
+
+    //Calculates the check byte of the message
+    uint8_t checksum(const uint8_t* data, size_t size);
+
+    //Builders of the host messages. They return the message size.
+    size_t makeSelect(uint8_t mode, uint8_t* out);
+    //The payload is padded by zeros to the power of 2 size
+    size_t makeWrite(const uint8_t* data, uint8_t size, uint8_t* out);
+}
+}
+
+#endif //__HOST_EV3_PROTOCOL_H
@@ -0,0 +1,206 @@
+//Runs the LSM6DS3 sample pipeline for the data ready events and reports the time per sample.
+//
+//  benchmark [samples] [mode]
+//
+//The brick side connects to the sensor, selects the mode (IMU-ALL by default) and then
+//raises the gyro data ready interrupt with the new sample in the register model.
+//The next interrupt is raised when the sensor has processed the previous one and the frame
+//has been sent, so each event produces one sample, the same as the sensor that keeps up with the ODR.
+//
+//The profiler build (PROFILER_ENABLED=1) reports the stages of the pipeline (utils/profiler.h).
+//The stage times are in PROFILER_HOST_TICK_NS units, the readme uses 1 ns.
+//
+//The critical sections (TCritSect of the shim) are counted and timed in all builds,
+//it is the code the MCU runs with the interrupts disabled. The time of an empty section
+//is measured at the start and subtracted, it is the host clock overhead.
+
+#include "sensor.h"
+#include <ev3/brick_link.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+using namespace host::lsm6ds3;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    //The profiler counters are 16-bit, so the records are collected in batches
+    static const unsigned long PROFILE_BATCH = 50000;
+
+    static const unsigned long WARM_UP = 1000;
+
+    struct StageTotal {
+        unsigned long long count;
+        unsigned long long total;
+        unsigned min;
+        unsigned max;
+    };
+
+    StageTotal stages[utils::PROFILE_STAGE_COUNT];
+
+    //The critical sections of the data ready interrupt, they are the part of the interrupt ones
+    host::CriticalSections dataReadySections;
+
+    const char* const stageNames[utils::PROFILE_STAGE_COUNT] = {
+        "queue pop",
+        "spi read",
+        "transform",
+        "frame queued",
+        "tx done"
+    };
+
+    //Adds the profiler records to the totals and restarts the profiler
+    void collectProfile() {
+#if PROFILER_ENABLED
+        for (uint8_t i = 0; i < utils::PROFILE_STAGE_COUNT; ++i) {
+            utils::ProfileRecord record;
+            PROFILE_READ(i, &record);
+            if (record.count == 0)
+                continue;
+
+            StageTotal& stage = stages[i];
+            if (stage.count == 0 || record.min < stage.min)
+                stage.min = record.min;
+            if (record.max > stage.max)
+                stage.max = record.max;
+            stage.count += record.count;
+            stage.total += (unsigned long long)record.average * record.count;
+        }
+        OS::Interrupt cpu;
+        utils::ProfilerInstance<void>::profiler = utils::Profiler();
+#endif
+    }
+
+    //Average time of an empty critical section, ns
+    double measureCriticalOverhead() {
+        static const unsigned long COUNT = 100000;
+        OS::Interrupt cpu;
+        host::resetCriticalSections();
+        for (unsigned long i = 0; i < COUNT; ++i) {
+            TCritSect cs;
+        }
+        double overhead = double(host::getCriticalSections(false).time) / COUNT;
+        host::resetCriticalSections();
+        return overhead;
+    }
+
+    void printCriticalSections(const char* name, const host::CriticalSections& sections, unsigned long samples, double overhead) {
+        double time = double(sections.time) - overhead * sections.count;
+        if (time < 0)
+            time = 0;
+        printf("%-10s %10lu %12.2f %12.1f %10.0f\n", name, sections.count,
+            samples != 0 ? double(sections.count) / samples : 0.0,
+            samples != 0 ? time / samples : 0.0, double(sections.maxTime) - overhead);
+    }
+
+    //Raises the gyro data ready interrupt and waits until the sensor has sent the sample
+    void runSample(host::ev3::BrickLink& link, unsigned long index) {
+        int16_t gyro[3] = { int16_t(index), int16_t(-int16_t(index)), int16_t(index * 7) };
+        int16_t accel[3] = { int16_t(index * 3), int16_t(index * 5), 16384 };
+        uint16_t processed = processedSamples();
+        {
+            OS::Interrupt cpu;
+            device.setGyroSample(gyro);
+            device.setAccelSample(accel);
+
+            host::CriticalSections before = host::getCriticalSections(false);
+            gyroDataReady();
+            const host::CriticalSections& after = host::getCriticalSections(false);
+            dataReadySections.count += after.count - before.count;
+            dataReadySections.time += after.time - before.time;
+            if (after.time - before.time > dataReadySections.maxTime)
+                dataReadySections.maxTime = after.time - before.time;
+        }
+        //The firmware that sends the frame by the blocking call waits for the brick to take the bytes
+        while (processedSamples() == processed) {
+            link.poll();
+            std::this_thread::yield();
+        }
+        link.poll();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long samples = argc > 1 ? strtoul(argv[1], 0, 0) : 2000000;
+    uint8_t mode = argc > 2 ? uint8_t(atoi(argv[2])) : 0;
+
+    double overhead = measureCriticalOverhead();
+
+    init();
+    OS::run();
+
+    host::ev3::BrickLink link(uart);
+    if (!link.connect(5000)) {
+        fprintf(stderr, "The sensor has not finished the handshake\n");
+        return 1;
+    }
+    printf("connected at %u bps\n", unsigned(uart.getSpeed()));
+
+    if (mode != 0)
+        link.select(mode);
+
+    for (unsigned long i = 0; i < WARM_UP; ++i) {
+        runSample(link, i);
+    }
+    collectProfile();
+    for (uint8_t i = 0; i < utils::PROFILE_STAGE_COUNT; ++i) {
+        stages[i] = StageTotal();
+    }
+
+    unsigned long switches;
+    {
+        OS::Interrupt cpu;
+        host::resetCriticalSections();
+        dataReadySections = host::CriticalSections();
+        switches = host::getContextSwitches();
+    }
+
+    unsigned long frames = link.getDataFrames();
+    clock_type::time_point start = clock_type::now();
+    for (unsigned long i = 0; i < samples; ++i) {
+        runSample(link, i);
+        if ((i + 1) % PROFILE_BATCH == 0)
+            collectProfile();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    collectProfile();
+
+    frames = link.getDataFrames() - frames;
+    printf("mode %u: %lu samples, %lu frames, %lu checksum errors\n", unsigned(mode), samples, frames, link.getChecksumErrors());
+    printf("%.0f ns per sample including the host thread switches\n", samples != 0 ? elapsed / samples : 0.0);
+    {
+        OS::Interrupt cpu;
+        switches = host::getContextSwitches() - switches;
+    }
+    printf("%.2f context switches per sample, %.0f per second at 1660 Hz ODR\n",
+        samples != 0 ? double(switches) / samples : 0.0, samples != 0 ? double(switches) / samples * 1660 : 0.0);
+
+    printf("%-10s %10s %12s %12s %10s (empty section %.1f ns subtracted)\n", "critical", "count", "per sample",
+        "ns/sample", "max ns", overhead);
+    {
+        OS::Interrupt cpu;
+        printCriticalSections("interrupt", host::getCriticalSections(false), samples, overhead);
+        printCriticalSections("data ready", dataReadySections, samples, overhead);
+        printCriticalSections("process", host::getCriticalSections(true), samples, overhead);
+    }
+
+#if PROFILER_ENABLED
+    printf("%-14s %10s %8s %8s %8s (ticks of %d ns)\n", "stage", "count", "min", "average", "max", PROFILER_HOST_TICK_NS);
+    for (uint8_t i = 0; i < utils::PROFILE_STAGE_COUNT; ++i) {
+        const StageTotal& stage = stages[i];
+        printf("%-14s %10llu %8u %8llu %8u\n", stageNames[i], stage.count, stage.min,
+            stage.count != 0 ? stage.total / stage.count : 0ULL, stage.max);
+    }
+    //Each sample passes all stages, the stage without records is not instrumented
+    for (uint8_t i = 0; i < utils::PROFILE_STAGE_COUNT; ++i) {
+        if (stages[i].count == 0) {
+            fprintf(stderr, "The %s stage has no records\n", stageNames[i]);
+            return 1;
+        }
+    }
+#endif
+    return 0;
+}
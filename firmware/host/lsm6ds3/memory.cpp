@@ -0,0 +1,35 @@
+//Prints the RAM taken by the LSM6DS3 sensor object and its parts.
+//
+//It is the estimate for the builds without the IAR map file (see service/Benchmark MemoryUsage).
+//The program is built with -fpack-struct=1 -fshort-enums, so the members are not aligned
+//and the enums take the smallest type like on STM8. The host pointers take 8 bytes instead of 2.
+//The process stacks, the idle process stack and CSTACK are set in main.cpp, scmRTOS_CONFIG.h
+//and the project file, they are not included.
+
+#include "sensor.h"
+
+#include <stdio.h>
+
+using namespace host::lsm6ds3;
+
+namespace {
+    typedef imu_type<sensor_type> sensor_imu_type;
+    typedef imu_core_type<sensor_imu_type> sensor_core_type;
+
+    void print(const char* name, size_t size) {
+        printf("%-24s %5u\n", name, unsigned(size));
+    }
+}
+
+int main() {
+    print("sensor", sizeof(sensor_type));
+    print("  uart", sizeof(uart_type));
+    print("  imu commands and stats", sizeof(sensor_imu_type) - sizeof(sensor_core_type));
+    print("  imu core", sizeof(sensor_core_type));
+    print("  frames and state", sizeof(sensor_type) - sizeof(sensor_imu_type) - sizeof(uart_type));
+#if PROFILER_ENABLED
+    print("profiler", sizeof(utils::ProfilerInstance<void>::profiler));
+#endif
+    print("eeprom (not RAM)", sizeof(eeprom_type));
+    return 0;
+}
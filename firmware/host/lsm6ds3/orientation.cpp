@@ -0,0 +1,136 @@
+//Checks the accuracy of the orientation filter of IMU-QUAT mode against the exact rotation.
+//
+//  orientation [gyro range] [accel range] [rate] [seconds]
+//
+//The ranges and the rate are the arguments of math::OrientationFilter::configure:
+//the gyro full scale is 125dps * 2^range, the accel full scale is 2g * 2^range,
+//the sample rate is 13Hz * 2^rate. The defaults are 245 dps, 2g and 416 Hz for 120 seconds.
+//
+//The device starts tilted by 20 degrees and rotates about all axes up to 1.5 rad/s.
+//The gyro samples have +-3 digits of noise, the accel samples have +-10 digits at 2g.
+//The filter takes the same samples in MCU byte order as the firmware, the reference quaternion
+//is integrated exactly. The tilt error is the angle between the gravity vectors of the filter
+//and the reference, the first 5 seconds of the settling are excluded from the statistics.
+
+#include <math/fusion.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+    static const double PI = 3.14159265358979323846;
+    static const double DEGREE = PI / 180;
+    //The filter aligns with the gravity during the settling
+    static const double SETTLING_TIME = 5;
+    //The gyro full scales of LSM6DS3 for each range
+    static const unsigned GYRO_SCALES[] = {125, 245, 500, 1000, 2000};
+
+    struct Quaternion {
+        double w, x, y, z;
+    };
+
+    Quaternion multiply(const Quaternion& a, const Quaternion& b) {
+        Quaternion result = {
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+        };
+        return result;
+    }
+
+    //The gravity direction in the device frame
+    void gravity(const Quaternion& q, double (&g)[3]) {
+        g[0] = 2 * (q.x * q.z - q.w * q.y);
+        g[1] = 2 * (q.w * q.x + q.y * q.z);
+        g[2] = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+    }
+
+    //Rotates the orientation by the angular rate during the time step
+    void rotate(Quaternion& q, const double (&rate)[3], double step) {
+        double norm = sqrt(rate[0] * rate[0] + rate[1] * rate[1] + rate[2] * rate[2]);
+        Quaternion delta = {cos(norm * step / 2), 0, 0, 0};
+        if (norm > 0) {
+            double scale = sin(norm * step / 2) / norm;
+            delta.x = rate[0] * scale;
+            delta.y = rate[1] * scale;
+            delta.z = rate[2] * scale;
+        }
+        q = multiply(q, delta);
+    }
+
+    //Returns the angle between the gravity vectors in degrees
+    double tiltError(const Quaternion& estimate, const Quaternion& reference) {
+        double e[3], r[3];
+        gravity(estimate, e);
+        gravity(reference, r);
+        double cosine = (e[0] * r[0] + e[1] * r[1] + e[2] * r[2]) / sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+        return acos(cosine > 1 ? 1 : cosine) / DEGREE;
+    }
+
+    int noise(int range) {
+        return rand() % (2 * range + 1) - range;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint8_t gyroRange = uint8_t(argc > 1 ? atoi(argv[1]) : 1);
+    uint8_t accelRange = uint8_t(argc > 2 ? atoi(argv[2]) : 0);
+    uint8_t rate = uint8_t(argc > 3 ? atoi(argv[3]) : 5);
+    double seconds = argc > 4 ? atof(argv[4]) : 120;
+
+    if (gyroRange > math::OrientationFilter::MAX_GYRO_RANGE || accelRange > math::OrientationFilter::MAX_ACCEL_RANGE ||
+        rate < math::OrientationFilter::MIN_RATE || rate > 7) {
+        fprintf(stderr, "The gyro range is 0..%u, the accel range is 0..%u, the rate is %u..7\n",
+            math::OrientationFilter::MAX_GYRO_RANGE, math::OrientationFilter::MAX_ACCEL_RANGE, math::OrientationFilter::MIN_RATE);
+        return 1;
+    }
+
+    double frequency = 13.0 * (1 << rate);
+    double step = 1 / frequency;
+    //The nominal sensitivities of LSM6DS3: 4.375 mdps per digit at 125 dps, 16384 digits per g at 2g
+    double gyroDigit = 4.375e-3 * (1 << gyroRange) * DEGREE;
+    double accelDigits = 16384 >> accelRange;
+
+    math::OrientationFilter filter;
+    filter.configure(gyroRange, accelRange, rate);
+    filter.reset();
+
+    Quaternion reference = {cos(10 * DEGREE), sin(10 * DEGREE), 0, 0};
+    srand(1);
+
+    long samples = long(seconds * frequency);
+    long measured = 0;
+    double maxError = 0;
+    double sumError = 0;
+    for (long n = 0; n < samples; ++n) {
+        double time = n * step;
+        double angularRate[3] = {0.8 * sin(0.5 * time), 0.6 * cos(0.3 * time), 1.5 * sin(0.2 * time)};
+
+        double g[3];
+        gravity(reference, g);
+        int16_t gyro[3], accel[3];
+        for (uint8_t i = 0; i < 3; ++i) {
+            gyro[i] = int16_t(lround(angularRate[i] / gyroDigit + noise(3)));
+            accel[i] = int16_t(lround(g[i] * accelDigits + noise(10) / double(1 << accelRange)));
+        }
+        filter.update(gyro, accel);
+        rotate(reference, angularRate, step);
+
+        int16_t q[math::OrientationFilter::SIZE];
+        filter.getQuaternion(q);
+        Quaternion estimate = {q[0] / 16384.0, q[1] / 16384.0, q[2] / 16384.0, q[3] / 16384.0};
+        double error = tiltError(estimate, reference);
+        if (time > SETTLING_TIME) {
+            if (error > maxError)
+                maxError = error;
+            sumError += error;
+            ++measured;
+        }
+    }
+
+    printf("%.0f Hz, gyro %u dps, accel %ug, %.0f s: tilt error max %.3f deg, mean %.3f deg\n", frequency,
+        GYRO_SCALES[gyroRange], 2u << accelRange, seconds, maxError, measured != 0 ? sumError / measured : 0.0);
+    return 0;
+}
@@ -0,0 +1,149 @@
+//Runs the LSM6DS3 sensor firmware on a pseudo terminal, so a brick emulator
+//(ev3/brick.cpp) or any other program can talk to Ev3UartSensor as to the real device.
+//
+//  pty_sensor [seconds]
+//
+//It prints the name of the terminal and runs for the time, 60 seconds by default.
+//The pseudo terminal has no line speed, the transmitter sends the bytes at the byte time
+//of the speed the firmware has set in the UART registers. The chip model produces the samples
+//at the configured ODR in real time, the samples are a slow rotation around Z axis.
+
+#include "sensor.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace host::lsm6ds3;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    //The period of the chip clock updates
+    static const unsigned CHIP_STEP = 100; //us
+    //The transmitter is polled when it is idle
+    static const unsigned TX_POLL = 20; //us
+
+    class RotationSource : public host::SampleSource {
+    private:
+        unsigned long count;
+
+    public:
+        RotationSource()
+            : count(0)
+        {
+        }
+
+        virtual void nextGyro(int16_t (&sample)[3]) {
+            ++count;
+            sample[0] = 0;
+            sample[1] = 0;
+            sample[2] = int16_t(2000 * sin(count * 0.001));
+        }
+
+        virtual void nextAccel(int16_t (&sample)[3]) {
+            sample[0] = 0;
+            sample[1] = 0;
+            sample[2] = 16384;
+        }
+    };
+
+    RotationSource rotation;
+    volatile bool running = true;
+    int terminal = -1;
+
+    //Passes the bytes of the brick to the receiver
+    void receiveLoop() {
+        while (running) {
+            uint8_t buffer[64];
+            ssize_t count = read(terminal, buffer, sizeof(buffer));
+            if (count <= 0) {
+                //EIO while no program keeps the other side open
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            for (ssize_t i = 0; i < count; ++i) {
+                uart.receive(buffer[i]);
+            }
+        }
+    }
+
+    //Sends the bytes of the transmitter at the line speed
+    void transmitLoop() {
+        clock_type::time_point next = clock_type::now();
+        while (running) {
+            uint8_t byte;
+            if (!uart.transmit(byte)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(TX_POLL));
+                continue;
+            }
+            if (write(terminal, &byte, 1) != 1) {
+                //The bytes are lost while the other side is closed
+            }
+
+            clock_type::time_point now = clock_type::now();
+            if (next < now)
+                next = now;
+            next += std::chrono::nanoseconds(uart.byteTime());
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    //Moves the chip clock in real time
+    void chipLoop() {
+        clock_type::time_point start = clock_type::now();
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::microseconds(CHIP_STEP));
+            uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+            OS::Interrupt cpu;
+            device.advance(time);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 60;
+
+    terminal = posix_openpt(O_RDWR | O_NOCTTY);
+    if (terminal < 0 || grantpt(terminal) != 0 || unlockpt(terminal) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+
+    //The other side is raw, so the line discipline does not change the bytes
+    const char* name = ptsname(terminal);
+    int other = open(name, O_RDWR | O_NOCTTY);
+    termios settings;
+    if (other < 0 || tcgetattr(other, &settings) != 0) {
+        perror(name);
+        return 1;
+    }
+    cfmakeraw(&settings);
+    tcsetattr(other, TCSANOW, &settings);
+    printf("%s\n", name);
+    fflush(stdout);
+
+    init(&rotation);
+    OS::run();
+
+    std::thread receiver(receiveLoop);
+    std::thread transmitter(transmitLoop);
+    std::thread chip(chipLoop);
+
+    std::this_thread::sleep_for(std::chrono::microseconds(long(seconds * 1e6)));
+    running = false;
+    receiver.detach();
+    transmitter.join();
+    chip.join();
+    close(other);
+
+    //The host scheduler may delay the chip clock thread, then the samples are overwritten
+    printf("%lu gyro samples overwritten before they have been read\n", device.getOverruns());
+    return 0;
+}
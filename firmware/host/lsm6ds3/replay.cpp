@@ -0,0 +1,376 @@
+//Replays the recorded sensor traces through the firmware at the chip output data rates.
+//
+//  replay [results directory] [cpu time per sample, us]
+//
+//The directory has the calibration results of software/service/Calibration:
+//Gyroscope/test1/w[N].txt and Accelerometer/test1/w[N].txt, each line is "x,y,z,1.0," of raw counts.
+//Each pair of the traces is replayed at the rates selected by the host commands: in IMU-ALL mode
+//at 416, 833 and 1660 Hz and in IMU-ACC mode at 3330 and 6660 Hz, the gyroscope stops at 1660 Hz.
+//The table shows the samples of the sensor that sends the frames: the gyroscope or the accelerometer.
+//The build with EV3_DECIMATION_FACTOR=N sends a frame per N samples, the average of them.
+//
+//The time is virtual. The chip model takes the trace samples at its ODR, the UART sends
+//a byte per byte time of the selected speed. The firmware runs when the data ready line rises
+//and the CPU is free, the optional CPU time per sample keeps it busy after each sample,
+//the chip overwrites the samples that have not been read during that time.
+
+#include "sensor.h"
+#include <ev3/brick_link.h>
+#include <imu_commands.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+using namespace host::lsm6ds3;
+
+namespace {
+    typedef ev3::lsm6ds3::Commands commands_type;
+
+    static const unsigned TRACE_COUNT = 4;
+    static const uint64_t NEVER = host::Lsm6ds3Model::NEVER;
+
+    //IMU-ALL frame has the accelerometer and gyroscope samples, IMU-ACC frame has the accelerometer one.
+    //The words are in the little-endian order.
+    static const uint8_t MODE_ALL = 0;
+    static const uint8_t MODE_ACCEL = 1;
+    static const uint8_t GYRO_OFFSET = 3;
+
+    struct Rate {
+        unsigned hz;
+        //IMU-ALL sends a frame per gyro sample, IMU-ACC per accelerometer sample
+        uint8_t mode;
+        uint8_t accelCommand;
+        uint8_t gyroCommand;
+    };
+
+    const Rate rates[] = {
+        { 416,  MODE_ALL,   commands_type::ACC_ODR_416HZ,  commands_type::GYRO_ODR_416HZ },
+        { 833,  MODE_ALL,   commands_type::ACC_ODR_833HZ,  commands_type::GYRO_ODR_833HZ },
+        { 1660, MODE_ALL,   commands_type::ACC_ODR_1660HZ, commands_type::GYRO_ODR_1660HZ },
+        { 3330, MODE_ACCEL, commands_type::ACC_ODR_3330HZ, commands_type::GYRO_ODR_1660HZ },
+        { 6660, MODE_ACCEL, commands_type::ACC_ODR_6660HZ, commands_type::GYRO_ODR_1660HZ }
+    };
+
+    typedef std::vector<int16_t> Trace;
+
+    //Reads "x,y,z,..." lines
+    bool loadTrace(const std::string& path, Trace& trace) {
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == 0)
+            return false;
+
+        trace.clear();
+        char line[128];
+        while (fgets(line, sizeof(line), file) != 0) {
+            double x, y, z;
+            if (sscanf(line, "%lf,%lf,%lf", &x, &y, &z) == 3) {
+                trace.push_back(int16_t(x));
+                trace.push_back(int16_t(y));
+                trace.push_back(int16_t(z));
+            }
+        }
+        fclose(file);
+        return !trace.empty();
+    }
+
+    //Plays the traces in a loop
+    class TraceSource : public host::SampleSource {
+    private:
+        const Trace& gyro;
+        const Trace& accel;
+        size_t gyroPosition;
+        size_t accelPosition;
+
+        static void next(const Trace& trace, size_t& position, int16_t (&sample)[3]) {
+            for (uint8_t i = 0; i < 3; ++i) {
+                sample[i] = trace[position + i];
+            }
+            position += 3;
+            if (position >= trace.size())
+                position = 0;
+        }
+
+    public:
+        //The samples of the sensor that sends the frames
+        const bool accelFrames;
+        unsigned long samples;
+        int64_t sum[3];
+
+        TraceSource(const Trace& gyro_, const Trace& accel_, bool accelFrames_)
+            : gyro(gyro_), accel(accel_), gyroPosition(0), accelPosition(0), accelFrames(accelFrames_), samples(0)
+        {
+            sum[0] = sum[1] = sum[2] = 0;
+        }
+
+        void count(const int16_t (&sample)[3]) {
+            ++samples;
+            for (uint8_t i = 0; i < 3; ++i) {
+                sum[i] += sample[i];
+            }
+        }
+
+        virtual void nextGyro(int16_t (&sample)[3]) {
+            next(gyro, gyroPosition, sample);
+            if (!accelFrames)
+                count(sample);
+        }
+
+        virtual void nextAccel(int16_t (&sample)[3]) {
+            next(accel, accelPosition, sample);
+            if (accelFrames)
+                count(sample);
+        }
+    };
+
+    TraceSource* source = 0;
+
+    //The chip data ready lines. The firmware takes the interrupt when the CPU is free.
+    bool gyroLine = false;
+    bool accelLine = false;
+    uint64_t lineTime = NEVER;
+
+    void raiseGyro() {
+        gyroLine = true;
+        if (lineTime == NEVER)
+            lineTime = device.getTime();
+    }
+
+    void raiseAccel() {
+        accelLine = true;
+        if (lineTime == NEVER)
+            lineTime = device.getTime();
+    }
+
+    //Proxy that keeps the chip model the same for the handshake and the replay
+    class Source : public host::SampleSource {
+    public:
+        virtual void nextGyro(int16_t (&sample)[3]) {
+            if (source != 0) {
+                source->nextGyro(sample);
+            } else {
+                sample[0] = sample[1] = sample[2] = 0;
+            }
+        }
+
+        virtual void nextAccel(int16_t (&sample)[3]) {
+            if (source != 0) {
+                source->nextAccel(sample);
+            } else {
+                sample[0] = sample[1] = sample[2] = 0;
+            }
+        }
+    };
+
+    Source proxy;
+
+    //State of the firmware after the data event
+    enum FirmwareState {
+        Processed,
+        //The firmware that sends the frame by the blocking call waits for the transmitter
+        Blocked,
+        Stopped
+    };
+
+    //Waits until the firmware processes the data event or waits for the transmitter
+    FirmwareState waitProcessed(uint16_t processed) {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        for (;;) {
+            bool waiting;
+            {
+                OS::Interrupt cpu;
+                waiting = isSensorWaiting();
+            }
+            //The process counts the event before it waits for the next one
+            if (processedSamples() != processed)
+                return Processed;
+            if (waiting)
+                return Blocked;
+            if (std::chrono::steady_clock::now() > deadline)
+                return Stopped;
+            std::this_thread::yield();
+        }
+    }
+
+    //Moves the chip time until the end of the trace. It should be called with the CPU lock held.
+    void advance(const TraceSource& trace, size_t length, uint64_t time) {
+        while (trace.samples < length && device.getNextSample() <= time) {
+            device.advance(device.getNextSample());
+        }
+        if (trace.samples < length)
+            device.advance(time);
+    }
+
+    unsigned long getOverruns(const TraceSource& trace) {
+        return trace.accelFrames ? device.getAccelOverruns() : device.getOverruns();
+    }
+
+    //Sends the command and gives the firmware the time to apply it
+    void sendCommand(host::ev3::BrickLink& link, uint8_t command) {
+        link.write(&command, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    struct Result {
+        unsigned long samples;
+        unsigned long overwritten;
+        unsigned long frames;
+        unsigned long checksumErrors;
+        double seconds;
+        double input[3];
+        double output[3];
+    };
+
+    //Replays the trace for its length at the rate. Returns false if the firmware has stopped.
+    bool replay(host::ev3::BrickLink& link, const Rate& rate, TraceSource& trace, size_t length, uint64_t cpuTime, Result& result) {
+        link.select(rate.mode);
+        sendCommand(link, rate.accelCommand);
+        sendCommand(link, rate.gyroCommand);
+        {
+            OS::Interrupt cpu;
+            source = &trace;
+        }
+
+        uint64_t start = device.getTime();
+        uint64_t busyUntil = start;
+        uint64_t txDone = NEVER;
+        uint8_t txByte = 0;
+        unsigned long frames = link.getDataFrames();
+        unsigned long errors = link.getChecksumErrors();
+        unsigned long overruns = getOverruns(trace);
+        unsigned long outputs = 0;
+        int64_t outputSum[3] = {0, 0, 0};
+        bool ok = true;
+        //The firmware waits for the transmitter inside the data event, it does not take the interrupts
+        bool blocked = false;
+        uint16_t processed = 0;
+
+        for (unsigned long step = 0; ok; ++step) {
+            uint64_t sampleTime = trace.samples < length ? device.getNextSample() : NEVER;
+            uint64_t interruptTime = lineTime != NEVER && !blocked ? (lineTime > busyUntil ? lineTime : busyUntil) : NEVER;
+
+            if (interruptTime != NEVER && interruptTime <= sampleTime && interruptTime <= txDone) {
+                processed = processedSamples();
+                {
+                    OS::Interrupt cpu;
+                    advance(trace, length, interruptTime);
+                    if (accelLine)
+                        accelDataReady();
+                    if (gyroLine)
+                        gyroDataReady();
+                    accelLine = gyroLine = false;
+                    lineTime = NEVER;
+                }
+                FirmwareState state = waitProcessed(processed);
+                ok = state != Stopped;
+                blocked = state == Blocked;
+                busyUntil = interruptTime + cpuTime;
+                if (txDone == NEVER && uart.transmit(txByte))
+                    txDone = interruptTime + uart.byteTime();
+            } else if (sampleTime != NEVER && sampleTime <= txDone) {
+                OS::Interrupt cpu;
+                advance(trace, length, sampleTime);
+            } else if (txDone != NEVER) {
+                uint64_t time = txDone;
+                {
+                    OS::Interrupt cpu;
+                    advance(trace, length, time);
+                }
+                if (link.receive(txByte)) {
+                    const host::ev3::Message& message = link.getMessage();
+                    if (message.valid && message.type() == ev3::UartProtocol::MESSAGE_DATA && message.mode() == rate.mode) {
+                        const uint8_t* payload = message.payload();
+                        for (uint8_t i = 0; i < 3; ++i) {
+                            uint8_t offset = ((rate.mode == MODE_ALL ? GYRO_OFFSET : 0) + i) * 2;
+                            outputSum[i] += int16_t(payload[offset] | (payload[offset + 1] << 8));
+                        }
+                        ++outputs;
+                    }
+                }
+                txDone = uart.transmit(txByte) ? time + uart.byteTime() : NEVER;
+
+                if (blocked) {
+                    //The transmitter interrupt may have released the firmware
+                    FirmwareState state = waitProcessed(processed);
+                    ok = state != Stopped;
+                    blocked = state == Blocked;
+                    if (!blocked)
+                        busyUntil = time + cpuTime;
+                    if (txDone == NEVER && uart.transmit(txByte))
+                        txDone = time + uart.byteTime();
+                }
+            } else {
+                break;
+            }
+
+            if ((step & 0xFF) == 0)
+                link.keepAlive();
+        }
+
+        {
+            OS::Interrupt cpu;
+            source = 0;
+        }
+
+        result.samples = trace.samples;
+        result.overwritten = getOverruns(trace) - overruns;
+        result.frames = link.getDataFrames() - frames;
+        result.checksumErrors = link.getChecksumErrors() - errors;
+        result.seconds = double(device.getTime() - start) / 1e9;
+        for (uint8_t i = 0; i < 3; ++i) {
+            result.input[i] = trace.samples != 0 ? double(trace.sum[i]) / trace.samples : 0;
+            result.output[i] = outputs != 0 ? double(outputSum[i]) / outputs : 0;
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : "../software/service/Calibration/results";
+    uint64_t cpuTime = argc > 2 ? uint64_t(atof(argv[2]) * 1000) : 0;
+
+    init(&proxy);
+    device.connect(&proxy, &raiseAccel, &raiseGyro);
+    OS::run();
+
+    host::ev3::BrickLink link(uart);
+    if (!link.connect(5000)) {
+        fprintf(stderr, "The sensor has not finished the handshake\n");
+        return 1;
+    }
+    printf("connected at %u bps, cpu time per sample %.1f us, decimation factor %u\n", unsigned(uart.getSpeed()), cpuTime / 1000.0,
+        unsigned(EV3_DECIMATION_FACTOR));
+    printf("%-8s %6s %8s %8s %11s %8s %7s %6s %17s %17s\n", "trace", "rate", "samples", "lost", "frames", "frames/s",
+        "dropped", "errors", "input (mean)", "output (mean)");
+
+    for (unsigned n = 0; n < TRACE_COUNT; ++n) {
+        char name[16];
+        sprintf(name, "w[%u].txt", n);
+        Trace gyro, accel;
+        if (!loadTrace(directory + "/Gyroscope/test1/" + name, gyro) || !loadTrace(directory + "/Accelerometer/test1/" + name, accel)) {
+            fprintf(stderr, "Cannot read the traces %s in %s\n", name, directory.c_str());
+            return 1;
+        }
+
+        for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+            TraceSource trace(gyro, accel, rates[i].mode == MODE_ACCEL);
+            Result result;
+            if (!replay(link, rates[i], trace, (trace.accelFrames ? accel.size() : gyro.size()) / 3, cpuTime, result)) {
+                fprintf(stderr, "The firmware has not processed the data ready event\n");
+                return 1;
+            }
+
+            //The frames not sent are the samples the firmware has read but the link could not carry
+            long dropped = long(result.samples - result.overwritten) / EV3_DECIMATION_FACTOR - long(result.frames);
+            printf("%-8s %6u %8lu %8lu %11lu %8.0f %7ld %6lu %5.0f %5.0f %5.0f %5.0f %5.0f %5.0f\n", name, rates[i].hz,
+                result.samples, result.overwritten, result.frames, result.seconds != 0 ? result.frames / result.seconds : 0.0,
+                dropped, result.checksumErrors,
+                result.input[0], result.input[1], result.input[2],
+                result.output[0], result.output[1], result.output[2]);
+        }
+    }
+    return 0;
+}
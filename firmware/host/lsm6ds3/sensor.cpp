@@ -0,0 +1,92 @@
+#include "sensor.h"
+
+//The stack sizes do not matter on the host
+typedef OS::process<OS::pr0, 0> CommandHandler;
+#if !EV3_SINGLE_PROCESS
+typedef OS::process<OS::pr1, 0> SensorHandler;
+#endif
+
+static CommandHandler commandHandler;
+#if !EV3_SINGLE_PROCESS
+static SensorHandler sensorHandler;
+#endif
+
+namespace host {
+namespace lsm6ds3 {
+
+    eeprom_type eeprom;
+
+    sensor_type sensor;
+
+    Lsm6ds3Model device;
+
+    namespace {
+        void uartReceive() {
+            sensor.handleUartReceive();
+        }
+
+        void uartTransmit() {
+            sensor.handleUartTransmit();
+        }
+    }
+
+    UartModel uart(UART1_BaseAddress, &uartReceive, &uartTransmit, F_MASTER);
+
+    void init(host::SampleSource* source) {
+        Lsm6ds3Spi::device = &device;
+        device.connect(source, &accelDataReady, &gyroDataReady);
+        //The EEPROM programming completes at once
+        FLASH()->IAPSR = FLASH_IAPSR_EOP | FLASH_IAPSR_HVOFF;
+        PROFILE_INIT();
+    }
+
+    void accelDataReady() {
+        sensor.handleAcelDataReady();
+    }
+
+    void gyroDataReady() {
+        sensor.handleGyroDataReady();
+    }
+
+    uint16_t processedSamples() {
+        OS::Interrupt cpu;
+        return sensor.getStatistics().processed;
+    }
+
+    bool isSensorWaiting() {
+#if EV3_SINGLE_PROCESS
+        return OS::is_waiting(OS::pr0);
+#else
+        return OS::is_waiting(OS::pr1);
+#endif
+    }
+}
+}
+
+namespace OS {
+//The single process build runs the sensor events from the protocol handler
+template<> void CommandHandler::exec()
+{
+    for(;;) {
+        host::lsm6ds3::sensor.process();
+    }
+}
+
+#if !EV3_SINGLE_PROCESS
+template<> void SensorHandler::exec()
+{
+    for(;;) {
+        host::lsm6ds3::sensor.processIMU();
+    }
+}
+#endif
+} // namespace OS
+
+//The host threads do not use the MCU stacks, the context switches are counted by the shim
+void ev3::getStackUsage(ev3::StackUsage& usage) {
+    for (uint8_t i = 0; i < ev3::StackUsage::PROCESS_COUNT; ++i) {
+        usage.size[i] = 0;
+        usage.slack[i] = 0;
+    }
+    usage.contextSwitches = uint16_t(host::getContextSwitches());
+}
@@ -0,0 +1,87 @@
+#ifndef __HOST_LSM6DS3_SENSOR_H
+#define __HOST_LSM6DS3_SENSOR_H
+
+//LSM6DS3 sensor firmware built with the host models instead of the MCU peripherals.
+//The types and the OS processes mirror src/LSM6DS3/src/main.cpp, the firmware headers are used as is.
+//The drivers play the hardware: they start the processes by OS::run and call
+//the interrupt handlers below inside OS::Interrupt, the same as the models do.
+
+#include <scmRTOS.h>
+#include <stm8/uart.h>
+#include <ev3/uart_sensor.h>
+#include <ev3/uart_speed.h>
+#include <ev3/eeprom_writer.h>
+#include <ev3/imu/imu.h>
+#include <sensors/lsm6ds3/SpiAddressStrategy.h>
+#include <sensors/ThermalTransformProvider.h>
+#include <sensors/BiasTrackingProvider.h>
+#include <sensors/DecimationProvider.h>
+
+#include "eeprom_layout.h"
+#include "imu_core.h"
+#include "imu_commands.h"
+
+#include <model/lsm6ds3_model.h>
+#include <model/uart_model.h>
+
+namespace host {
+namespace lsm6ds3 {
+
+    typedef sensors::SpiTransport<Lsm6ds3Spi, Lsm6ds3Select, sensors::lsm6ds3::SpiAddressStrategy> ImuTransport;
+
+    typedef sensors::lsm6ds3::Gyroscope<ImuTransport> Gyroscope;
+    typedef sensors::lsm6ds3::Accelerometer<ImuTransport> Accelerometer;
+
+    typedef mpl::make_type_list<Gyroscope, Accelerometer>::type devices;
+    typedef stm8::Eeprom<EepromData, devices> eeprom_type;
+
+    //The EEPROM is erased at start, so the sensor uses the identity calibration
+    extern eeprom_type eeprom;
+
+    typedef mpl::make_type_list<
+        ev3::Ev3UartConfig<F_MASTER, 460800>,
+        ev3::Ev3UartConfig<F_MASTER, 230400>,
+        ev3::Ev3UartConfig<F_MASTER, 115200>
+    >::type uart_speeds;
+
+    typedef stm8::Uart<stm8::Uart1, 64, stm8::EmptyDiagnostic, 32, ev3::MessageFraming> uart_type;
+
+    //The same build option as the firmware: the number of the chip samples in one output sample
+#ifndef EV3_DECIMATION_FACTOR
+#define EV3_DECIMATION_FACTOR 1
+#endif
+
+    typedef sensors::DecimationProvider<EV3_DECIMATION_FACTOR, sensors::ThermalTransformProvider<eeprom_type, eeprom>::Provider> calibrated_provider;
+    template <typename Derived>
+    struct imu_core_type : ev3::lsm6ds3::ImuCore<ImuTransport, sensors::BiasTrackingProvider<Gyroscope, calibrated_provider::Provider>::Provider, Derived> {};
+    template <typename Derived>
+    struct imu_type : ev3::imu::IMU<imu_core_type, ev3::lsm6ds3::Commands, 32, ev3::EepromWriter<CalibrationRecord>, Derived> {};
+
+    typedef ev3::Ev3UartSensor<97, uart_type, uart_speeds, imu_type> sensor_type;
+
+    extern sensor_type sensor;
+
+    //The register model of the IMU chip
+    extern Lsm6ds3Model device;
+
+    //The model of UART1 connected to the sensor interrupt handlers
+    extern UartModel uart;
+
+    //Prepares the models and connects the data ready lines of the chip to the handlers.
+    //It should be called before OS::run.
+    void init(host::SampleSource* source = 0);
+
+    //Interrupt handlers of the data ready lines: INT1 is the accelerometer and the FIFO, INT2 is the gyroscope
+    void accelDataReady();
+    void gyroDataReady();
+
+    //Returns the number of the data events processed by the sensor (ev3::EventStatistics)
+    uint16_t processedSamples();
+
+    //Returns true if the process of the sensor events waits for a service, e.g. the transmitter.
+    //It should be called inside OS::Interrupt.
+    bool isSensorWaiting();
+}
+}
+
+#endif //__HOST_LSM6DS3_SENSOR_H
@@ -0,0 +1,10 @@
+#ifndef __HOST_INTERRUPT_H
+#define __HOST_INTERRUPT_H
+
+namespace host {
+
+    //Interrupt handler of the firmware. The models call it with the CPU lock held (OS::Interrupt).
+    typedef void (*InterruptHandler)();
+}
+
+#endif //__HOST_INTERRUPT_H
@@ -0,0 +1,245 @@
+#include "lsm6ds3_model.h"
+
+#include <string.h>
+
+namespace host {
+
+    Lsm6ds3Model* Lsm6ds3Spi::device = 0;
+
+    namespace {
+        //The data ready signals share the bit positions in STATUS_REG and INT1_CTRL, INT2_CTRL
+        const uint8_t DATA_READY_SIGNALS = Lsm6ds3Model::Bits::AccelDataReady | Lsm6ds3Model::Bits::GyroDataReady;
+
+        //The fastest rate code and its rate in Hz, each lower code halves the rate
+        const uint8_t ODR_MAX_CODE = 10;
+        const uint64_t ODR_MAX_RATE = 6660;
+
+        //Timestamp tick in nanoseconds
+        const uint64_t TIMESTAMP_TICK = 25000;
+        const uint64_t TIMESTAMP_TICK_LOW_RESOLUTION = 6400000;
+    }
+
+    Lsm6ds3Model::Lsm6ds3Model()
+        : state(Idle), address(0), source(0), int1(0), int2(0), now(0), timestampStart(0), overruns(0), accelOverruns(0)
+    {
+        reset();
+    }
+
+    void Lsm6ds3Model::reset() {
+        memset(registers, 0, sizeof(registers));
+        memset(gyro, 0, sizeof(gyro));
+        memset(accel, 0, sizeof(accel));
+        temperature = 0;
+        registers[Registers::WHO_AM_I] = DEVICE_ID;
+        registers[Registers::CTRL3_C] = Bits::AutoIncrement;
+        gyroClock.control = 0;
+        gyroClock.next = NEVER;
+        accelClock.control = 0;
+        accelClock.next = NEVER;
+    }
+
+    void Lsm6ds3Model::select() {
+        state = Address;
+    }
+
+    void Lsm6ds3Model::deselect() {
+        state = Idle;
+    }
+
+    uint8_t Lsm6ds3Model::transfer(uint8_t data) {
+        uint8_t result = 0xFF;
+        switch (state) {
+        case Idle:
+            //The device does not drive the line without the chip select
+            break;
+
+        case Address:
+            address = data & (REGISTER_COUNT - 1);
+            state = (data & 0x80) != 0 ? Read : Write;
+            break;
+
+        case Read:
+            result = readRegister(address);
+            address = nextAddress(address);
+            break;
+
+        case Write:
+            writeRegister(address, data);
+            address = nextAddress(address);
+            break;
+        }
+        return result;
+    }
+
+    uint8_t Lsm6ds3Model::nextAddress(uint8_t current) const {
+        if ((registers[Registers::CTRL3_C] & Bits::AutoIncrement) == 0)
+            return current;
+        return uint8_t((current + 1) & (REGISTER_COUNT - 1));
+    }
+
+    uint8_t Lsm6ds3Model::readOutput(const int16_t* words, uint8_t offset) const {
+        uint16_t word = uint16_t(words[offset / 2]);
+        bool high = (offset & 1) != 0;
+        if (registers[Registers::CTRL3_C] & Bits::BigEndian)
+            high = !high;
+        return high ? uint8_t(word >> 8) : uint8_t(word);
+    }
+
+    uint8_t Lsm6ds3Model::readRegister(uint8_t reg) {
+        if (reg >= Registers::OUT_TEMP_L && reg < Registers::OUTX_L_G)
+            return readOutput(&temperature, reg - Registers::OUT_TEMP_L);
+
+        if (reg >= Registers::OUTX_L_G && reg < Registers::OUTX_L_XL) {
+            //Reading of the sample clears the data available flag
+            registers[Registers::STATUS_REG] &= uint8_t(~Bits::GyroAvailable);
+            return readOutput(gyro, reg - Registers::OUTX_L_G);
+        }
+
+        if (reg >= Registers::OUTX_L_XL && reg < Registers::OUTX_L_XL + sizeof(accel)) {
+            registers[Registers::STATUS_REG] &= uint8_t(~Bits::AccelAvailable);
+            return readOutput(accel, reg - Registers::OUTX_L_XL);
+        }
+
+        if (reg >= Registers::TIMESTAMP0_REG && reg <= Registers::TIMESTAMP2_REG)
+            return uint8_t(getTimestamp() >> ((reg - Registers::TIMESTAMP0_REG) * 8));
+
+        return registers[reg];
+    }
+
+    void Lsm6ds3Model::writeRegister(uint8_t reg, uint8_t value) {
+        switch (reg) {
+        case Registers::WHO_AM_I:
+        case Registers::STATUS_REG:
+            //Read-only registers
+            break;
+
+        case Registers::CTRL3_C:
+            if (value & Bits::SoftwareReset) {
+                reset();
+            } else {
+                registers[reg] = value;
+            }
+            break;
+
+        case Registers::CTRL1_XL:
+            registers[reg] = value;
+            updateClock(accelClock, value);
+            break;
+
+        case Registers::CTRL2_G:
+            registers[reg] = value;
+            updateClock(gyroClock, value);
+            break;
+
+        case Registers::INT1_CTRL:
+        case Registers::INT2_CTRL: {
+                //The latched data ready line rises at once if the sample has not been read
+                uint8_t status = registers[Registers::STATUS_REG] & DATA_READY_SIGNALS;
+                bool wasHigh = (registers[reg] & status) != 0;
+                registers[reg] = value;
+                InterruptHandler line = reg == Registers::INT1_CTRL ? int1 : int2;
+                if (!wasHigh && (value & status) != 0 && line != 0)
+                    line();
+            }
+            break;
+
+        case Registers::TIMESTAMP2_REG:
+            if (value == TIMESTAMP_RESET)
+                timestampStart = now;
+            break;
+
+        default:
+            registers[reg] = value;
+            break;
+        }
+    }
+
+    void Lsm6ds3Model::setGyroSample(const int16_t (&sample)[3]) {
+        memcpy(gyro, sample, sizeof(gyro));
+        registers[Registers::STATUS_REG] |= Bits::GyroAvailable;
+    }
+
+    void Lsm6ds3Model::setAccelSample(const int16_t (&sample)[3]) {
+        memcpy(accel, sample, sizeof(accel));
+        registers[Registers::STATUS_REG] |= Bits::AccelAvailable;
+    }
+
+    void Lsm6ds3Model::setTemperature(int16_t value) {
+        temperature = value;
+        registers[Registers::STATUS_REG] |= Bits::TemperatureAvailable;
+    }
+
+    void Lsm6ds3Model::connect(SampleSource* source_, InterruptHandler int1_, InterruptHandler int2_) {
+        source = source_;
+        int1 = int1_;
+        int2 = int2_;
+    }
+
+    uint64_t Lsm6ds3Model::getPeriod(uint8_t control) const {
+        uint8_t code = uint8_t((control & Bits::ODR) >> 4);
+        if (code == 0)
+            return 0;
+        if (code > ODR_MAX_CODE)
+            code = ODR_MAX_CODE;
+        return (UINT64_C(1000000000) << (ODR_MAX_CODE - code)) / ODR_MAX_RATE;
+    }
+
+    void Lsm6ds3Model::updateClock(Channel& channel, uint8_t control) {
+        uint8_t odr = control & Bits::ODR;
+        if (odr == channel.control)
+            return;
+
+        channel.control = odr;
+        uint64_t period = getPeriod(control);
+        channel.next = period != 0 ? now + period : NEVER;
+    }
+
+    uint64_t Lsm6ds3Model::getNextSample() const {
+        return gyroClock.next < accelClock.next ? gyroClock.next : accelClock.next;
+    }
+
+    //The sensors of the same rate produce the samples at the same time
+    void Lsm6ds3Model::advance(uint64_t time) {
+        for (uint64_t next = getNextSample(); next <= time; next = getNextSample()) {
+            now = next;
+            uint8_t status = registers[Registers::STATUS_REG];
+            uint8_t signals = 0;
+
+            if (gyroClock.next == now) {
+                if (status & Bits::GyroAvailable)
+                    ++overruns;
+                int16_t sample[3];
+                source->nextGyro(sample);
+                setGyroSample(sample);
+                gyroClock.next += getPeriod(registers[Registers::CTRL2_G]);
+                signals |= Bits::GyroDataReady;
+            }
+            if (accelClock.next == now) {
+                if (status & Bits::AccelAvailable)
+                    ++accelOverruns;
+                int16_t sample[3];
+                source->nextAccel(sample);
+                setAccelSample(sample);
+                accelClock.next += getPeriod(registers[Registers::CTRL1_XL]);
+                signals |= Bits::AccelDataReady;
+            }
+
+            //The latched line rises only if the previous sample of its signals has been read
+            uint8_t lowSignals = signals & uint8_t(~status);
+            uint8_t int1Signals = registers[Registers::INT1_CTRL] & DATA_READY_SIGNALS;
+            uint8_t int2Signals = registers[Registers::INT2_CTRL] & DATA_READY_SIGNALS;
+            if ((int1Signals & lowSignals) != 0 && (int1Signals & status) == 0 && int1 != 0)
+                int1();
+            if ((int2Signals & lowSignals) != 0 && (int2Signals & status) == 0 && int2 != 0)
+                int2();
+        }
+        now = time;
+    }
+
+    uint32_t Lsm6ds3Model::getTimestamp() const {
+        if ((registers[Registers::TAP_CFG] & Bits::TimerEnable) == 0)
+            return 0;
+        uint64_t tick = (registers[Registers::WAKE_UP_DUR] & Bits::TimerHighResolution) != 0 ? TIMESTAMP_TICK : TIMESTAMP_TICK_LOW_RESOLUTION;
+        return uint32_t((now - timestampStart) / tick) & 0xFFFFFF;
+    }
+}
@@ -0,0 +1,194 @@
+#ifndef __HOST_LSM6DS3_MODEL_H
+#define __HOST_LSM6DS3_MODEL_H
+
+#include <stdint.h>
+#include "interrupt.h"
+
+namespace host {
+
+    //Provides the samples the chip measures at its output data rate
+    class SampleSource {
+    public:
+        virtual ~SampleSource() {}
+
+        virtual void nextGyro(int16_t (&sample)[3]) = 0;
+        virtual void nextAccel(int16_t (&sample)[3]) = 0;
+    };
+
+    //Register model of LSM6DS3 connected by SPI.
+    //It keeps the register file and the output samples, the output registers
+    //are read in the byte order selected by CTRL3_C BLE bit.
+    //The first byte of the transaction is the address with the read bit,
+    //the address is incremented after each byte if CTRL3_C IF_INC bit is set.
+    //
+    //The time is virtual: the driver moves it by advance() and the model takes
+    //the samples from the source at the ODR set by CTRL1_XL and CTRL2_G.
+    //Each new sample sets the STATUS_REG flag and raises the data ready lines
+    //selected by INT1_CTRL and INT2_CTRL. The outputs change only between the SPI
+    //transactions, so the sample is always consistent like with the block data update.
+    //The FIFO is not modelled, the firmware FIFO acquisition gets no threshold interrupt.
+    class Lsm6ds3Model {
+    public:
+        static const uint8_t REGISTER_COUNT = 0x80;
+
+        struct Registers {
+            static const uint8_t INT1_CTRL = 0x0D;
+            static const uint8_t INT2_CTRL = 0x0E;
+            static const uint8_t WHO_AM_I = 0x0F;
+            static const uint8_t CTRL1_XL = 0x10;
+            static const uint8_t CTRL2_G = 0x11;
+            static const uint8_t CTRL3_C = 0x12;
+            static const uint8_t STATUS_REG = 0x1E;
+            static const uint8_t OUT_TEMP_L = 0x20;
+            static const uint8_t OUTX_L_G = 0x22;
+            static const uint8_t OUTX_L_XL = 0x28;
+            static const uint8_t TIMESTAMP0_REG = 0x40;
+            static const uint8_t TIMESTAMP2_REG = 0x42;
+            static const uint8_t TAP_CFG = 0x58;
+            static const uint8_t WAKE_UP_DUR = 0x5C;
+        };
+
+        struct Bits {
+            //INT1_CTRL, INT2_CTRL
+            static const uint8_t AccelDataReady = 0x01;
+            static const uint8_t GyroDataReady = 0x02;
+            //CTRL1_XL, CTRL2_G
+            static const uint8_t ODR = 0xF0;
+            //CTRL3_C
+            static const uint8_t SoftwareReset = 0x01;
+            static const uint8_t BigEndian = 0x02;
+            static const uint8_t AutoIncrement = 0x04;
+            //STATUS_REG
+            static const uint8_t AccelAvailable = 0x01;
+            static const uint8_t GyroAvailable = 0x02;
+            static const uint8_t TemperatureAvailable = 0x04;
+            //TAP_CFG
+            static const uint8_t TimerEnable = 0x80;
+            //WAKE_UP_DUR
+            static const uint8_t TimerHighResolution = 0x10;
+        };
+
+        static const uint8_t DEVICE_ID = 0x69;
+        //Written to TIMESTAMP2_REG to restart the counter
+        static const uint8_t TIMESTAMP_RESET = 0xAA;
+
+        static const uint64_t NEVER = ~uint64_t(0);
+
+    private:
+        enum TransferState {
+            Idle,
+            Address,
+            Read,
+            Write
+        };
+
+        //The output data rate clock of one sensor
+        struct Channel {
+            uint8_t control;
+            uint64_t next;
+        };
+
+        uint8_t registers[REGISTER_COUNT];
+        int16_t gyro[3];
+        int16_t accel[3];
+        int16_t temperature;
+
+        TransferState state;
+        uint8_t address;
+
+        SampleSource* source;
+        InterruptHandler int1;
+        InterruptHandler int2;
+        Channel gyroClock;
+        Channel accelClock;
+        uint64_t now;
+        uint64_t timestampStart;
+        unsigned long overruns;
+        unsigned long accelOverruns;
+
+        //Returns the byte of the output registers in the selected byte order
+        uint8_t readOutput(const int16_t* words, uint8_t offset) const;
+
+        //Returns the sample period of ODR field of CTRL1_XL or CTRL2_G in nanoseconds, zero if powered down
+        uint64_t getPeriod(uint8_t control) const;
+
+        //Restarts the clock if the sensor has been powered down or its rate has changed
+        void updateClock(Channel& channel, uint8_t control);
+
+        uint32_t getTimestamp() const;
+
+    protected:
+        virtual uint8_t readRegister(uint8_t address);
+        virtual void writeRegister(uint8_t address, uint8_t value);
+        //Returns the address of the next byte in the burst
+        virtual uint8_t nextAddress(uint8_t address) const;
+
+    public:
+        Lsm6ds3Model();
+        virtual ~Lsm6ds3Model() {}
+
+        //Restores the power on state of the registers
+        void reset();
+
+        //The chip select line
+        void select();
+        void deselect();
+
+        //Sends the byte and returns the byte received in full-duplex mode
+        uint8_t transfer(uint8_t data);
+
+        //Places the new samples into the output registers and sets the data available flags
+        void setGyroSample(const int16_t (&sample)[3]);
+        void setAccelSample(const int16_t (&sample)[3]);
+        void setTemperature(int16_t value);
+
+        //Connects the sample source and the interrupt handlers of INT1 and INT2 pins
+        void connect(SampleSource* source, InterruptHandler int1, InterruptHandler int2);
+
+        //Returns the time of the next sample in nanoseconds or NEVER if both sensors are powered down
+        uint64_t getNextSample() const;
+
+        //Takes the samples due until the time and raises the interrupts.
+        //It should be called with the CPU lock held (OS::Interrupt).
+        void advance(uint64_t time);
+
+        uint64_t getTime() const { return now; }
+
+        //Returns the number of the gyro samples replaced by the next ones before they have been read
+        unsigned long getOverruns() const { return overruns; }
+
+        //Returns the number of the accelerometer samples replaced by the next ones before they have been read
+        unsigned long getAccelOverruns() const { return accelOverruns; }
+
+        uint8_t getRegister(uint8_t address) const {
+            return registers[address & (REGISTER_COUNT - 1)];
+        }
+    };
+
+    //Adapters for sensors::SpiTransport (see sensors/spi_transport.h).
+    //The transport uses static methods, so the model is selected by the global pointer.
+    struct Lsm6ds3Spi {
+        static Lsm6ds3Model* device;
+
+        static uint8_t transaction(uint8_t data) {
+            return device->transfer(data);
+        }
+
+        //The model does not produce SPI errors
+        static uint8_t get_errors() {
+            return 0;
+        }
+    };
+
+    struct Lsm6ds3Select {
+        void on() {
+            Lsm6ds3Spi::device->select();
+        }
+
+        void off() {
+            Lsm6ds3Spi::device->deselect();
+        }
+    };
+}
+
+#endif //__HOST_LSM6DS3_MODEL_H
@@ -0,0 +1,50 @@
+#include "uart_model.h"
+
+#include <scmRTOS.h>
+#include <stm8/uart/uart_config.h>
+
+namespace host {
+
+    UartModel::UartModel(uint32_t address, InterruptHandler receiveHandler_, InterruptHandler transmitHandler_, uint32_t clock_)
+        : registers(STM8_PERIPHERAL(UART1_TypeDef, address)),
+          receiveHandler(receiveHandler_), transmitHandler(transmitHandler_), clock(clock_)
+    {
+    }
+
+    bool UartModel::receive(uint8_t byte) {
+        OS::Interrupt cpu;
+
+        if ((registers->CR2 & stm8::UartConstants::UART_CR2_RIEN) == 0)
+            return false;
+
+        registers->DR = byte;
+        registers->SR |= stm8::UartConstants::UART_SR_RXNE;
+        receiveHandler();
+        //Reading of the data register clears the flag
+        registers->SR &= uint8_t(~stm8::UartConstants::UART_SR_RXNE);
+        return true;
+    }
+
+    bool UartModel::transmit(uint8_t& byte) {
+        OS::Interrupt cpu;
+
+        if ((registers->CR2 & stm8::UartConstants::UART_CR2_TIEN) == 0)
+            return false;
+
+        registers->SR |= stm8::UartConstants::UART_SR_TXE | stm8::UartConstants::UART_SR_TC;
+        transmitHandler();
+        byte = registers->DR;
+        return true;
+    }
+
+    //UART_DIV[15:12] and UART_DIV[3:0] are in BRR2, UART_DIV[11:4] is in BRR1
+    uint32_t UartModel::getSpeed() const {
+        uint32_t divider = (uint32_t(registers->BRR2 & 0xF0) << 8) | (uint32_t(registers->BRR1) << 4) | (registers->BRR2 & 0x0F);
+        return divider != 0 ? clock / divider : 0;
+    }
+
+    uint64_t UartModel::byteTime() const {
+        uint32_t speed = getSpeed();
+        return speed != 0 ? 10 * UINT64_C(1000000000) / speed : 0;
+    }
+}
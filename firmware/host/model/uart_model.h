@@ -0,0 +1,43 @@
+#ifndef __HOST_UART_MODEL_H
+#define __HOST_UART_MODEL_H
+
+#include <stdint.h>
+#include <stm8_target.h>
+#include "interrupt.h"
+
+namespace host {
+
+    //Model of the UART peripheral registers seen by stm8::Uart.
+    //The host side calls it without the CPU lock, each call runs the interrupt handler
+    //inside OS::Interrupt. The model does not pace the bytes, the caller does it
+    //with byteTime() if it needs the line timing.
+    //
+    //The driver enables the transmitter interrupt only while it has the data to send,
+    //so each transmitter interrupt places one byte into the data register.
+    class UartModel {
+    private:
+        UART1_TypeDef* registers;
+        InterruptHandler receiveHandler;
+        InterruptHandler transmitHandler;
+        uint32_t clock;
+
+    public:
+        UartModel(uint32_t address, InterruptHandler receiveHandler, InterruptHandler transmitHandler, uint32_t clock);
+
+        //Passes the byte received from the line to the receive interrupt.
+        //Returns false if the receiver interrupt is disabled, the byte is lost.
+        bool receive(uint8_t byte);
+
+        //Takes the next byte from the transmitter.
+        //Returns false if the transmitter interrupt is disabled.
+        bool transmit(uint8_t& byte);
+
+        //Returns the speed selected by BRR1 and BRR2 registers in bits per second
+        uint32_t getSpeed() const;
+
+        //Returns the time of one byte with the start and stop bits in nanoseconds
+        uint64_t byteTime() const;
+    };
+}
+
+#endif //__HOST_UART_MODEL_H
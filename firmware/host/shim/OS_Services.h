@@ -0,0 +1,7 @@
+#ifndef __HOST_OS_SERVICES_H
+#define __HOST_OS_SERVICES_H
+
+//The host model keeps all services in one header
+#include <scmRTOS.h>
+
+#endif //__HOST_OS_SERVICES_H
@@ -0,0 +1,18 @@
+#ifndef __HOST_INTRINSICS_H
+#define __HOST_INTRINSICS_H
+
+#include <stdint.h>
+
+//Host versions of the IAR STM8 intrinsic functions used by the library.
+//The interrupts are modelled by the CPU lock (see scmRTOS.h), so the interrupt control does nothing.
+
+inline void __enable_interrupt() {}
+inline void __disable_interrupt() {}
+inline void __no_operation() {}
+
+//Complements the bit of the byte
+inline void __BCPL(uint8_t* address, uint8_t bit) {
+    *address ^= uint8_t(1 << bit);
+}
+
+#endif //__HOST_INTRINSICS_H
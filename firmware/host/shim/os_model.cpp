@@ -0,0 +1,264 @@
+#include <scmRTOS.h>
+#include <stm8_target.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+uint8_t host::memory[0x10000];
+
+namespace OS {
+
+    namespace {
+        typedef std::chrono::steady_clock clock_type;
+
+        struct ProcessEntry {
+            TPriority priority;
+            void (*exec)();
+        };
+
+        struct Kernel {
+            //Held by the running process or interrupt handler
+            std::mutex cpu;
+            //Notified when any process is resumed, each waiter checks its own tag
+            std::condition_variable resumed;
+            clock_type::time_point start;
+            std::vector<ProcessEntry> processes;
+            //Tags of the suspended processes that have not been resumed
+            TProcessMap waiting;
+            //The process gives the CPU away when it waits and takes it back when it is resumed
+            unsigned long contextSwitches;
+
+            Kernel()
+                : start(clock_type::now()), waiting(0), contextSwitches(0)
+            {
+            }
+        };
+
+        //The processes are registered by the static constructors.
+        //The kernel is never destroyed, the detached process threads keep waiting on it at the exit.
+        Kernel& kernel() {
+            static Kernel* instance = new Kernel();
+            return *instance;
+        }
+
+        //State of the calling thread
+        struct Context {
+            //Zero for the threads that play the hardware
+            TProcessMap tag;
+            std::unique_lock<std::mutex>* cpu;
+            bool timed;
+            clock_type::time_point deadline;
+        };
+
+        thread_local Context context = {0, 0, false, clock_type::time_point()};
+        thread_local TProcessTimeout processTimeout;
+
+        //Nesting level and the start of the outer critical section of the calling thread
+        thread_local unsigned criticalDepth = 0;
+        thread_local clock_type::time_point criticalStart;
+
+        //Changed by the code that holds the CPU lock
+        host::CriticalSections criticalSections[2];
+
+        //Adds the time of the critical section since its start or the last host call
+        void addCriticalTime() {
+            uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - criticalStart).count();
+            host::CriticalSections& sections = criticalSections[context.tag != 0];
+            sections.time += time;
+            if (time > sections.maxTime)
+                sections.maxTime = time;
+        }
+
+        //The host thread calls are not the part of the section, the MCU does not have them
+        void pauseCritical() {
+            if (criticalDepth != 0)
+                addCriticalTime();
+        }
+
+        void continueCritical() {
+            if (criticalDepth != 0)
+                criticalStart = clock_type::now();
+        }
+
+        void notifyResumed() {
+            pauseCritical();
+            kernel().resumed.notify_all();
+            continueCritical();
+        }
+    }
+
+    TProcessTimeout& TProcessTimeout::operator=(timeout_t timeout) {
+        context.timed = timeout != 0;
+        context.deadline = clock_type::now() + std::chrono::milliseconds(timeout);
+        return *this;
+    }
+
+    TProcessMap TService::cur_proc_prio_tag() {
+        return context.tag;
+    }
+
+    TProcessTimeout& TService::cur_proc_timeout() {
+        return processTimeout;
+    }
+
+    //The process waits until a resume call removes its tag from the map or the timeout expires.
+    //The expired process keeps the tag in the map, is_timeouted removes it (the same as scmRTOS).
+    void TService::suspend(volatile TProcessMap& waiters_map) {
+        if (context.tag == 0) {
+            fprintf(stderr, "OS model: the interrupt handler or the hardware thread cannot wait\n");
+            abort();
+        }
+
+        //The other processes run with the interrupts enabled
+        pauseCritical();
+
+        waiters_map |= context.tag;
+        kernel().waiting |= context.tag;
+        ++kernel().contextSwitches;
+        while (waiters_map & context.tag) {
+            if (!context.timed) {
+                kernel().resumed.wait(*context.cpu);
+            } else if (kernel().resumed.wait_until(*context.cpu, context.deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        kernel().waiting &= TProcessMap(~context.tag);
+        ++kernel().contextSwitches;
+
+        continueCritical();
+    }
+
+    bool TService::is_timeouted(volatile TProcessMap& waiters_map) {
+        if (waiters_map & context.tag) {
+            waiters_map &= TProcessMap(~context.tag);
+            return true;
+        }
+        return false;
+    }
+
+    void TService::resume_all(volatile TProcessMap& waiters_map) {
+        if (waiters_map) {
+            kernel().waiting &= TProcessMap(~waiters_map);
+            waiters_map = 0;
+            notifyResumed();
+        }
+    }
+
+    //pr0 has the highest priority and the lowest tag bit
+    void TService::resume_next_ready(volatile TProcessMap& waiters_map) {
+        TProcessMap map = waiters_map;
+        if (map) {
+            waiters_map = TProcessMap(map & (map - 1));
+            kernel().waiting &= TProcessMap(~(map & ~(map - 1)));
+            notifyResumed();
+        }
+    }
+
+    bool TEventFlag::wait(timeout_t timeout) {
+        TCritSect cs;
+
+        if (Value) {
+            Value = efOff;
+            return true;
+        }
+
+        cur_proc_timeout() = timeout;
+        suspend(ProcessMap);
+        if (is_timeouted(ProcessMap))
+            return false;
+
+        cur_proc_timeout() = 0;
+        return true;
+    }
+
+    //The waiting processes are resumed, otherwise the flag is set for the next wait call
+    void TEventFlag::signal() {
+        TCritSect cs;
+
+        if (ProcessMap) {
+            resume_all(ProcessMap);
+        } else {
+            Value = efOn;
+        }
+    }
+
+    TBaseProcess::TBaseProcess(TPriority priority, void (*exec)()) {
+        ProcessEntry entry = {priority, exec};
+        kernel().processes.push_back(entry);
+    }
+
+    Interrupt::Interrupt() {
+        kernel().cpu.lock();
+    }
+
+    Interrupt::~Interrupt() {
+        kernel().cpu.unlock();
+    }
+
+    void run() {
+        const std::vector<ProcessEntry>& processes = kernel().processes;
+        for (size_t i = 0; i < processes.size(); ++i) {
+            ProcessEntry entry = processes[i];
+            std::thread([entry]() {
+                std::unique_lock<std::mutex> cpu(kernel().cpu);
+                context.tag = TProcessMap(1 << entry.priority);
+                context.cpu = &cpu;
+                entry.exec();
+            }).detach();
+        }
+    }
+
+    //The zero timeout suspends the process forever like scmRTOS without force_wake_up
+    void sleep(timeout_t timeout) {
+        struct Sleeper : TService {
+            static void suspend(timeout_t timeout) {
+                TProcessMap map = 0;
+                cur_proc_timeout() = timeout;
+                TService::suspend(map);
+            }
+        };
+        Sleeper::suspend(timeout);
+    }
+
+    bool is_waiting(TPriority priority) {
+        return (kernel().waiting & (1 << priority)) != 0;
+    }
+
+    tick_count_t get_tick_count() {
+        using namespace std::chrono;
+        return tick_count_t(duration_cast<milliseconds>(clock_type::now() - kernel().start).count());
+    }
+}
+
+namespace host {
+
+    unsigned long getContextSwitches() {
+        return OS::kernel().contextSwitches;
+    }
+
+    CriticalSections& getCriticalSections(bool process) {
+        return OS::criticalSections[process];
+    }
+
+    void resetCriticalSections() {
+        OS::criticalSections[0] = CriticalSections();
+        OS::criticalSections[1] = CriticalSections();
+    }
+
+    void enterCritical() {
+        if (OS::criticalDepth++ == 0) {
+            ++OS::criticalSections[OS::context.tag != 0].count;
+            OS::criticalStart = OS::clock_type::now();
+        }
+    }
+
+    void leaveCritical() {
+        if (--OS::criticalDepth == 0)
+            OS::addCriticalTime();
+    }
+}
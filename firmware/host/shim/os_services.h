@@ -0,0 +1,7 @@
+#ifndef __HOST_OS_SERVICES_LOWER_H
+#define __HOST_OS_SERVICES_LOWER_H
+
+//The lower case name is used by the library headers
+#include <scmRTOS.h>
+
+#endif //__HOST_OS_SERVICES_LOWER_H
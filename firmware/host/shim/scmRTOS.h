@@ -0,0 +1,152 @@
+#ifndef __HOST_SCMRTOS_H
+#define __HOST_SCMRTOS_H
+
+//Host model of the scmRTOS v4 services used by the firmware.
+//
+//Each process is a thread. The threads share one "CPU": the process or the interrupt
+//handler that runs holds the CPU lock, and the blocking services release it while
+//the process waits. So the firmware code runs one piece at a time like on the MCU,
+//but the model is cooperative: an interrupt waits until the running process blocks.
+//
+//The host code that plays the hardware calls the interrupt handlers inside OS::Interrupt.
+//The system tick is 1 ms of the host steady clock.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <scmRTOS_CONFIG.h>
+
+namespace host {
+    //Time the firmware runs in the critical sections, that is with the interrupts disabled on the MCU.
+    //Only the outer sections are counted. The time a process waits inside the section
+    //is not counted, the MCU enables the interrupts when it switches the context.
+    struct CriticalSections {
+        unsigned long count;
+        uint64_t time;    //ns
+        uint64_t maxTime; //ns
+    };
+
+    //The interrupt handlers (the hardware threads) and the processes are counted separately.
+    //The statistics should be read and reset inside OS::Interrupt.
+    CriticalSections& getCriticalSections(bool process);
+    void resetCriticalSections();
+
+    void enterCritical();
+    void leaveCritical();
+
+    //Number of the context switches, two for each wait of a process: to the other process
+    //or the idle one and back. It should be read inside OS::Interrupt.
+    unsigned long getContextSwitches();
+}
+
+//The CPU lock is held by the running code, so the critical section does not lock,
+//it only measures its time (host::CriticalSections)
+struct TCritSect {
+    TCritSect() { host::enterCritical(); }
+    ~TCritSect() { host::leaveCritical(); }
+};
+
+namespace OS {
+    typedef uint8_t TProcessMap;
+
+    enum TPriority {
+        pr0,
+        pr1,
+        pr2,
+        pr3,
+        pr4,
+        pr5,
+        pr6,
+        prIDLE
+    };
+
+    //Timeout of the current process in system ticks, zero means no timeout.
+    //The deadline is fixed when the timeout is assigned, so the process suspended
+    //several times by one service call waits for the whole timeout only once.
+    class TProcessTimeout {
+    public:
+        TProcessTimeout& operator=(timeout_t timeout);
+    };
+
+    class TService {
+    protected:
+        static TProcessMap cur_proc_prio_tag();
+        static TProcessTimeout& cur_proc_timeout();
+
+        static void suspend(volatile TProcessMap& waiters_map);
+        static bool is_timeouted(volatile TProcessMap& waiters_map);
+
+        static void resume_all(volatile TProcessMap& waiters_map);
+        static void resume_all_isr(volatile TProcessMap& waiters_map) { resume_all(waiters_map); }
+        static void resume_next_ready(volatile TProcessMap& waiters_map);
+        static void resume_next_ready_isr(volatile TProcessMap& waiters_map) { resume_next_ready(waiters_map); }
+    };
+
+    class TEventFlag : public TService {
+    public:
+        enum TValue { efOff = 0, efOn = 1 };
+
+        TEventFlag(TValue init_val = efOff)
+            : ProcessMap(0), Value(init_val)
+        {
+        }
+
+        bool wait(timeout_t timeout = 0);
+        void signal();
+        void signal_isr() { signal(); }
+        void clear() { Value = efOff; }
+        bool is_signaled() const { return Value == efOn; }
+
+    private:
+        volatile TProcessMap ProcessMap;
+        volatile TValue Value;
+    };
+
+    //The process registers itself at construction, OS::run starts the threads
+    class TBaseProcess {
+    protected:
+        TBaseProcess(TPriority priority, void (*exec)());
+    };
+
+    template<TPriority pr, size_t stk_size>
+    class process : public TBaseProcess {
+    public:
+        process()
+            : TBaseProcess(pr, &exec)
+        {
+        }
+
+        static void exec();
+
+        //The host threads do not use the MCU stack
+        size_t stack_slack() const { return 0; }
+    };
+
+    //Runs the interrupt handler on the CPU: the constructor waits until the running process blocks
+    class Interrupt {
+    public:
+        Interrupt();
+        ~Interrupt();
+    private:
+        Interrupt(const Interrupt&);
+        Interrupt& operator=(const Interrupt&);
+    };
+
+    //Interrupt wrapper of the firmware handlers, the host calls them inside OS::Interrupt
+    struct TISRW {
+        TISRW() {}
+    };
+
+    //Starts the threads of the registered processes and returns,
+    //the calling thread continues as the hardware
+    void run();
+
+    void sleep(timeout_t timeout = 0);
+    tick_count_t get_tick_count();
+
+    //Returns true if the process waits for a service and has not been resumed.
+    //The timed out process is waiting until it takes the CPU.
+    //The hardware threads call it inside OS::Interrupt.
+    bool is_waiting(TPriority priority);
+}
+
+#endif //__HOST_SCMRTOS_H
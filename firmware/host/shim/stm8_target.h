@@ -0,0 +1,32 @@
+#ifndef STM8_TARGET_H
+#define STM8_TARGET_H
+
+//Host replacement of the scmRTOS target header.
+//The peripheral registers are placed into the host memory at their MCU addresses,
+//the host models of the peripherals work with the same memory (see host/model).
+
+#include <stdint.h>
+#include <intrinsics.h>
+
+namespace host {
+    //64K address space of the MCU, only the peripheral registers are used
+    extern uint8_t memory[0x10000];
+
+    inline void* peripheral(uint32_t address) {
+        return memory + (address & 0xFFFF);
+    }
+}
+
+#define STM8_PERIPHERAL(type, address) ((type*)host::peripheral(address))
+
+//The standard peripheral library accepts only the MCU compilers.
+//The Cosmic branch does not use the compiler extensions in the declarations.
+#if !defined(__CSMC__) && !defined(__ICCSTM8__)
+#define __CSMC__
+#endif
+
+#include "stm8s_conf.h"
+
+#define TARGET_STM8S
+
+#endif // STM8_TARGET_H
@@ -9,6 +9,8 @@ namespace ev3 {
     //Scale info format: CCCDDSSS - CCC - event code, DD - device number, SSS - sensitivity range number
     //Mode info format: CCCMMMMM - CCC - event code, MMMMM - mode number
     //Eeprom info format: CCCDDSSS - CCC - event code, DD - device number, SSS - sensitivity range number
+    //Config info format: CCCDDVVV - CCC - event code, DD - device number, VVV - setting value.
+    //                    DD = ImuReserved selects the settings common for all devices
 
     enum EventKind {
         DataEvent = 0,
@@ -17,7 +19,7 @@ namespace ev3 {
         ResetEvent = 0x60,
         StartEvent = 0x80,
         StopEvent = 0xA0,
-        RequestEvent = 0xC0,
+        ConfigEvent = 0xC0,
         EepromEvent = 0xE0
     };
 
@@ -12,7 +12,8 @@ namespace commands {
     class MessageCommand {
     private:
         uint8_t buffer_size;
-        uint8_t data[data_size];
+        //The last byte receives the message checksum
+        uint8_t data[data_size + 1];
     public:
         INLINE MessageCommand(uint8_t len)
             : buffer_size(len)
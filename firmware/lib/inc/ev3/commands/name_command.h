@@ -14,8 +14,9 @@ namespace commands {
         struct root {
         };
 
-        //Storage class that puts the character value into a buffer
-        template <typename Item>
+        //Storage class that puts the character value into a buffer.
+        //The position makes the base classes of the repeated characters distinct.
+        template <typename Item, size_t position>
         struct char_item {
             char c;
 
@@ -25,14 +26,14 @@ namespace commands {
         //Metafunction to generate character buffer
         template <typename State, typename Item>
         struct StringBuilder {
-            struct type: State, char_item<Item> {
+            struct type: State, char_item<Item, sizeof(State)> {
             };
         };
 
         //Specialization for the terminal item
         template <typename Item>
         struct StringBuilder<root, Item> {
-            typedef char_item<Item> type;
+            typedef char_item<Item, 0> type;
         };
 
         //Metafunction to calculate checksum of the character sequence
@@ -4,6 +4,7 @@
 #include <ev3/ev3_uart.h>
 #include <ev3/commands/checksum.h>
 #include <mpl/float.h>
+#include <utils/byte_order.h>
 
 namespace ev3 {
 namespace commands {
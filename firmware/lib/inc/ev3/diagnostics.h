@@ -0,0 +1,93 @@
+#ifndef __EV3_DIAGNOSTICS_H
+#define __EV3_DIAGNOSTICS_H
+
+#include <stdint.h>
+#include <utils/byte_order.h>
+#include <utils/profiler.h>
+
+namespace ev3 {
+
+    //Blocks sent by the diagnostic mode, the host selects them by the command
+    enum DiagnosticBlock {
+        DiagnosticCounters,
+        //The profiler record of the stage, DiagnosticProfile + utils::ProfileStage
+        DiagnosticProfile,
+        DiagnosticStacks = DiagnosticProfile + utils::PROFILE_STAGE_COUNT
+    };
+
+    //Counters of the sample pipeline sent by the hidden diagnostic mode.
+    //The host receives them as Int16 values in the declaration order, the counters wrap around.
+    //The event counters are cleared by the device reset, the link counters and the error flags
+    //are kept since power on.
+    struct Diagnostics {
+        static const uint8_t COUNT = 8;
+
+        //Data ready interrupts
+        uint16_t dataReceived;
+        //Data events processed by the event loop, the coalesced ones are counted once
+        uint16_t dataProcessed;
+        //Data events coalesced with the pending event of the same source
+        uint16_t dataOverruns;
+        //Maximum number of the commands waiting in the event queue
+        uint16_t queueHighWater;
+        //Data frames sent to the host and lost because the UART was busy
+        uint16_t framesSent;
+        uint16_t framesDropped;
+        //The low byte of the Int16 value: stm8::UartError flags of the received bytes,
+        //the high byte: error flags of the SPI status register
+        uint8_t uartErrors;
+        uint8_t spiErrors;
+        //Handshakes restarted after the communication failure
+        uint16_t restarts;
+
+        //Converts the counters to the byte order of the host
+        void toLittleEndian() {
+            swap(dataReceived);
+            swap(dataProcessed);
+            swap(dataOverruns);
+            swap(queueHighWater);
+            swap(framesSent);
+            swap(framesDropped);
+            swap(restarts);
+        }
+
+    private:
+        static void swap(uint16_t& value) {
+            value = uint16_t(swap_bytes(int16_t(value)));
+        }
+    };
+
+    static_assert(sizeof(Diagnostics) == Diagnostics::COUNT * sizeof(uint16_t), "Unexpected diagnostic block size");
+
+    //Stack usage of the OS processes: the command handler, the sensor handler and the idle process.
+    //The single process build (EV3_SINGLE_PROCESS) reports the event loop as the command handler
+    //and zero size of the sensor handler.
+    //The OS fills the stacks with the pattern at start (scmRTOS_DEBUG_ENABLE),
+    //the slack is the number of the bytes that have never been used since power on.
+    struct StackUsage {
+        static const uint8_t PROCESS_COUNT = 3;
+
+        uint16_t size[PROCESS_COUNT];
+        uint16_t slack[PROCESS_COUNT];
+        //Context switches since power on, it wraps around.
+        //The host gets the switch rate from two readings.
+        uint16_t contextSwitches;
+        uint16_t reserved;
+
+        //Converts the values to the byte order of the host
+        void toLittleEndian() {
+            for (uint8_t i = 0; i < PROCESS_COUNT; ++i) {
+                size[i] = uint16_t(swap_bytes(int16_t(size[i])));
+                slack[i] = uint16_t(swap_bytes(int16_t(slack[i])));
+            }
+            contextSwitches = uint16_t(swap_bytes(int16_t(contextSwitches)));
+        }
+    };
+
+    static_assert(sizeof(StackUsage) == sizeof(Diagnostics), "Unexpected stack usage block size");
+
+    //The application reports the stacks of its processes (see main.cpp)
+    void getStackUsage(StackUsage& usage);
+}
+
+#endif //__EV3_DIAGNOSTICS_H
@@ -321,6 +321,43 @@ namespace ev3 {
         static const uint8_t CMD_WRITE_MASK = (uint8_t)MESSAGE_CMD | (uint8_t)CMD_WRITE;
     };
 
+    //Framing of the host messages for stm8::Uart. The receive interrupt wakes up the protocol
+    //handler once per message, when the command byte, the payload and the checksum are received.
+    //Only the command messages are followed by the payload, the other bytes are single byte
+    //messages for the protocol handler (see Ev3UartSensor::handleCommand). The commands that
+    //do not fit the command buffer are passed at once, the handler rejects them.
+    //The UART resets the framing when the full receive buffer drops a byte.
+    class MessageFraming {
+    private:
+        //Bytes of the current message that have not been received yet
+        uint8_t remaining;
+
+    public:
+        MessageFraming()
+            : remaining(0)
+        {
+        }
+
+        void reset() {
+            remaining = 0;
+        }
+
+        //Called from the receive interrupt. Returns true if the message is complete.
+        bool receive(uint8_t byte) {
+            if (remaining != 0)
+                return --remaining == 0;
+
+            if (UartProtocol::getMessageType(byte) == UartProtocol::MESSAGE_CMD) {
+                uint8_t length = UartProtocol::getMessageLength(byte);
+                if (length <= UartProtocol::UART_DATA_LENGTH) {
+                    remaining = length + 1;
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
     //Metafunctions and constants for EV3 commands
     struct EV3Command {
     private:
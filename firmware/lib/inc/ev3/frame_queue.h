@@ -0,0 +1,178 @@
+#ifndef __EV3_FRAME_QUEUE_H
+#define __EV3_FRAME_QUEUE_H
+
+#include <stdint.h>
+#include <utils/inline.h>
+
+namespace ev3 {
+
+    //Defines what to do with a new frame if all frame buffers are busy
+    enum OverflowPolicy {
+        DropNewest, //The new frame is discarded
+        DropOldest  //The oldest frame waiting for transmission is discarded
+    };
+
+    /**
+     * Set of frame buffers shared between the sample producer and the UART transmitter.
+     *
+     * The producer always owns one buffer to fill. A filled frame is queued for
+     * transmission and the producer gets a free buffer for the next frame, so it
+     * never waits for the transmitter. The transmitter takes the queued frames
+     * in the order of arrival.
+     *
+     * The methods are not synchronized. The caller should protect them
+     * with a critical section if they are called from an ISR and a process.
+     *
+     * buffer_size - size of one frame buffer
+     * buffer_count - number of frame buffers. Two buffers give double buffering,
+     *                DropOldest policy needs at least three buffers to have effect.
+     * policy - what to do with a new frame if there is no free buffer
+     */
+    template <uint8_t buffer_size, uint8_t buffer_count, OverflowPolicy policy>
+    class FrameQueue {
+        static_assert(buffer_count >= 2, "At least two buffers are needed");
+        static_assert(buffer_count < 16, "Too many buffers");
+
+        static const uint8_t NONE = 0xFF;
+
+        uint8_t buffers[buffer_count][buffer_size];
+
+        //Frame position in the buffer
+        uint8_t offsets[buffer_count];
+        uint8_t sizes[buffer_count];
+
+        //Indices of the frames waiting for transmission, the oldest one is the first
+        uint8_t queue[buffer_count];
+        uint8_t queued;
+
+        //Index of the buffer owned by the producer
+        uint8_t filling;
+        //Index of the buffer owned by the transmitter
+        uint8_t sending;
+
+        uint16_t sent_count;
+        uint16_t dropped_count;
+
+        bool is_queued(uint8_t index) const {
+            for (uint8_t i = 0; i < queued; ++i) {
+                if (queue[i] == index)
+                    return true;
+            }
+            return false;
+        }
+
+        //Returns the index of a buffer that is not used or NONE
+        uint8_t find_free() const {
+            for (uint8_t i = 0; i < buffer_count; ++i) {
+                if (i != filling && i != sending && !is_queued(i))
+                    return i;
+            }
+            return NONE;
+        }
+
+        //Removes the oldest frame from the queue
+        uint8_t dequeue() {
+            uint8_t index = queue[0];
+            --queued;
+            for (uint8_t i = 0; i < queued; ++i) {
+                queue[i] = queue[i + 1];
+            }
+            return index;
+        }
+
+    public:
+        //Result of push
+        enum push_result {
+            Dropped,    //The new frame is lost, the producer keeps its buffer
+            Queued,     //The frame waits for the transmitter
+            SendNow     //The transmitter is idle, the frame should be sent right now
+        };
+
+        INLINE FrameQueue()
+            : sent_count(0), dropped_count(0)
+        {
+            reset();
+        }
+
+        //Discards all frames. The counters are not changed.
+        void reset() {
+            queued = 0;
+            filling = 0;
+            sending = NONE;
+        }
+
+        //Returns the buffer to fill the next frame
+        uint8_t* buffer() {
+            return buffers[filling];
+        }
+
+        //Queues the frame placed into the producer's buffer
+        //offset - position of the frame in the buffer
+        //size - frame size
+        //DropOldest policy queues the new frame in place of the oldest one, it is counted as dropped.
+        push_result push(uint8_t offset, uint8_t size) {
+            uint8_t next = find_free();
+            if (next == NONE) {
+                if (policy == DropOldest && queued != 0) {
+                    next = dequeue();
+                } else {
+                    //Keep the producer's buffer, the new frame is lost
+                    ++dropped_count;
+                    return Dropped;
+                }
+                ++dropped_count;
+            }
+
+            offsets[filling] = offset;
+            sizes[filling] = size;
+            queue[queued++] = filling;
+            filling = next;
+
+            if (sending == NONE) {
+                sending = dequeue();
+                return SendNow;
+            }
+            return Queued;
+        }
+
+        //Returns true if the transmitter owns a frame
+        bool is_sending() const {
+            return sending != NONE;
+        }
+
+        //Returns the frame being transmitted
+        const uint8_t* front() const {
+            return buffers[sending] + offsets[sending];
+        }
+
+        //Returns size of the frame being transmitted
+        uint8_t front_size() const {
+            return sizes[sending];
+        }
+
+        //Releases the transmitted frame and takes the next one
+        //Returns true if there is the next frame to send
+        bool pop() {
+            ++sent_count;
+            if (queued != 0) {
+                sending = dequeue();
+                return true;
+            }
+            sending = NONE;
+            return false;
+        }
+
+        //Number of frames that have been transmitted
+        uint16_t get_sent_count() const {
+            return sent_count;
+        }
+
+        //Number of frames that have been lost because of the busy transmitter
+        uint16_t get_dropped_count() const {
+            return dropped_count;
+        }
+    };
+
+}
+
+#endif //__EV3_FRAME_QUEUE_H
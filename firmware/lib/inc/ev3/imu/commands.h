@@ -2,6 +2,7 @@
 #define __EV3_IMU_COMMANDS_H
 
 #include <ev3/command_info.h>
+#include <ev3/diagnostics.h>
 
 namespace ev3 {
 namespace imu {    
@@ -9,13 +10,27 @@ namespace imu {
     //Common code to command processing and encoding
     template <typename CommandImpl>
     struct Commands {
+        //Commands common for all devices
+        enum CommonCommand {
+            //Selects the block sent by the diagnostic mode (ev3::DiagnosticBlock): the pipeline counters,
+            //the record of the profiler stage (DIAGNOSTIC_PROFILE + utils::ProfileStage) or the stack usage.
+            //The firmware built without the profiler sends the counters instead of the records.
+            DIAGNOSTIC_COUNTERS = 0x18,
+            DIAGNOSTIC_PROFILE  = 0x19,
+            DIAGNOSTIC_STACKS   = DIAGNOSTIC_COUNTERS + DiagnosticStacks
+        };
+
+        static bool isDiagnosticCommand(uint8_t command) {
+            return (command >= DIAGNOSTIC_COUNTERS && command <= DIAGNOSTIC_STACKS);
+        }
+
         //Packs the device kind and the target scale into device scale info byte
         //See command_info.h file for detals
         template <uint8_t offset>
         static uint8_t getInfo(uint8_t command) {
             //implements formula (x-offset)*8 where x is high nibble of the command: x = (command 0xF0) >> 4
             //I use shift operator instead of / 2 to avoid usage of 16-bit arithmetic
-            return ((command - offset) >> 1) & ScaleInfoMask::Device | (command & ScaleInfoMask::Scale);
+            return (((command - offset) >> 1) & ScaleInfoMask::Device) | (command & ScaleInfoMask::Scale);
         }
 
         //Implements processing of the device specific commands
@@ -27,6 +42,10 @@ namespace imu {
             } else if (CommandImpl::isUpdateEepromCommand(command.hostCommand())) {
                 //The first byte is the host command.
                 device->writeEeprom(CommandImpl::getEepromInfo(command.hostCommand()), command.payload(), command.payload_size());
+            } else if (CommandImpl::isConfigCommand(command.hostCommand())) {
+                device->configure(CommandImpl::getConfigInfo(command.hostCommand()));
+            } else if (isDiagnosticCommand(command.hostCommand())) {
+                device->selectDiagnostics(command.hostCommand() - DIAGNOSTIC_COUNTERS);
             }
         }
     };
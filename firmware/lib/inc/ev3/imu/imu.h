@@ -3,15 +3,39 @@
 
 #include <utils/inline.h>
 #include <utils/blocking_queue.h>
+#include <utils/pending_events.h>
+#include <utils/profiler.h>
 #include <string.h>
 
 namespace ev3 {
 namespace imu {    
 
+    //Counters of the event processing. The counters wrap around.
+    struct EventStatistics {
+        //Number of the data ready interrupts
+        uint16_t received;
+        //Number of the data events processed, the coalesced ones are counted once
+        uint16_t processed;
+        //Number of the data events coalesced with the pending event of the same source,
+        //each of them is a sample the host has not received.
+        uint16_t overruns;
+        //Maximum time between the data ready interrupt that wakes up the event loop
+        //and the processing of the pending data, in system ticks
+        uint16_t maxLatency;
+        //Maximum number of the commands waiting in the event queue
+        uint16_t queueHighWater;
+    };
+
     /**
      * IMU wrapper to work with RTOS port.
-     * It contains blocking queue to process events from the sensor and
-     * switch mode commands from the EV3 host.
+     * It contains blocking queue to process switch mode commands from the EV3 host.
+     * The data ready interrupts set "sample pending" flags instead of queuing the events,
+     * so the stale samples do not accumulate, and the commands are processed before the data.
+     * The interrupts disable the other interrupts only to wake up the event loop.
+     *
+     * The single process build (EV3_SINGLE_PROCESS) does not have the sensor process.
+     * The EV3 protocol handler calls processEvents while it waits for the host (see Ev3UartSensor),
+     * and the data ready interrupts signal the event flag of that loop instead of queuing the wake up token.
      *
      * ImuCore - device-specific template that contains device communication protocol.
      * Commands - class that implements commands that EV3 host can send to the sensor.
@@ -25,12 +49,27 @@ namespace imu {
         //Device specific commands are accesible via device type
         typedef Commands commands;
         typedef ImuCore<Derived> base_type;
+        typedef EventStatistics statistics_type;
 
 
     private:
+        static const uint8_t SOURCE_COUNT = MagnetometerAvailable + 1;
+
         utils::blocking_queue<uint8_t, events_queue_size> events_queue;
         EepromWriter eepromWriter;
 
+        //Data events waiting for processing, indexed by EventSource
+        utils::pending_events<SOURCE_COUNT> pendingData;
+        //System tick of the interrupt that has woken up the event loop
+        volatile uint16_t wakeUpTime;
+        EventStatistics statistics;
+        //Block sent by the diagnostic mode (ev3::DiagnosticBlock)
+        uint8_t diagnosticBlock;
+#if EV3_SINGLE_PROCESS
+        //Wakes up the single event loop
+        OS::TEventFlag eventFlag;
+#endif
+
         //Callback to call updateEeprom method of ImuCore
         //Using the callback together with EepromWriter parameter allows us
         //to simplify EepromWriter interface and makes
@@ -56,90 +95,199 @@ namespace imu {
 
     public:
         INLINE IMU()
+            : wakeUpTime(0), diagnosticBlock(0)
         {
+            resetStatistics();
+        }
+
+        //Returns the counters of the data event processing
+        const EventStatistics& getStatistics() const {
+            return statistics;
+        }
+
+        //The data ready interrupt increments the counters, so they are cleared with the interrupts disabled
+        void resetStatistics() {
+            TCritSect cs;
+            memset(&statistics, 0, sizeof(statistics));
+        }
+
+        //Selects the block sent by the diagnostic mode. The byte is written by the command handler
+        //and read by the event loop, so it does not need the event queue.
+        void selectDiagnostics(uint8_t block) {
+            diagnosticBlock = block;
+        }
+
+        uint8_t getDiagnosticBlock() const {
+            return diagnosticBlock;
         }
 
         //Stops generation of data events
         void stop() {
-            events_queue.push(StopEvent);
+            queueEvent(StopEvent);
         }
 
         //Starts generation of data events
         void start() {
-            events_queue.push(StartEvent);
+            queueEvent(StartEvent);
         }
 
         //Event handler loop.
         //Should be called from the dedicated OS process
         void waitForEvent() {
             uint8_t event;
-            if (events_queue.pop(event)) {
-                switch (event & EventMask::EventKind) {
-                case DataEvent:
-                    base_type::handleEvent(EventSource(event));
-                    break;
-                case ScaleEvent:
-                    base_type::setScale(event & EventMask::EventInfo);
-                    break;
-                case ModeEvent:
-                    base_type::setMode(event & EventMask::EventInfo);
-                    break;
-                case ResetEvent:
-                    base_type::reset();
-                    break;
-                case StopEvent:
-                    base_type::stop();
-                    break;
-                case StartEvent:
-                    base_type::start();
-                    break;
-//                case RequestEvent:
-//                    core.dataRequest();
-//                    break;
-                case EepromEvent:
-                    eepromWriter.updateEeprom(EepromCall(*this, event & EventMask::EventInfo));
-                    break;
-                }
-            }
+            if (events_queue.pop(event))
+                executeCommand(event);
+            //The commands have priority, the data is processed when no command is waiting.
+            //The last popped command may leave the pending data without the token in the queue.
+            if (events_queue.empty())
+                processData();
+        }
+
+#if EV3_SINGLE_PROCESS
+        //Processes the queued commands and the pending data without blocking.
+        //The commands are queued by the caller's process, so nobody waits for the queue space.
+        void processEvents() {
+            uint8_t event;
+            while (events_queue.pop_isr(event))
+                executeCommand(event);
+            processData();
         }
 
+        //Waits for the data ready or the byte receive interrupt.
+        //Returns false if the timeout has expired.
+        bool waitForSignal(timeout_t timeout) {
+            return eventFlag.wait(timeout);
+        }
+
+        //Wakes up the event loop. This method should be called from ISR handler.
+        void signalEvent() {
+            eventFlag.signal_isr();
+        }
+#endif
+
         //This method should be called from ISR handler
         void handleAcelDataReady() {
-            //TODO - add error processing
-            events_queue.push_isr(AccelerometerAvailable);
+            dataReady(AccelerometerAvailable);
         }
 
         //This method should be called from ISR handler
         void handleGyroDataReady() {
-            //TODO - add error processing
-            events_queue.push_isr(GyroscopeAvailable);
+            dataReady(GyroscopeAvailable);
         }
 
         //This method is called from the host event processor process.
         //So we need to queue this event.
         void changeMode(uint8_t mode) {
-            events_queue.push(ModeEvent | (mode & EventMask::EventInfo));
+            queueEvent(ModeEvent | (mode & EventMask::EventInfo));
         }
 
         //Changes sensor's sensitivity
         void setScale(uint8_t scaleInfo) {
-            events_queue.push(ScaleEvent | (scaleInfo & EventMask::EventInfo));
+            queueEvent(ScaleEvent | (scaleInfo & EventMask::EventInfo));
         }
 
         //Returns the device to initial state
         void reset() {
-            events_queue.push(ResetEvent);
+            queueEvent(ResetEvent);
+        }
+
+        //Changes the device settings
+        void configure(uint8_t configInfo) {
+            queueEvent(ConfigEvent | (configInfo & EventMask::EventInfo));
+        }
+
+    private:
+        //Executes the command taken from the event queue
+        void executeCommand(uint8_t event) {
+            switch (event & EventMask::EventKind) {
+            case DataEvent:
+                //Wake up token, the pending data is processed below
+                break;
+            case ScaleEvent:
+                base_type::setScale(event & EventMask::EventInfo);
+                break;
+            case ModeEvent:
+                base_type::setMode(event & EventMask::EventInfo);
+                break;
+            case ResetEvent:
+                base_type::reset();
+                resetStatistics();
+                break;
+            case StopEvent:
+                base_type::stop();
+                break;
+            case StartEvent:
+                base_type::start();
+                break;
+            case ConfigEvent:
+                base_type::configure(event & EventMask::EventInfo);
+                break;
+            case EepromEvent:
+                eepromWriter.updateEeprom(EepromCall(*this, event & EventMask::EventInfo));
+                break;
+            }
+        }
+
+        //Queues the command and updates the queue high water mark.
+        //The commands are rare, so the size check is not performance critical.
+        void queueEvent(uint8_t event) {
+            events_queue.push(event);
+            uint8_t size = uint8_t(events_queue.size());
+            if (size > statistics.queueHighWater)
+                statistics.queueHighWater = size;
+        }
+
+        //Marks the source as pending. The device keeps the latest sample, so the new event
+        //of the pending source is coalesced with the previous one.
+        //Only the wake up of the event loop needs the critical section of the scheduler call.
+        void dataReady(EventSource source) {
+            PROFILE_START();
+            ++statistics.received;
+            switch (pendingData.publish(source)) {
+            case utils::pending_events<SOURCE_COUNT>::Coalesced:
+                ++statistics.overruns;
+                break;
+
+            case utils::pending_events<SOURCE_COUNT>::WakeUp:
+                wakeUpTime = uint16_t(OS::get_tick_count());
+#if EV3_SINGLE_PROCESS
+                eventFlag.signal_isr();
+#else
+                //The full queue is processed before checking the pending data
+                events_queue.push_isr(DataEvent);
+#endif
+                break;
+
+            default:
+                break;
+            }
         }
 
-//        void dataRequest() {
-//            events_queue.push(RequestEvent);
-//        }
+        //Processes the data events pending at the moment
+        void processData() {
+            //The wake up time is read after the acknowledge, so the interrupt
+            //between them can only make the latency smaller
+            if (pendingData.acknowledge()) {
+                PROFILE_STAGE(ProfileQueuePop);
+                uint16_t latency = uint16_t(OS::get_tick_count()) - wakeUpTime;
+                if (latency > statistics.maxLatency)
+                    statistics.maxLatency = latency;
+            }
+
+            for (uint8_t source = 0; source < SOURCE_COUNT; ++source) {
+                if (pendingData.take(source)) {
+                    base_type::handleEvent(EventSource(source));
+                    ++statistics.processed;
+                }
+            }
+        }
 
+    public:
         //Writes EEPROM data for the specified device and its scale into
         //appropriate section of the EEPROM data area
         void writeEeprom(uint8_t eepromInfo, const uint8_t* data, uint8_t size) {
             eepromWriter.write(data, size);
-            events_queue.push(EepromEvent | (eepromInfo & EventMask::EventInfo));
+            queueEvent(EepromEvent | (eepromInfo & EventMask::EventInfo));
         }
     };
 }}
@@ -11,7 +11,6 @@
 
 #include <ev3/commands/type_command.h>
 #include <ev3/commands/modes_command.h>
-#include <ev3/commands/speed_command.h>
 #include <ev3/commands/range_command.h>
 #include <ev3/commands/name_command.h>
 #include <ev3/commands/format_command.h>
@@ -69,8 +68,10 @@ namespace ev3 {
     };
 
 
-    //Creates the buffer that contains sensor descriptor
-    template <uint8_t typeId, uint32_t uartSpeed, typename ModeList>
+    //Creates the buffer that contains sensor descriptor.
+    //The SPEED command is not a part of the descriptor, because the speed is
+    //selected at runtime. It should be sent between the header and the mode list.
+    template <uint8_t typeId, typename ModeList>
     struct SensorInfo {
         template <typename T>
         struct view_predicate {
@@ -81,26 +82,46 @@ namespace ev3 {
 
         typedef typename mpl::fold<ModeList, details::root, details::ListBuilder>::type mode_list_type;
 
-        //Type identifier
-        ev3::commands::TypeCommand<typeId> type;
-        //Total number of modes and number of visible modes
-        ev3::commands::ModesCommand<mpl::length<ModeList>::value, mpl::length<VisibleModeList>::value> modes;
-        //UART speed bits per second
-        ev3::commands::SpeedCommand<uartSpeed> speed;
-        //List of sensor modes
-        mode_list_type mode_list;
+        struct Header {
+            //Type identifier
+            ev3::commands::TypeCommand<typeId> type;
+            //Total number of modes and number of visible modes
+            ev3::commands::ModesCommand<mpl::length<ModeList>::value, mpl::length<VisibleModeList>::value> modes;
+        };
+
+        struct Modes {
+            //List of sensor modes
+            mode_list_type mode_list;
+
+            //Acknowledge command
+            uint8_t ack;
+
+            Modes() : ack(UartProtocol::BYTE_ACK) {}
+        };
 
-        //Acknowledge command
-        uint8_t ack;
+        Header header;
+        Modes modes;
 
-        SensorInfo() : ack(UartProtocol::BYTE_ACK) {}
+        //The descriptors are sent in parts by the loop over 16-bit size (see Ev3UartSensor::sendModes)
+        static_assert(sizeof(Modes) <= 0xFFFF, "The mode descriptors are too long");
+
+        //Type and modes count commands
+        const uint8_t* get_header() const {
+            return header.type;
+        }
+
+        uint8_t header_size() const {
+            return sizeof(header);
+        }
 
-        operator const uint8_t*() const {
-            return type;
+        //Mode descriptors followed by ACK
+        const uint8_t* get_modes() const {
+            return reinterpret_cast<const uint8_t*>(&modes);
         }
 
-        uint8_t size() const {
-            return sizeof(*this);
+        //The mode descriptors can be longer than 255 bytes
+        uint16_t modes_size() const {
+            return sizeof(modes);
         }
     };
 
@@ -8,7 +8,11 @@
 #include <ev3/ev3_uart.h>
 #include <ev3/command_info.h>
 #include <ev3/sensor_info.h>
+#include <ev3/uart_speed.h>
 #include <ev3/commands/message_command.h>
+#include <ev3/frame_queue.h>
+#include <ev3/diagnostics.h>
+#include <utils/profiler.h>
 
 namespace ev3 {
     /**
@@ -23,28 +27,44 @@ namespace ev3 {
      *        100..127    Reserved for internal use
      *
      * Uart - UART protocol implementation. Should implement following methods (see stm8/uart.h for details):
-     *        void reset() {
+     *        void reset();
      *        template <typename Config> void configure();
+     *        template <typename Config> void set_speed();
      *        void start();
      *        void stop();
      *        bool get_byte(uint8_t& byte, timeout_t timeout);
+     *        bool read(uint8_t* data, size_type count, timeout_t timeout);
+     *        bool try_read(uint8_t* data, size_type count); - used by the single process build
+     *        static const size_t rx_buffer_size; - it should keep the longest host message
      *        void send_data(const uint8_t* data, size_type size);
-     *        void handle_byte_receive();
-     *        void handle_byte_receive();
+     *        bool start_send(const uint8_t* data, size_type size);
+     *        size_type get_tx_free_size() const; - the largest frame start_send takes now
+     *        uint16_t get_tx_overflow_count() const;
+     *        uint8_t get_errors() const; - accumulated stm8::UartError flags
+     *        bool handle_byte_receive(); - true if the host message is complete (see ev3::MessageFraming)
+     *        bool handle_byte_transmit();
+     *        static const bool buffered_tx; - true if start_send copies the data
      *
-     * Config - UART config contains necessary information to set up communication parameters.
-     *          The sensor starts using the fixed UART speed 2400 bps, than is changed to the necessary 
-     *          communication speed after getting response from the host. 
-     *          The UART config contains necessary information to set up communication parameters.
+     * SpeedList - type list of UART configs (see Ev3UartConfig in ev3/uart_speed.h), the fastest first.
+     *          The sensor starts using the fixed UART speed 2400 bps, than is changed to the necessary
+     *          communication speed after getting response from the host.
+     *          If the host does not acknowledge the sensor info or the link fails before
+     *          the first host command, the next handshake advertises the next slower speed.
      *
      * Device - Sensor's implementation. This implementation uses 'Curiously recurring template pattern' to 
      *          allow sensor's core sending samples to the EV3 host.
+     *
+     * frame_count - number of data frame buffers. The device fills one buffer while
+     *               the UART transmits another one, so reading of samples does not wait for the UART.
+     *
+     * policy - what to do with a new data frame if all buffers are busy
      */
-    template<int type, typename Uart, typename Config, template <typename > class Device>
-    class Ev3UartSensor : public Device<Ev3UartSensor<type, Uart, Config, Device> > {
+    template<int type, typename Uart, typename SpeedList, template <typename > class Device, uint8_t frame_count = 2, OverflowPolicy policy = DropNewest>
+    class Ev3UartSensor : public Device<Ev3UartSensor<type, Uart, SpeedList, Device, frame_count, policy> > {
         typedef stm8::UartConfig<F_MASTER, 2400> uart_start_config;
 
-        typedef Device<Ev3UartSensor<type, Uart, Config, Device> > device_type;
+        typedef Device<Ev3UartSensor<type, Uart, SpeedList, Device, frame_count, policy> > device_type;
+        typedef UartSpeedTable<SpeedList> speed_table;
         typedef typename device_type::commands commands;
 
         //Size for sample buffer
@@ -73,6 +93,18 @@ namespace ev3 {
         static const timeout_t ACK_TIMEOUT = 256; // 256ms
         static const timeout_t HEARTBEAT_PERIOD = 1000; // 1000 ms
 
+        //Handshake delays. The host detects the sensor's presence by the idle line,
+        //so the delay after power on should be long enough to let the host notice the sensor.
+        static const timeout_t START_DELAY = 500; // 500 ms
+        //The host requires at least 100 ms of silence after the communication failure
+        static const timeout_t RESET_DELAY = 110; // 110 ms
+        //Time for the host to switch to the new speed after sending ACK
+        static const timeout_t SPEED_SWITCH_DELAY = 10; // 10 ms
+
+        //The mode descriptors are sent in parts of this size, because send_data takes 8-bit sizes
+        //and the descriptors of all modes are longer than 255 bytes
+        static const uint8_t MODES_PART_SIZE = 128;
+
         enum State {
             Start,
             Reset,
@@ -88,12 +120,30 @@ namespace ev3 {
         //Reserve the space for data command. The Imu device driver does not
         //manages the data buffer by itself. It requested the space for the
         //data sample from this class.
-        uint8_t buffer[mpl::clp2<sample_size>::value + 2];
+        enum { frame_buffer_size = mpl::clp2<sample_size>::value + 2 };
+
+        typedef FrameQueue<frame_buffer_size, frame_count, policy> frame_queue_type;
+        frame_queue_type frames;
+
+        //The command byte, the payload and the checksum are received before the handler wakes up,
+        //so the receive buffer limits the command length: the highest power of 2 that fits it.
+        //The sensors that take no long commands keep the smaller buffer, the longer commands are rejected.
+        static const uint8_t MAX_COMMAND_LENGTH = Uart::rx_buffer_size >= UartProtocol::UART_DATA_LENGTH + 2
+            ? UartProtocol::UART_DATA_LENGTH : uint8_t(mpl::clp2<Uart::rx_buffer_size - 1>::value / 2);
+        static_assert(Uart::rx_buffer_size >= 3, "The receive buffer should keep the shortest command message");
+        static_assert(typename Uart::tx_size_type(MODES_PART_SIZE) == MODES_PART_SIZE, "The mode descriptor part should fit the transmit size");
 
         State currentState;
 
+        //Index of the speed in the speed table advertised to the host
+        uint8_t speedIndex;
+        //The host has sent a command at the current speed
+        bool linkEstablished;
+        //Number of the handshakes restarted after the communication failure
+        uint16_t restarts;
+
         //Sensor descriptor type
-        typedef ev3::SensorInfo<type, Config::speed, typename Device<Ev3UartSensor>::mode_list> SensorInfo;
+        typedef ev3::SensorInfo<type, typename Device<Ev3UartSensor>::mode_list> SensorInfo;
 
         //Sensor descriptor data buffer that will be sent to the host
         static const SensorInfo sensorInfo;
@@ -103,27 +153,63 @@ namespace ev3 {
             return static_cast<device_type*>(this);
         }
         
-        //Reads a command from the host
+        //Reads a command from the host. The payload and the checksum are read by one call
+        //into the buffer of size + 1 bytes. The checksum of the valid message makes the total zero.
         Result readCommand(uint8_t command, uint8_t* buffer, uint8_t size) {
+            if (!receive(buffer, size + 1, HEARTBEAT_PERIOD))
+                return Timeout;
+
             uint8_t checksum = 0xff ^ command;
-            uint8_t byte_read;
-            for (uint8_t pos = 0; pos < size; ++pos) {
-                if (uart.get_byte(byte_read, HEARTBEAT_PERIOD)) {
-                    checksum ^= byte_read;
-                    buffer[pos] = byte_read;
-                } else {
-                    return Timeout;
-                }
+            for (uint8_t pos = 0; pos <= size; ++pos) {
+                checksum ^= buffer[pos];
             }
-            if (uart.get_byte(byte_read, HEARTBEAT_PERIOD)) {
-                if (byte_read != checksum) {
-                    return CRCError;
-                }
-            } else {
-                return Timeout;
+            return checksum == 0 ? Success : CRCError;
+        }
+
+#if EV3_SINGLE_PROCESS
+        //The event loop of the single process build. It processes the sensor events
+        //until count bytes are received or the timeout expires. The sensor events are processed
+        //before each received message, so the sensor data has priority over the protocol.
+        //The zero count waits for the timeout keeping the received bytes in the buffer.
+        bool runEvents(uint8_t* data, uint8_t count, timeout_t timeout) {
+            tick_count_t start = OS::get_tick_count();
+            for (;;) {
+                device_type::processEvents();
+                if (count != 0 && uart.try_read(data, count))
+                    return true;
+
+                timeout_t elapsed = timeout_t(OS::get_tick_count() - start);
+                if (elapsed >= timeout)
+                    return false;
+                device_type::waitForSignal(timeout - elapsed);
             }
+        }
+#endif
+
+        //Waits for the byte from the host
+        bool receive(uint8_t& byte, timeout_t timeout) {
+#if EV3_SINGLE_PROCESS
+            return runEvents(&byte, 1, timeout);
+#else
+            return uart.get_byte(byte, timeout);
+#endif
+        }
 
-            return Success;
+        //Waits for count bytes from the host
+        bool receive(uint8_t* data, uint8_t count, timeout_t timeout) {
+#if EV3_SINGLE_PROCESS
+            return runEvents(data, count, timeout);
+#else
+            return uart.read(data, count, timeout);
+#endif
+        }
+
+        void delay(timeout_t timeout) {
+#if EV3_SINGLE_PROCESS
+            runEvents(0, 0, timeout);
+#else
+            OS::sleep(timeout);
+#endif
         }
 
         //Startup communication sequence
@@ -134,7 +220,29 @@ namespace ev3 {
             //start receiving
             uart.start();
 
-            uart.send_data(sensorInfo, sensorInfo.size());
+            uart.send_data(sensorInfo.get_header(), sensorInfo.header_size());
+            speed_table::send_speed(uart, speedIndex);
+            sendModes();
+        }
+
+        //Sends the mode descriptors in parts, because the transmitters use 8-bit data sizes
+        void sendModes() {
+            const uint8_t* modes = sensorInfo.get_modes();
+            uint16_t size = sensorInfo.modes_size();
+            while (size != 0) {
+                uint8_t part = size > MODES_PART_SIZE ? MODES_PART_SIZE : uint8_t(size);
+                uart.send_data(modes, part);
+                modes += part;
+                size -= part;
+            }
+        }
+
+        //Selects the next slower speed. After the slowest one it starts from the fastest speed again,
+        //because the host may have been just not connected.
+        void stepDownSpeed() {
+            if (++speedIndex == speed_table::size) {
+                speedIndex = 0;
+            }
         }
 
         //Processing the command from the host
@@ -149,7 +257,7 @@ namespace ev3 {
                 }
                 break;
             case UartProtocol::MESSAGE_CMD: {
-                    ev3::commands::MessageCommand<UartProtocol::UART_DATA_LENGTH> buffer(UartProtocol::getMessageLength(command));
+                    ev3::commands::MessageCommand<MAX_COMMAND_LENGTH> buffer(UartProtocol::getMessageLength(command));
                     if (buffer.is_valid_size()) {
                         result = readCommand(command, buffer.buffer(), buffer.size());
                         if (result == Success) {
@@ -182,14 +290,46 @@ namespace ev3 {
             return result;
         }
 
-        //Sends data command to the host.
+        //Starts transmission of the current frame
+        void startFrame() {
+            if (Uart::buffered_tx) {
+                //The UART copies the frames, so the buffers are released at once
+                //and the frames go to the UART back to back. The frame that does not fit
+                //stays in the queue until the transmit buffer becomes empty.
+                while (uart.get_tx_free_size() >= frames.front_size()) {
+                    uart.start_send(frames.front(), frames.front_size());
+                    if (!frames.pop())
+                        break;
+                }
+            } else {
+                uart.start_send(frames.front(), frames.front_size());
+            }
+        }
+
+        //Discards the frames waiting for transmission
+        void resetFrames() {
+            TCritSect cs;
+            frames.reset();
+        }
+
+        //Queues data command for sending to the host.
+        //Returns false if the command cannot be sent in the current state or all frame buffers are busy,
+        //the lost frame is counted by getFramesDropped.
         bool sendData(uint8_t command, uint8_t offset, uint8_t size) {
             if (currentState == WaitingForCommand) {
+                uint8_t* buffer = frames.buffer();
                 buffer[offset] = command;
                 buffer[offset + size + 1] = ev3::commands::checksum(buffer + offset, sizeof(command) + size);
+
+                TCritSect cs;
                 //Send the command. Increase size by 2 bytes to take into account
                 //command byte and checksum byte
-                uart.send_data(buffer + offset, size + 2);
+                typename frame_queue_type::push_result result = frames.push(offset, size + 2);
+                if (result == frame_queue_type::Dropped)
+                    return false;
+                if (result == frame_queue_type::SendNow)
+                    startFrame();
+                PROFILE_STAGE(ProfileFrameQueued);
                 return true;
             }
             return false;
@@ -204,17 +344,66 @@ namespace ev3 {
             enum helper {
                 buffer_size = mpl::clp2<size>::value
             };
-            static_assert(buffer_size + offset + 2 <= sizeof(buffer), "Buffer overrun");
+            static_assert(buffer_size + offset + 2 <= frame_buffer_size, "Buffer overrun");
 
             return sendData(UartProtocol::makeData(mode, mpl::log2<buffer_size>::value), offset, buffer_size);
         }
 
         //returns pointer to the data buffer. Skip one byte to place command there
-        uint8_t* getBuffer() { return buffer + 1; }
+        uint8_t* getBuffer() { return frames.buffer() + 1; }
+
+        //Returns the number of data frames with the specified payload size
+        //the UART link can carry per second at the current speed
+        template <uint8_t size>
+        uint16_t getFrameRate() const {
+            enum helper {
+                //Command byte, payload and checksum. Each byte takes 10 bits with start and stop bits
+                frame_bits = (mpl::clp2<size>::value + 2) * 10
+            };
+            return uint16_t(speed_table::get_speed(speedIndex) / frame_bits);
+        }
+
+        //Returns the number of data frames sent to the host
+        uint16_t getFramesSent() const { return frames.get_sent_count(); }
+
+        //Returns the number of data frames lost because the UART was busy
+        uint16_t getFramesDropped() const { return frames.get_dropped_count() + uart.get_tx_overflow_count(); }
+
+        //Puts the diagnostic block selected by the host into the buffer in the host byte order:
+        //the pipeline counters, the profiler record of a stage (see utils/profiler.h) or the stack usage.
+        //busErrors - error flags of the device bus (Diagnostics::spiErrors)
+        void readDiagnostics(uint8_t* data, uint8_t busErrors) {
+            uint8_t block = device_type::getDiagnosticBlock();
+            if (block == DiagnosticStacks) {
+                StackUsage& usage = *(StackUsage*)data;
+                usage.reserved = 0;
+                getStackUsage(usage);
+                usage.toLittleEndian();
+                return;
+            }
+            if (block != DiagnosticCounters && PROFILE_READ(block - DiagnosticProfile, data))
+                return;
+
+            Diagnostics& diagnostics = *(Diagnostics*)data;
+            const typename device_type::statistics_type& statistics = device_type::getStatistics();
+            diagnostics.dataReceived = statistics.received;
+            diagnostics.dataProcessed = statistics.processed;
+            diagnostics.dataOverruns = statistics.overruns;
+            diagnostics.queueHighWater = statistics.queueHighWater;
+            diagnostics.framesSent = getFramesSent();
+            diagnostics.framesDropped = getFramesDropped();
+            diagnostics.uartErrors = uart.get_errors();
+            diagnostics.spiErrors = busErrors;
+            diagnostics.restarts = restarts;
+            diagnostics.toLittleEndian();
+        }
     public:
         INLINE Ev3UartSensor()
         {
             currentState = Start;
+            speedIndex = 0;
+            linkEstablished = false;
+            restarts = 0;
         }
 
         void process() {
@@ -222,14 +411,17 @@ namespace ev3 {
             switch (currentState) {
             case Start:
                 uart.reset();
-                //Waiting for 500 ms
-                OS::sleep(500);
+                delay(START_DELAY);
                 currentState = Init;
                 break;
             case Reset:
+                //The host has switched to the speed but we could not hear each other
+                if (!linkEstablished) {
+                    stepDownSpeed();
+                }
+                resetFrames();
                 uart.reset();
-                //Waiting for >= 100 ms
-                OS::sleep(110);
+                delay(RESET_DELAY);
                 currentState = Init;
                 break;
             case Init:
@@ -237,24 +429,30 @@ namespace ev3 {
                 currentState = WaitingForAck;
                 break;
             case WaitingForAck:
-                if (uart.get_byte(data, ACK_TIMEOUT) && data == UartProtocol::BYTE_ACK) {
+                if (receive(data, ACK_TIMEOUT) && data == UartProtocol::BYTE_ACK) {
                     currentState = SetSpeed;
                 } else {
+                    stepDownSpeed();
                     currentState = Start;
+                    ++restarts;
                 }
                 break;
             case SetSpeed:
-                uart.template set_speed<Config>();
-                //Waiting for 10 ms before host switched to the new speed
-                OS::sleep(10);
+                speed_table::set_speed(uart, speedIndex);
+                linkEstablished = false;
+                //Waiting before host switched to the new speed
+                delay(SPEED_SWITCH_DELAY);
                 currentState = WaitingForCommand;
 
                 device_type::start();
                 break;
             case WaitingForCommand:
-                if (!uart.get_byte(data, HEARTBEAT_PERIOD) || handleCommand(data) != Success) {
+                if (!receive(data, HEARTBEAT_PERIOD) || handleCommand(data) != Success) {
                     currentState = Reset;
+                    ++restarts;
                     device_type::stop();
+                } else {
+                    linkEstablished = true;
                 }
                 break;
             }
@@ -273,16 +471,37 @@ namespace ev3 {
         }
 
         void handleUartReceive() {
+#if EV3_SINGLE_PROCESS
+            if (uart.handle_byte_receive())
+                device_type::signalEvent();
+#else
             uart.handle_byte_receive();
+#endif
         }
 
         void handleUartTransmit() {
-            uart.handle_byte_transmit();
+            if (uart.handle_byte_transmit()) {
+                if (Uart::buffered_tx) {
+                    //The buffered UART has released the sent frames already, so the end of the frames
+                    //is the empty transmit buffer. The data mode sends only the frames,
+                    //the frame queue is not used during the handshake.
+                    if (currentState == WaitingForCommand) {
+                        PROFILE_STAGE(ProfileTxDone);
+                        //The frame in the queue is waiting for the free space
+                        if (frames.is_sending())
+                            startFrame();
+                    }
+                } else if (frames.is_sending()) {
+                    PROFILE_STAGE(ProfileTxDone);
+                    if (frames.pop())
+                        startFrame();
+                }
+            }
         }
     };
 
-    template<int type, typename Uart, typename Config, template <typename> class Device>
-    const Ev3UartSensor<type, Uart, Config, Device>::SensorInfo Ev3UartSensor<type, Uart, Config, Device>::sensorInfo;
+    template<int type, typename Uart, typename SpeedList, template <typename> class Device, uint8_t frame_count, OverflowPolicy policy>
+    const typename Ev3UartSensor<type, Uart, SpeedList, Device, frame_count, policy>::SensorInfo Ev3UartSensor<type, Uart, SpeedList, Device, frame_count, policy>::sensorInfo;
 
 }
 
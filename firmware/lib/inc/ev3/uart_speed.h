@@ -1,8 +1,13 @@
 #ifndef __EV3_UART_SPEED_H
 #define __EV3_UART_SPEED_H
 
+#include <stdint.h>
+#include <mpl/type_list.h>
+#include <stm8/uart/uart_config.h>
+#include <ev3/commands/speed_command.h>
+
 namespace ev3 {
-    //Calculates the actual EV3 UART speed for the 
+    //Calculates the actual EV3 UART speed for the
     //specified reference value
 	template <uint32_t speed>
 	struct uart_speed
@@ -14,6 +19,93 @@ namespace ev3 {
 		static const uint32_t reference = speed;
 		static const uint32_t value = EV3_UART_CLOCK / EV3_UART_PRESCALLER / 16;
 	};
+
+    //Sensor UART configuration for the reference speed advertised to the host.
+    //The sensor divisor is calculated for the actual host speed, and the mismatch
+    //between the sensor and the host speeds is checked at compile time.
+    //
+    //max_error - maximum allowed speed mismatch in 1/1000
+    template <uint32_t cpu_clock, uint32_t reference, uint32_t max_error = 20>
+    struct Ev3UartConfig : stm8::UartConfig<cpu_clock, uart_speed<reference>::value> {
+    private:
+        static const uint32_t host_speed = uart_speed<reference>::value;
+        //The same rounding as in stm8::UartConfig
+        static const uint32_t uart_div = (cpu_clock + host_speed / 2) / host_speed;
+        static const uint32_t sensor_speed = cpu_clock / uart_div;
+        static const uint32_t speed_error = (sensor_speed > host_speed ? sensor_speed - host_speed : host_speed - sensor_speed) * 1000 / host_speed;
+
+        //UART_DIV has 16 bits, and it should not be less than 16
+        static_assert(uart_div >= 16, "The speed is too high for the CPU clock");
+        static_assert(uart_div <= 0xFFFF, "The speed is too low for the CPU clock");
+        static_assert(speed_error <= max_error, "The sensor UART speed does not match the host speed");
+
+    public:
+        //The speed reported to the host by the SPEED command
+        static const uint32_t speed = reference;
+    };
+
+    //Gives runtime access to the list of UART configurations.
+    //The list should start from the fastest speed, the sensor steps down
+    //along the list if the host does not accept the speed.
+    template <typename ConfigList>
+    struct UartSpeedTable;
+
+    template <typename Config, typename Tail>
+    struct UartSpeedTable<mpl::type_list<Config, Tail> > {
+    private:
+        typedef UartSpeedTable<Tail> next_type;
+
+        //The command is kept in ROM like the sensor descriptor
+        static const ev3::commands::SpeedCommand<Config::speed> speedCommand;
+
+        static_assert(next_type::max_speed < Config::speed, "The speeds should be in descending order");
+
+    public:
+        static const uint8_t size = next_type::size + 1;
+        static const uint32_t max_speed = Config::speed;
+
+        //Sends SPEED command for the speed with the specified index
+        template <typename Uart>
+        static void send_speed(Uart& uart, uint8_t index) {
+            if (index == 0) {
+                uart.send_data(speedCommand, speedCommand.size());
+            } else {
+                next_type::send_speed(uart, index - 1);
+            }
+        }
+
+        //Switches the UART to the speed with the specified index
+        template <typename Uart>
+        static void set_speed(Uart& uart, uint8_t index) {
+            if (index == 0) {
+                uart.template set_speed<Config>();
+            } else {
+                next_type::set_speed(uart, index - 1);
+            }
+        }
+
+        //Returns the speed with the specified index
+        static uint32_t get_speed(uint8_t index) {
+            return index == 0 ? Config::speed : next_type::get_speed(index - 1);
+        }
+    };
+
+    template <>
+    struct UartSpeedTable<mpl::null_type> {
+        static const uint8_t size = 0;
+        static const uint32_t max_speed = 0;
+
+        template <typename Uart>
+        static void send_speed(Uart&, uint8_t) {}
+
+        template <typename Uart>
+        static void set_speed(Uart&, uint8_t) {}
+
+        static uint32_t get_speed(uint8_t) { return 0; }
+    };
+
+    template <typename Config, typename Tail>
+    const ev3::commands::SpeedCommand<Config::speed> UartSpeedTable<mpl::type_list<Config, Tail> >::speedCommand;
 }
 
-#endif //__EV3_UART_SPEED_H
\ No newline at end of file
+#endif //__EV3_UART_SPEED_H
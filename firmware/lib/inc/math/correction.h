@@ -2,6 +2,7 @@
 #define __MATH_CORRECTION_H
 
 #include <stdint.h>
+#include <string.h>
 #include <math/muldiv.h>
 #include <utils/inline.h>
 
@@ -10,21 +11,56 @@ namespace math {
     //Transforms the vector of three 16-bit integers by multiplying it to
     //a transformation matrix
 	class VectorCorrection {
+    public:
+        //Structure of the transformation matrix. The cheaper kernels give
+        //the same results as the full matrix multiplication.
+        enum MatrixKind {
+            MatrixFull,     //Any matrix
+            MatrixDiagonal, //Diagonal matrix with the offset row
+            MatrixOffset,   //Unit diagonal with the offset row, e.g. the gyro offset correction
+            MatrixIdentity  //Unit diagonal without offset, e.g. the initial EEPROM content
+        };
+
     private:
         static const uint8_t ROWS = 4;
         static const uint8_t COLUMNS = 3;
 
+        //The diagonal value that passes the sample through (0.5 in Q15 format, the result is multiplied by 2)
+        static const int16_t UNIT = 0x4000;
+
+        //Fraction bits of the interpolation factor. The factor is limited to -1..2,
+        //so the product of the matrix difference and the factor fits 32 bits.
+        static const uint8_t INTERPOLATION_BITS = 12;
+
+    public:
+        //Number of elements in the 4x3 matrix
+        static const uint8_t MATRIX_SIZE = ROWS * COLUMNS;
+
+    protected:
         //Returns the matrix for the specified scale
         // matrix - Arrays of matrices for each scale. Each matrix is 4x3 matrix
-        const int16_t* getMatrixForScale(const int16_t* matrix, uint8_t scale) const {
+        static const int16_t* getMatrixForScale(const int16_t* matrix, uint8_t scale) {
             return matrix + uint8_t(scale * ROWS * COLUMNS);
         }
 
+    private:
+
+        //Limits the value to the 16-bit range
+        static int16_t saturate(int32_t value) {
+            return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : int16_t(value);
+        }
+
         //calculates a * b / 0x8000
         static int16_t mul(int16_t a, int16_t b) {
             return muldivs16x16_16x(a, b);
         }
 
+        //calculates a * UNIT / 0x8000 without multiplication.
+        //muldivs16x16_16x rounds toward zero, so does the division.
+        static int16_t half(int16_t a) {
+            return a / 2;
+        }
+
         //returns the matrix cell 
         static int16_t get(const int16_t* matrix, uint8_t row, uint8_t col) {
             return matrix[uint8_t(row * COLUMNS) + col];
@@ -39,17 +75,123 @@ namespace math {
             result[2] = scale2le(mul(data[0], get(matrix, 0, 2)) + mul(data[1], get(matrix, 1, 2)) + mul(data[2], get(matrix, 2, 2)) + get(matrix, 3, 2));
         }
 
+        //vector_mul for MatrixDiagonal
+        INLINE static void diagonal_mul(const int16_t* matrix, const int16_t* data, int16_t* result) {
+            result[0] = scale2le(mul(data[0], get(matrix, 0, 0)) + get(matrix, 3, 0));
+            result[1] = scale2le(mul(data[1], get(matrix, 1, 1)) + get(matrix, 3, 1));
+            result[2] = scale2le(mul(data[2], get(matrix, 2, 2)) + get(matrix, 3, 2));
+        }
+
+        //vector_mul for MatrixOffset
+        INLINE static void offset_add(const int16_t* matrix, const int16_t* data, int16_t* result) {
+            result[0] = scale2le(half(data[0]) + get(matrix, 3, 0));
+            result[1] = scale2le(half(data[1]) + get(matrix, 3, 1));
+            result[2] = scale2le(half(data[2]) + get(matrix, 3, 2));
+        }
+
+        //vector_mul for MatrixIdentity
+        INLINE static void identity(const int16_t* data, int16_t* result) {
+            result[0] = scale2le(half(data[0]));
+            result[1] = scale2le(half(data[1]));
+            result[2] = scale2le(half(data[2]));
+        }
+
     public:
+        //Returns the structure of the 4x3 matrix
+        static MatrixKind classify(const int16_t* matrix);
+
+        //Changes the offset row of the 4x3 matrix to shift the output by the offset in output digits.
+        //The output is multiplied by 2, so the odd offsets are rounded toward zero.
+        static void addOffset(int16_t* matrix, const int16_t* offset);
+
+        //Interpolates the 4x3 matrices calibrated at the temperatures t0 < t1 for the temperature t.
+        //The temperature out of the range is extrapolated by no more than the range width.
+        static void interpolate(const int16_t* m0, const int16_t* m1, int16_t t0, int16_t t1, int16_t t, int16_t* result);
+
         //This method has been put into CPP file to set optimization level to maximum speed
         //The method produces 16-bit integers in little-endian format
-        void transform(const int16_t* matrix, uint8_t scale, const int16_t* data, int16_t* result) const;
+        // kind - structure of the matrix for the scale, see classify
+        void transform(const int16_t* matrix, uint8_t kind, uint8_t scale, const int16_t* data, int16_t* result) const;
 	};
 
     //Transformation matrix for the specified device, identified by Tag type
     template <typename Eeprom, Eeprom& eeprom, typename Tag>
     struct Transformation : VectorCorrection {
+        //Structure of the matrix for the current scale.
+        //The initial value selects the full multiplication that works for any matrix.
+        uint8_t kind;
+
+        INLINE Transformation()
+            : kind(MatrixFull)
+        {
+        }
+
+        //Selects the kernel for the matrix of the specified scale.
+        //It should be called when the scale is changed or the matrix is written.
+        INLINE void update(uint8_t scale) {
+            kind = classify(getMatrixForScale(eeprom.template get<Tag>().get(0), scale));
+        }
+
         INLINE void transform(uint8_t scale, const int16_t* data, int16_t* result) const {
-            VectorCorrection::transform(eeprom.template get<Tag>().get(0), scale, data, result);
+            VectorCorrection::transform(eeprom.template get<Tag>().get(0), kind, scale, data, result);
+        }
+    };
+
+    //Transformation matrix for the specified device, interpolated for the die temperature.
+    //The EEPROM data of the device keeps the matrices calibrated at several temperatures:
+    //  int16_t* get(uint8_t scale, uint8_t point) - matrix of the calibration point
+    //  int16_t* temperature(uint8_t scale, uint8_t point) - temperature of the calibration point
+    //  uint8_t* points(uint8_t scale) - number of the calibrated points sorted by the temperature
+    //  static const uint8_t temperature_points - capacity of the calibration points
+    //  bool isValid() const - checks the layout version and the checksum of the data
+    //  void seal(stm8::EepromWriter&) - writes the header for the current data
+    //The interpolated matrix is kept in RAM, so the EEPROM is not read for each sample.
+    template <typename Eeprom, Eeprom& eeprom, typename Tag>
+    struct ThermalTransformation : VectorCorrection {
+        typedef typename Eeprom::template apply<Tag>::type data_type;
+
+        int16_t matrix[MATRIX_SIZE];
+        uint8_t kind;
+        //The damaged or missing EEPROM data is not used until it is written again
+        bool valid;
+
+        INLINE ThermalTransformation()
+            : kind(MatrixIdentity), valid(false)
+        {
+        }
+
+        //Checks the EEPROM data. It should be called at start and after writing the data.
+        bool validate() {
+            return valid = eeprom.template get<Tag>().isValid();
+        }
+
+        //Interpolates the matrix for the scale and the temperature.
+        //A single calibrated point (or the erased EEPROM) selects the matrix of the first point.
+        //The invalid EEPROM data selects the identity transformation.
+        void update(uint8_t scale, int16_t temperature) {
+            if (!valid) {
+                kind = MatrixIdentity;
+                return;
+            }
+
+            data_type& data = eeprom.template get<Tag>();
+            uint8_t points = *data.points(scale);
+            if (points < 2 || points > data_type::temperature_points) {
+                memcpy(matrix, data.get(scale, 0), sizeof(matrix));
+            } else {
+                //Selects the pair of the points around the temperature
+                uint8_t point = 0;
+                while (point + 2 < points && temperature > *data.temperature(scale, point + 1)) {
+                    ++point;
+                }
+                interpolate(data.get(scale, point), data.get(scale, point + 1),
+                            *data.temperature(scale, point), *data.temperature(scale, point + 1), temperature, matrix);
+            }
+            kind = classify(matrix);
+        }
+
+        INLINE void transform(const int16_t* data, int16_t* result) const {
+            VectorCorrection::transform(matrix, kind, 0, data, result);
         }
     };
     
@@ -0,0 +1,93 @@
+#ifndef __MATH_FUSION_H
+#define __MATH_FUSION_H
+
+#include <stdint.h>
+#include <math/muldiv.h>
+#include <utils/inline.h>
+
+namespace math {
+
+    //Orientation filter that fuses gyro and accel samples into the quaternion.
+    //It is Mahony filter with the proportional feedback only: the gyro bias is
+    //removed by the calibration matrix.
+    //
+    //The quaternion is kept in Q30 format to integrate small angular rates without
+    //precision loss. The products are calculated by the 16-bit kernels from math/muldiv.h
+    //using the high words of the quaternion (Q14).
+    //
+    //The gyro and accel samples are calibrated samples in MCU byte order with
+    //the nominal sensitivity of the selected full scale range.
+    class OrientationFilter {
+    public:
+        //Gyro full scale is 125dps * 2^gyroRange
+        static const uint8_t MAX_GYRO_RANGE = 4;
+        //Accel full scale is 2g * 2^accelRange
+        static const uint8_t MAX_ACCEL_RANGE = 3;
+        //The sample rate is 13Hz * 2^rate. The integration step should be small enough
+        //to keep the first order integration accurate, so the rate should be at least 104Hz.
+        static const uint8_t MIN_RATE = 3;
+
+        //Quaternion components are w, x, y, z
+        static const uint8_t SIZE = 4;
+
+    private:
+        //Number of samples with the increased feedback gain after reset
+        //to align the quaternion with the gravity (2.5 seconds at 416Hz)
+        static const uint16_t SETTLING_SAMPLES = 1024;
+        //The feedback gain is multiplied by 2^SETTLING_BOOST during the settling
+        static const uint8_t SETTLING_BOOST = 3;
+
+        int32_t q[SIZE];
+
+        //Right shift of the gyro integration gain
+        uint8_t gyroShift;
+        //Right shift of the feedback gain
+        uint8_t feedbackShift;
+        //Left shift that converts the accel sample to Q13 format
+        uint8_t accelShift;
+
+        uint16_t settling;
+
+        void correct(const int16_t* accel, int16_t* rate, uint8_t boost) const;
+        void integrate(const int16_t* rate);
+        void normalize();
+
+    public:
+        INLINE OrientationFilter()
+        {
+            configure(0, 0, MIN_RATE);
+            reset();
+        }
+
+        //Sets the identity orientation and restarts the settling
+        void reset() {
+            q[0] = int32_t(1) << 30;
+            q[1] = 0;
+            q[2] = 0;
+            q[3] = 0;
+            settling = SETTLING_SAMPLES;
+        }
+
+        //Sets the sample format and the sample rate.
+        //gyroRange - 0..MAX_GYRO_RANGE, accelRange - 0..MAX_ACCEL_RANGE, rate - MIN_RATE..7
+        void configure(uint8_t gyroRange, uint8_t accelRange, uint8_t rate) {
+            gyroShift = rate + 2 - gyroRange;
+            feedbackShift = gyroRange;
+            accelShift = accelRange;
+        }
+
+        //Updates the orientation with one pair of samples.
+        //This method has been put into CPP file to set optimization level to maximum speed
+        void update(const int16_t* gyro, const int16_t* accel);
+
+        //Returns the quaternion in Q14 format
+        void getQuaternion(int16_t* result) const {
+            for (uint8_t i = 0; i < SIZE; ++i) {
+                result[i] = int16_t((q[i] + 0x8000) >> 16);
+            }
+        }
+    };
+
+}
+
+#endif //__MATH_FUSION_H
@@ -0,0 +1,267 @@
+#ifndef __SENSORS_BIAS_TRACKING_PROVIDER_H
+#define __SENSORS_BIAS_TRACKING_PROVIDER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <mpl/if.h>
+#include <mpl/is_same.h>
+#include <utils/byte_order.h>
+#include <utils/inline.h>
+
+namespace sensors {
+
+    namespace details {
+        //The stillness is checked over blocks of 2^STILLNESS_BLOCK_LOG2 output samples
+        static const uint8_t STILLNESS_BLOCK_LOG2 = 5;
+        static const uint8_t STILLNESS_BLOCK = 1 << STILLNESS_BLOCK_LOG2;
+
+        //Peak-to-peak range of the samples in the block.
+        //It replaces the variance to avoid multiplications: the range of the sensor
+        //noise is about 5 standard deviations over the block.
+        class SampleRange {
+            int16_t minimum[3];
+            int16_t maximum[3];
+
+        public:
+            void reset() {
+                for (uint8_t i = 0; i < 3; ++i) {
+                    minimum[i] = INT16_MAX;
+                    maximum[i] = INT16_MIN;
+                }
+            }
+
+            void add(const int16_t (&sample)[3]) {
+                for (uint8_t i = 0; i < 3; ++i) {
+                    if (sample[i] < minimum[i])
+                        minimum[i] = sample[i];
+                    if (sample[i] > maximum[i])
+                        maximum[i] = sample[i];
+                }
+            }
+
+            //Returns true if the range of any axis exceeds the limit
+            bool exceeds(uint16_t limit) const {
+                for (uint8_t i = 0; i < 3; ++i) {
+                    //The block is not empty when it is checked, so maximum >= minimum
+                    if (uint16_t(maximum[i] - minimum[i]) > limit)
+                        return true;
+                }
+                return false;
+            }
+        };
+
+        //Detects the motion of the device that does not track the bias, e.g. accelerometer.
+        template <typename Base, uint16_t motion_range>
+        class MotionDetector : public Base {
+            SampleRange range;
+            uint8_t count;
+            bool moving;
+
+            //Checks the sample in little-endian format produced by the base provider
+            void process(const uint8_t* data) {
+                int16_t sample[3];
+                memcpy(sample, data, sizeof(sample));
+                swap_sample(sample);
+
+                if (count == 0)
+                    range.reset();
+                range.add(sample);
+                if (++count == STILLNESS_BLOCK) {
+                    moving = range.exceeds(motion_range);
+                    count = 0;
+                }
+            }
+
+        public:
+            MotionDetector()
+                : count(0), moving(true)
+            {
+            }
+
+            //Restarts the detection, it should be called after changing the device settings
+            INLINE void resetDecimation() {
+                Base::resetDecimation();
+                count = 0;
+                moving = true;
+            }
+
+            INLINE void setScale(typename Base::Scale scale) {
+                Base::setScale(scale);
+                resetDecimation();
+            }
+
+            //Returns true if the last block or the current part of the block has the motion
+            bool isMoving() const {
+                return moving || (count != 0 && range.exceeds(motion_range));
+            }
+
+            INLINE bool readSample(uint8_t* data, uint8_t size) {
+                if (Base::readSample(data, size)) {
+                    process(data);
+                    return true;
+                }
+                return false;
+            }
+
+            INLINE void fromNative(const int16_t (&sample)[3], uint8_t* data) {
+                Base::fromNative(sample, data);
+                process(data);
+            }
+        };
+
+        //Estimates the output offset of the device while it is still and subtracts it from the samples.
+        //The estimate is updated by the mean of each still block with the exponential filter.
+        template <typename Base, uint16_t still_range, uint16_t max_bias>
+        class BiasTracker : public Base {
+            //The bias is kept in 1/16 digit units
+            static const uint8_t BIAS_FRACTION = 4;
+            //The estimate moves by 1/2^BIAS_FILTER_SHIFT of the difference per still block
+            static const uint8_t BIAS_FILTER_SHIFT = 3;
+
+            static_assert(max_bias < (INT16_MAX >> BIAS_FRACTION), "The bias limit is too large");
+
+            SampleRange range;
+            int32_t sum[3];
+            int16_t bias[3];
+            uint8_t count;
+            //Motion of the other devices is reported during the block
+            bool moving;
+
+            //Returns the bias rounded to the nearest digit
+            int16_t getOffset(uint8_t axis) const {
+                return (bias[axis] + (1 << (BIAS_FRACTION - 1))) >> BIAS_FRACTION;
+            }
+
+            //Updates the bias estimate if the block is still
+            void update() {
+                if (moving || range.exceeds(still_range))
+                    return;
+
+                int16_t mean[3];
+                for (uint8_t i = 0; i < 3; ++i) {
+                    //The mean of the full scale samples does not fit 16 bits in the bias units,
+                    //so it is checked before the narrowing
+                    int32_t value = sum[i] >> (STILLNESS_BLOCK_LOG2 - BIAS_FRACTION);
+                    //Large mean is a constant rotation rather than the offset
+                    if (value > int32_t(max_bias << BIAS_FRACTION) || value < -int32_t(max_bias << BIAS_FRACTION))
+                        return;
+                    mean[i] = int16_t(value);
+                }
+                for (uint8_t i = 0; i < 3; ++i) {
+                    bias[i] += (mean[i] - bias[i]) >> BIAS_FILTER_SHIFT;
+                }
+            }
+
+            //Processes the sample in little-endian format produced by the base provider
+            void process(uint8_t* data) {
+                int16_t sample[3];
+                memcpy(sample, data, sizeof(sample));
+                swap_sample(sample);
+
+                if (count == 0) {
+                    range.reset();
+                    memset(sum, 0, sizeof(sum));
+                }
+                range.add(sample);
+                for (uint8_t i = 0; i < 3; ++i) {
+                    sum[i] += sample[i];
+                }
+                if (++count == STILLNESS_BLOCK) {
+                    update();
+                    count = 0;
+                    moving = false;
+                }
+
+                for (uint8_t i = 0; i < 3; ++i) {
+                    //The saturated samples keep the saturation
+                    int32_t value = int32_t(sample[i]) - getOffset(i);
+                    sample[i] = value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : int16_t(value);
+                }
+                swap_sample(sample);
+                memcpy(data, sample, sizeof(sample));
+            }
+
+        public:
+            BiasTracker()
+                : count(0), moving(false)
+            {
+                memset(bias, 0, sizeof(bias));
+            }
+
+            //Restarts the current block, it should be called after changing the device settings
+            INLINE void resetDecimation() {
+                Base::resetDecimation();
+                count = 0;
+                moving = false;
+            }
+
+            //The bias is measured in digits of the current scale, so it is discarded
+            INLINE void setScale(typename Base::Scale scale) {
+                Base::setScale(scale);
+                resetDecimation();
+                memset(bias, 0, sizeof(bias));
+            }
+
+            //Marks the current block as moving if the other device detects the motion.
+            //It should be called before processing the sample of the tracked device.
+            //The modes without the other devices pass true to keep the estimate.
+            INLINE void setMotion(bool motion) {
+                moving |= motion;
+            }
+
+            //Moves the bias estimate into the calibration matrix of the current scale.
+            //The estimate is kept if the base provider has no matrix.
+            void saveBias() {
+                int16_t offset[3];
+                for (uint8_t i = 0; i < 3; ++i) {
+                    offset[i] = -getOffset(i);
+                }
+                if (Base::adjustOffset(offset))
+                    memset(bias, 0, sizeof(bias));
+            }
+
+            INLINE bool readSample(uint8_t* data, uint8_t size) {
+                if (Base::readSample(data, size)) {
+                    process(data);
+                    return true;
+                }
+                return false;
+            }
+
+            INLINE void fromNative(const int16_t (&sample)[3], uint8_t* data) {
+                Base::fromNative(sample, data);
+                process(data);
+            }
+        };
+    }
+
+    //Sample provider stage that tracks the zero rate offset of the gyroscope.
+    //The offset drifts with the temperature and the time, and the calibration matrix
+    //cannot remove the drift. The stage detects the stillness by the peak-to-peak range
+    //of the samples over a block of 32 samples, and updates the offset estimate by the
+    //block mean. The estimate is subtracted from the output of the next stage.
+    //The motion detected by the other devices (see setMotion) also rejects the block.
+    //
+    //Tracked - device type that tracks the bias, the other devices only detect the motion
+    //Next - sample provider that converts the samples, e.g. TransformProvider<...>::Provider
+    //still_range - maximum peak-to-peak range of the still tracked device, in output digits
+    //max_bias - maximum bias in output digits, the larger mean is a constant rotation
+    //motion_range - minimum peak-to-peak range of the moving other device, in output digits
+    //
+    //Usage:
+    //    BiasTrackingProvider<Gyroscope, TransformProvider<eeprom_type, eeprom>::Provider>::Provider
+    template <typename Tracked, template <typename> class Next,
+              uint16_t still_range = 100, uint16_t max_bias = 400, uint16_t motion_range = 400>
+    struct BiasTrackingProvider {
+
+        template <typename Device>
+        class Provider : public mpl::if_<mpl::is_same<Device, Tracked>,
+                                         details::BiasTracker<Next<Device>, still_range, max_bias>,
+                                         details::MotionDetector<Next<Device>, motion_range> >::type
+        {
+        };
+    };
+
+}
+
+#endif //__SENSORS_BIAS_TRACKING_PROVIDER_H
@@ -0,0 +1,99 @@
+#ifndef __SENSORS_DECIMATION_PROVIDER_H
+#define __SENSORS_DECIMATION_PROVIDER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <mpl/math.h>
+#include <utils/inline.h>
+
+namespace sensors {
+
+    //Sample provider stage that decimates the device samples before the output transformation.
+    //It sums factor samples in 32-bit accumulators and passes the rounded average
+    //to the next stage (boxcar filter, it is the first order CIC filter).
+    //The sensor can run at factor times the link rate, and the averaging reduces
+    //the noise and suppresses aliasing instead of dropping samples.
+    //
+    //factor - number of the device samples in one output sample, a power of 2,
+    //         the factor 1 is the next provider itself
+    //Next - sample provider that converts the samples, e.g. SimpleProvider or TransformProvider<...>::Provider
+    //
+    //Usage:
+    //    DecimationProvider<4, TransformProvider<eeprom_type, eeprom>::Provider>::Provider
+    template <uint8_t factor, template <typename> class Next>
+    struct DecimationProvider {
+        static_assert(factor != 0 && mpl::is_pow2<factor>::value, "The decimation factor should be a power of 2");
+
+        template <typename Device>
+        class Provider : public Next<Device>
+        {
+            typedef Next<Device> base_type;
+            using base_type::device;
+
+            static const uint8_t shift = mpl::log2<factor>::value;
+
+            int32_t sum[3];
+            uint8_t count;
+
+        public:
+            //The device ODR can be factor times higher than the output rate
+            static const uint8_t decimation_factor = factor;
+
+            Provider()
+            {
+                resetDecimation();
+            }
+
+            //Discards the accumulated samples.
+            //It should be called after changing the device settings.
+            void resetDecimation() {
+                memset(sum, 0, sizeof(sum));
+                count = 0;
+            }
+
+            //Adds the sample in MCU byte order.
+            //Returns true and replaces the sample with the average when the output sample is ready.
+            bool decimate(int16_t (&sample)[3]) {
+                for (uint8_t i = 0; i < 3; ++i) {
+                    sum[i] += sample[i];
+                }
+                if (++count < factor)
+                    return false;
+
+                for (uint8_t i = 0; i < 3; ++i) {
+                    //Rounding to the nearest integer
+                    sample[i] = int16_t((sum[i] + (factor / 2)) >> shift);
+                }
+                resetDecimation();
+                return true;
+            }
+
+            //Reads the device sample and puts the output sample into the data buffer when it is ready.
+            //Returns false if the output sample is not ready yet.
+            INLINE bool readSample(uint8_t* data, uint8_t size) {
+                int16_t sample[3];
+                if (size == sizeof(sample)) {
+                    device.readSample((uint8_t*)sample, sizeof(sample));
+                    base_type::toNative(sample);
+                    if (decimate(sample)) {
+                        base_type::fromNative(sample, data);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+    };
+
+    //The samples are passed through, so the build option can select no decimation without the cost
+    template <template <typename> class Next>
+    struct DecimationProvider<1, Next> {
+        template <typename Device>
+        class Provider : public Next<Device>
+        {
+        };
+    };
+
+}
+
+#endif //__SENSORS_DECIMATION_PROVIDER_H
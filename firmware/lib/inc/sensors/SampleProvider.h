@@ -2,6 +2,7 @@
 #define __SENSORS_SAMPLE_PROVIDER_H
 
 #include <stdint.h>
+#include <utils/profiler.h>
 
 namespace sensors {
     template <typename Device, typename Impl>
@@ -49,6 +50,16 @@ namespace sensors {
             device.setScale(currentScale = scale);
         }
 
+        //Returns the current full scale range
+        INLINE Scale getScale() const {
+            return currentScale;
+        }
+
+        //Changes the output data rate
+        INLINE void setODR(ODR odr) {
+            device.setODR(odr);
+        }
+
         //Checks if the device works correctly
         INLINE bool checkDevice() const {
             return device.checkDevice();
@@ -59,14 +70,56 @@ namespace sensors {
             return device.isNewDataAvailable();
         }
 
-        INLINE void readSample(uint8_t* data, uint8_t size) const {
+        //Returns true if the sample has been placed into the data buffer.
+        //A decimating provider returns false until the output sample is ready.
+        INLINE bool readSample(uint8_t* data, uint8_t size) const {
             device.readSample(data, size);
+            PROFILE_STAGE(ProfileSpiRead);
             getImpl()->convertSample(data, size);
+            PROFILE_STAGE(ProfileTransform);
+            return true;
+        }
+
+        //Decimation stage. The samples are passed through by default (see DecimationProvider.h).
+        static const uint8_t decimation_factor = 1;
+
+        INLINE bool decimate(int16_t (&)[3]) {
+            return true;
+        }
+
+        INLINE void resetDecimation() {
         }
 
         INLINE void updateEeprom(Scale scale, const uint8_t* data, uint8_t size) {
         }
 
+        //Checks the calibration data. Returns false if the provider uses
+        //the identity transformation instead of the damaged data (see ThermalTransformProvider.h)
+        INLINE bool validateEeprom() {
+            return true;
+        }
+
+        //Passes the die temperature to the correction (see ThermalTransformProvider.h)
+        INLINE void setTemperature(int16_t temperature) {
+        }
+
+        //Shifts the output samples by the offset in output digits.
+        //Returns false if the provider cannot keep the offset (see TransformProvider.h).
+        INLINE bool adjustOffset(const int16_t (&offset)[3]) {
+            return false;
+        }
+
+        //Bias tracking stage. The device reports no motion and tracks no bias by default (see BiasTrackingProvider.h).
+        INLINE bool isMoving() const {
+            return false;
+        }
+
+        INLINE void setMotion(bool motion) {
+        }
+
+        INLINE void saveBias() {
+        }
+
     };
 
 }
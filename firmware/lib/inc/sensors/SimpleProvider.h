@@ -2,6 +2,7 @@
 #define __SENSORS_SIMPLE_PROVIDER_H
 
 #include <sensors/SampleProvider.h>
+#include <utils/byte_order.h>
 
 namespace sensors {
 
@@ -17,6 +18,23 @@ namespace sensors {
 
         INLINE void convertSample(uint8_t* data, uint8_t size) const {
         }
+
+    public:
+        //Converts the sample read from the device to MCU byte order.
+        //The device produces samples in little-endian format.
+        INLINE void toNative(int16_t (&sample)[3]) const {
+            PROFILE_STAGE(ProfileSpiRead);
+            swap_sample(sample);
+        }
+
+        //Puts the sample in MCU byte order into the output buffer in little-endian format
+        INLINE void fromNative(const int16_t (&sample)[3], uint8_t* data) const {
+            int16_t* result = (int16_t*)data;
+            result[0] = swap_bytes(sample[0]);
+            result[1] = swap_bytes(sample[1]);
+            result[2] = swap_bytes(sample[2]);
+            PROFILE_STAGE(ProfileTransform);
+        }
     };
 
 }
@@ -0,0 +1,162 @@
+#ifndef __SENSORS_THERMAL_TRANSFORM_PROVIDER_H
+#define __SENSORS_THERMAL_TRANSFORM_PROVIDER_H
+
+#include <string.h>
+#include <mpl/if.h>
+#include <sensors/SampleProvider.h>
+#include <sensors/TransformProvider.h>
+#include <sensors/traits/has_big_endian.h>
+#include <math/correction.h>
+#include <stm8/eeprom.h>
+
+namespace sensors {
+
+    //Usage of metafunction class allows us to bind an external Eeprom implemenetation.
+    //The EEPROM data of each device keeps the matrices calibrated at several die temperatures
+    //(see math::ThermalTransformation).
+    //
+    //temperature_step - the matrix is interpolated again when the temperature changes by this value
+    template <typename Eeprom, Eeprom& eeprom, uint8_t temperature_step = 8>
+    struct ThermalTransformProvider {
+
+        //Sample provider that corrects samples using the transformation matrix
+        //interpolated for the die temperature
+        template <typename Device>
+        class Provider : public SampleProvider<Device, Provider<Device> >
+        {
+            friend class SampleProvider<Device, Provider<Device> >;
+
+            typedef SampleProvider<Device, Provider<Device> > base_type;
+        protected:
+            using base_type::device;
+            using typename base_type::Scale;
+        private:
+            typedef math::ThermalTransformation<Eeprom, eeprom, Device> transformation_type;
+            typedef typename transformation_type::data_type data_type;
+
+            transformation_type transformation;
+            //Die temperature of the current matrix
+            int16_t temperature;
+
+            //Select byte order conversion strategy. Only the big-endian MCU switches the device to big-endian,
+            //the samples of a little-endian host are already in its byte order.
+            typedef typename mpl::if_c<traits::has_big_endian<Device>::value && utils::NativeEndianness == utils::BigEndian,
+                details::BigEndianDevice, details::BigEndianMcu>::type big_endian_conversion;
+
+            static const uint8_t MATRIX_BYTES = math::VectorCorrection::MATRIX_SIZE * sizeof(int16_t);
+
+        protected:
+            //Init the sensor to returning samples in big-endian format
+            INLINE void initDevice() {
+                big_endian_conversion::init(device);
+                transformation.update(base_type::currentScale, temperature);
+            }
+
+        public:
+            //The calibration record sent by the host: the matrix, the die temperature
+            //of the calibration and the point index. The points should be written
+            //in the temperature order, writing the point N discards the points above it.
+            static const uint8_t RECORD_SIZE = MATRIX_BYTES + 2 * sizeof(int16_t);
+
+            Provider()
+                : temperature(0)
+            {
+            }
+
+            //Updates the sensor's full scale range and interpolates the matrix for it
+            INLINE void setScale(Scale scale) {
+                base_type::setScale(scale);
+                transformation.update(scale, temperature);
+            }
+
+            //Checks the calibration data of the device. The damaged or missing data
+            //selects the identity transformation until the host writes the calibration.
+            bool validateEeprom() {
+                bool valid = transformation.validate();
+                transformation.update(base_type::currentScale, temperature);
+                return valid;
+            }
+
+            //Selects the matrix for the die temperature. It should be called at a low rate.
+            void setTemperature(int16_t value) {
+                int16_t delta = value - temperature;
+                if (delta >= temperature_step || delta <= -int16_t(temperature_step)) {
+                    temperature = value;
+                    transformation.update(base_type::currentScale, temperature);
+                }
+            }
+
+            //Overrides and replaces readSample from base class to
+            //avoid redundant data copying
+            INLINE bool readSample(uint8_t* data, uint8_t size) const {
+                int16_t sample[3];
+                if (size == sizeof(sample)) {
+                    device.readSample((uint8_t*)sample, sizeof(sample));
+                    toNative(sample);
+                    fromNative(sample, data);
+                }
+                return true;
+            }
+
+            //Converts the sample read from the device to MCU byte order
+            INLINE void toNative(int16_t (&sample)[3]) const {
+                PROFILE_STAGE(ProfileSpiRead);
+                big_endian_conversion::convert(sample);
+            }
+
+            //Corrects the sample in MCU byte order and puts the result into the output buffer
+            INLINE void fromNative(const int16_t (&sample)[3], uint8_t* data) const {
+                transformation.transform(sample, (int16_t*)data);
+                PROFILE_STAGE(ProfileTransform);
+            }
+
+            //Writes the calibration record (see RECORD_SIZE)
+            void updateEeprom(Scale scale, const uint8_t* data, uint8_t size) {
+                if (size < RECORD_SIZE)
+                    return;
+                //The record words are in MCU byte order
+                int16_t point = ((const int16_t*)data)[math::VectorCorrection::MATRIX_SIZE + 1];
+                if (point < 0 || point >= data_type::temperature_points)
+                    return;
+
+                data_type& calibration = eeprom.template get<Device>();
+                uint8_t points = uint8_t(point) + 1;
+
+                stm8::EepromWriter writer;
+                writer.write((uint8_t*)calibration.get(scale, point), data, MATRIX_BYTES);
+                writer.write((uint8_t*)calibration.temperature(scale, point), data + MATRIX_BYTES, sizeof(int16_t));
+                writer.write(calibration.points(scale), &points, sizeof(points));
+                calibration.seal(writer);
+                validateEeprom();
+            }
+
+            //Shifts the output samples of the current scale by the offset in output digits.
+            //All calibration points get the same offset, so it is kept for any temperature.
+            //The damaged calibration data is not changed.
+            bool adjustOffset(const int16_t (&offset)[3]) {
+                if (!transformation.valid)
+                    return false;
+
+                data_type& calibration = eeprom.template get<Device>();
+                uint8_t points = *calibration.points(base_type::currentScale);
+                if (points == 0)
+                    points = 1;
+
+                stm8::EepromWriter writer;
+                for (uint8_t point = 0; point < points && point < data_type::temperature_points; ++point) {
+                    int16_t matrix[math::VectorCorrection::MATRIX_SIZE];
+                    uint8_t* target = (uint8_t*)calibration.get(base_type::currentScale, point);
+                    memcpy(matrix, target, sizeof(matrix));
+                    math::VectorCorrection::addOffset(matrix, offset);
+                    writer.write(target, (const uint8_t*)matrix, sizeof(matrix));
+                }
+                calibration.seal(writer);
+                validateEeprom();
+                return true;
+            }
+        };
+    };
+
+}
+
+#endif //__SENSORS_THERMAL_TRANSFORM_PROVIDER_H
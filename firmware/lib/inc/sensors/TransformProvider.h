@@ -1,6 +1,7 @@
 #ifndef __SENSORS_TRANSFORM_PROVIDER_H
 #define __SENSORS_TRANSFORM_PROVIDER_H
 
+#include <string.h>
 #include <mpl/if.h>
 #include <mpl/var.h>
 #include <sensors/SampleProvider.h>
@@ -31,7 +32,7 @@ namespace sensors {
         struct BigEndianMcu {
             //Switch device to big-endian mode
             template <typename Device>
-            static void init(Device& device) {
+            static void init(Device&) {
             }
 
             //Uses MCU to convert data to big-endian format
@@ -54,6 +55,7 @@ namespace sensors {
             friend class SampleProvider<Device, Provider<Device> >;
 
             typedef SampleProvider<Device, Provider<Device> > base_type;
+        protected:
             using base_type::device;
             using typename base_type::Scale;
         private:
@@ -61,13 +63,16 @@ namespace sensors {
 
             typedef uint8_t* pbyte;
 
-            //Select byte order conversion strategy
-            typedef typename mpl::if_<traits::has_big_endian<Device>, details::BigEndianDevice, details::BigEndianMcu>::type big_endian_conversion;
+            //Select byte order conversion strategy. Only the big-endian MCU switches the device to big-endian,
+            //the samples of a little-endian host are already in its byte order.
+            typedef typename mpl::if_c<traits::has_big_endian<Device>::value && utils::NativeEndianness == utils::BigEndian,
+                details::BigEndianDevice, details::BigEndianMcu>::type big_endian_conversion;
 
         protected:
             //Init the sensor to returning samples in big-endian format
             INLINE void initDevice() {
                 big_endian_conversion::init(device);
+                transformation.update(base_type::currentScale);
             }
 
             //We use explicit offset calculation here to use 8-bit multiplictaion operation
@@ -83,25 +88,54 @@ namespace sensors {
             {
             }
 
+            //Updates the sensor's full scale range and selects the matrix kernel for it
+            INLINE void setScale(Scale scale) {
+                base_type::setScale(scale);
+                transformation.update(scale);
+            }
+
             //Overrides and replaces readSample from base class to
             //avoid redundant data copying
-            INLINE void readSample(uint8_t* data, uint8_t size) const {
+            INLINE bool readSample(uint8_t* data, uint8_t size) const {
                 int16_t sample[3];
                 if (size == sizeof(sample)) {
                     device.readSample((uint8_t*)sample, sizeof(sample));
+                    toNative(sample);
+                    fromNative(sample, data);
+                }
+                return true;
+            }
 
-                    //Convert sample to big-endian format if the device doesn't
-                    //support big endian sample format. We need big-endian format
-                    //because STM8 has big-endian architecture
-                    big_endian_conversion::convert(sample);
+            //Converts the sample read from the device to MCU byte order
+            INLINE void toNative(int16_t (&sample)[3]) const {
+                PROFILE_STAGE(ProfileSpiRead);
+                //Convert sample to big-endian format if the device doesn't
+                //support big endian sample format. We need big-endian format
+                //because STM8 has big-endian architecture
+                big_endian_conversion::convert(sample);
+            }
 
-                    transformation.transform(base_type::currentScale, sample, (int16_t*)data);
-                }
+            //Corrects the sample in MCU byte order and puts the result into the output buffer
+            INLINE void fromNative(const int16_t (&sample)[3], uint8_t* data) const {
+                transformation.transform(base_type::currentScale, sample, (int16_t*)data);
+                PROFILE_STAGE(ProfileTransform);
             }
 
             INLINE void updateEeprom(Scale scale, const uint8_t* data, uint8_t size) {
                 stm8::EepromWriter writer;
                 writer.write(getDeviceMatrix(scale), data, size);
+                if (scale == base_type::currentScale)
+                    transformation.update(scale);
+            }
+
+            //Shifts the output samples of the current scale by the offset in output digits.
+            //The offset row of the matrix is rewritten, so the offset is kept after power off.
+            bool adjustOffset(const int16_t (&offset)[3]) {
+                int16_t matrix[math::VectorCorrection::MATRIX_SIZE];
+                memcpy(matrix, getDeviceMatrix(base_type::currentScale), sizeof(matrix));
+                math::VectorCorrection::addOffset(matrix, offset);
+                updateEeprom(base_type::currentScale, (const uint8_t*)matrix, sizeof(matrix));
+                return true;
             }
         };
     };
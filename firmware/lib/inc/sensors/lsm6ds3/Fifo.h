@@ -0,0 +1,140 @@
+#ifndef __LSM6DS3_FIFO_H
+#define __LSM6DS3_FIFO_H
+
+#include <stddef.h>
+#include <sensors/spi_transport.h>
+#include <sensors/lsm6ds3/ImuBase.h>
+
+namespace sensors {
+namespace lsm6ds3 {
+
+    //FIFO driver for LSM6DS3
+    //The FIFO keeps gyroscope and accelerometer samples without decimation.
+    //Each data set (pattern) consists of 6 words: gyro X, Y, Z and then accel X, Y, Z.
+    //The words have the same byte order as the output registers (see CTRL3_C BLE bit).
+    template <typename Transport>
+	class Fifo : public ImuBase {
+    private:
+        struct Bitmasks {
+            //FIFO_CTRL2
+            static const uint8_t ThresholdHigh = 0x0F;
+            //FIFO_STATUS2
+            static const uint8_t UnreadHigh = 0x0F;
+            static const uint8_t Empty = 0x10;
+            static const uint8_t Full = 0x20;
+            static const uint8_t Overrun = 0x40;
+            static const uint8_t Threshold = 0x80;
+            //FIFO_STATUS4
+            static const uint8_t PatternHigh = 0x03;
+        };
+
+        struct Bitfields {
+            //FIFO_CTRL3
+            static const uint8_t NoDecimation = 0x09; //Gyro and accel samples are stored without decimation
+            //FIFO_CTRL5
+            static const uint8_t Bypass = 0x00;
+            static const uint8_t Continuous = 0x06;
+            //INT1_CTRL
+            static const uint8_t ThresholdInterrupt = 0x08;
+        };
+
+    public:
+        // ODR defines the FIFO output data rate. It should be equal to the ODR of the sensors.
+        enum ODR
+        {
+            ODR_13Hz 		 = 0x10,
+            ODR_26Hz 		 = 0x20,
+            ODR_52Hz 		 = 0x30,
+            ODR_104Hz 		 = 0x40,
+            ODR_208Hz 		 = 0x50,
+            ODR_416Hz 		 = 0x60,
+            ODR_833Hz 		 = 0x70,
+            ODR_1660Hz 		 = 0x80,
+            ODR_3330Hz 		 = 0x90,
+            ODR_6660Hz 		 = 0xA0
+        };
+
+        //Number of words in one data set
+        static const uint8_t PATTERN_LENGTH = 6;
+        //Size of one data set in bytes
+        static const uint8_t PATTERN_SIZE = PATTERN_LENGTH * sizeof(int16_t);
+
+        //Content of FIFO_STATUS1..FIFO_STATUS4 registers
+        struct Status {
+            uint8_t data[4];
+
+            //Returns the number of unread words
+            uint16_t unread() const {
+                return (uint16_t(data[1] & Bitmasks::UnreadHigh) << 8) | data[0];
+            }
+
+            //Returns true if the data has been overwritten because of full FIFO
+            bool isOverrun() const {
+                return (data[1] & Bitmasks::Overrun) != 0;
+            }
+
+            //Returns the index of the next word in the data set
+            uint16_t pattern() const {
+                return (uint16_t(data[3] & Bitmasks::PatternHigh) << 8) | data[2];
+            }
+        };
+
+    private:
+        Transport transport;
+
+        //Writes FIFO_CTRL1 - FIFO_CTRL5 registers
+        void configure(uint16_t threshold, uint8_t mode) {
+            uint8_t data[5] = {
+                uint8_t(threshold),
+                uint8_t((threshold >> 8) & Bitmasks::ThresholdHigh),
+                Bitfields::NoDecimation,
+                0,
+                mode
+            };
+            transport.writeBytes(Registers::FIFO_CTRL1, data, sizeof(data));
+        }
+
+    public:
+        // Initialize the FIFO in continuous mode.
+        // Input:
+        //	- odr = FIFO output data rate.
+        //	- patterns = number of data sets in the FIFO that generates the threshold interrupt on INT1 pin
+        void init(ODR odr, uint8_t patterns) {
+            //FIFO_CTRL5 keeps ODR in bits 3-6
+            configure(uint16_t(patterns) * PATTERN_LENGTH, uint8_t(odr >> 1) | Bitfields::Continuous);
+            transport.writeByte(Registers::INT1_CTRL, Bitfields::ThresholdInterrupt);
+        }
+
+        //Turns off the FIFO. The FIFO content is discarded.
+        void reset() {
+            transport.writeByte(Registers::FIFO_CTRL5, Bitfields::Bypass);
+            transport.writeByte(Registers::INT1_CTRL, 0);
+        }
+
+        //Discards the FIFO content and continues collecting the data.
+        //It is used to restore the data set alignment after FIFO overrun.
+        void restart() {
+            uint8_t mode = transport.readByte(Registers::FIFO_CTRL5);
+            transport.writeByte(Registers::FIFO_CTRL5, Bitfields::Bypass);
+            transport.writeByte(Registers::FIFO_CTRL5, mode);
+        }
+
+        //Reads FIFO status registers
+        void getStatus(Status& status) const {
+            transport.readBytes(Registers::FIFO_STATUS1, status.data, sizeof(status.data));
+        }
+
+        //Reads the specified number of data sets in one burst.
+        //The FIFO output registers address is rolled back automatically,
+        //so all data sets are read from FIFO_DATA_OUT_L/H.
+        //The handler is called for each data set placed into the dest buffer.
+        template <typename Handler>
+        void readPatterns(int16_t (&dest)[PATTERN_LENGTH], uint8_t count, Handler& handler) const {
+            transport.readBlocks(Registers::FIFO_DATA_OUT_L, (uint8_t*)dest, PATTERN_SIZE, count, handler);
+        }
+	};
+}
+}
+
+
+#endif //__LSM6DS3_FIFO_H
@@ -33,6 +33,8 @@ namespace lsm6ds3 {
             static const uint8_t GyroDataAvailable = 0x02;
             static const uint8_t TempDataAvailable = 0x04;
             static const uint8_t BootRunning = 0x08;
+            //CTRL3_C
+            static const uint8_t BigEndian = 0x02;
         };
 
         struct Bitfields {
@@ -48,6 +50,13 @@ namespace lsm6ds3 {
             static const uint8_t DataReadyMask = 0x08;
             //CTRL3_C
             static const uint8_t Reset = 0x01;
+            static const uint8_t BlockDataUpdate = 0x40;
+            //TAP_CFG1
+            static const uint8_t TimerEnable = 0x80;
+            //WAKE_UP_DUR
+            static const uint8_t TimerHighResolution = 0x10; //25us per tick instead of 6.4ms
+            //TIMESTAMP2_REG
+            static const uint8_t TimestampReset = 0xAA;
         };
 
     public:
@@ -115,12 +124,30 @@ namespace lsm6ds3 {
             InterruptEnabled      = 3 //Accel and Gyro interrupts are enabled
         };
 
+        //Content of the output registers from STATUS_REG to OUTZ_H_XL.
+        //The registers are contiguous, so they can be read in one burst.
+        //The samples use the byte order configured by CTRL3_C BLE bit.
+        struct Sample {
+            uint8_t status;
+            uint8_t reserved;
+            int16_t temperature;
+            int16_t gyro[3];
+            int16_t accel[3];
+        };
+
     private:
         Transport transport;
 
     public:
         static const uint8_t DEVICE_ID = 0x69;
 
+        //Size of the timestamp counter in bytes
+        static const uint8_t TIMESTAMP_SIZE = 3;
+        //Timestamp counter resolution in the high resolution mode
+        static const uint8_t TIMESTAMP_TICK_US = 25;
+        //Temperature sensor sensitivity, the zero value is 25 degrees
+        static const uint8_t TEMPERATURE_LSB_PER_DEGREE = 16;
+
         //Returns the device identifier
         uint8_t getId() {
             return transport.readByte(Registers::WHO_AM_I);   // Read the WHO_AM_I register
@@ -238,6 +265,44 @@ namespace lsm6ds3 {
             out.assign(temp);
         }
 
+        //Reads status, temperature, gyro and accel samples in one burst
+        void readAll(Sample& sample) {
+            static_assert(sizeof(Sample) == Registers::OUTZ_H_XL - Registers::STATUS_REG + 1, "Unexpected sample layout");
+            transport.readBytes(Registers::STATUS_REG, (uint8_t*)&sample, sizeof(sample));
+        }
+
+        //Prevents updating of the output registers until both bytes of the sample are read
+        void enableBlockDataUpdate() {
+            transport.writeByteWithMask(Registers::CTRL3_C, Bitfields::BlockDataUpdate, Bitfields::BlockDataUpdate);
+        }
+
+        //Starts the timestamp counter from zero with 25us resolution.
+        //The 24-bit counter wraps around in about 419 seconds.
+        void enableTimestamp() {
+            transport.writeByteWithMask(Registers::WAKE_UP_DUR, Bitfields::TimerHighResolution, Bitfields::TimerHighResolution);
+            transport.writeByteWithMask(Registers::TAP_CFG1, Bitfields::TimerEnable, Bitfields::TimerEnable);
+            transport.writeByte(Registers::TIMESTAMP2_REG, Bitfields::TimestampReset);
+        }
+
+        //Stops the timestamp counter
+        void disableTimestamp() {
+            transport.writeByteWithMask(Registers::TAP_CFG1, 0, Bitfields::TimerEnable);
+        }
+
+        //Reads TIMESTAMP0_REG..TIMESTAMP2_REG. The least significant byte is the first.
+        void readTimestamp(uint8_t* out) {
+            transport.readBytes(Registers::TIMESTAMP0_REG, out, TIMESTAMP_SIZE);
+        }
+
+        //Reads the die temperature and converts it to MCU byte order.
+        //The output registers use the byte order configured by CTRL3_C BLE bit.
+        int16_t readTemperature() {
+            uint8_t data[2];
+            bool bigEndian = (transport.readByte(Registers::CTRL3_C) & Bitmasks::BigEndian) != 0;
+            transport.readBytes(Registers::OUT_TEMP_L, data, sizeof(data));
+            return bigEndian ? int16_t((data[0] << 8) | data[1]) : int16_t((data[1] << 8) | data[0]);
+        }
+
         //Reads sensor's memory starting from OUTX_L_XL address
         void readAccelSample(uint8_t* out, size_t size) {
             transport.readBytes(Registers::OUTX_L_XL, out, size);
@@ -15,7 +15,7 @@ namespace lsm6ds3 {
         }
 
         //Auto increment bit is not needed 
-        static uint8_t auto_increment(uint8_t count) {
+        static uint8_t auto_increment(uint8_t) {
 			return 0;
         }
 
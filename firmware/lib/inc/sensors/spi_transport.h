@@ -1,11 +1,23 @@
 #ifndef __SENSORS_SPI_TRANSPORT_H
 #define __SENSORS_SPI_TRANSPORT_H
 
+#include <stdint.h>
+#include <utils/inline.h>
+
 namespace sensors {
 
 
     //Base class contains core SPI read/write methods.
     //It was extracted from SpiTransport to reduce code blowing
+    //
+    //Spi is a type with the static method
+    //    uint8_t transaction(uint8_t data) - sends a byte and returns the byte received in full-duplex mode
+    //stm8::SPI implements it for the hardware peripheral. Any other type with the same
+    //method, e.g. a software model of the sensor registers, can be used instead.
+    //
+    //AddressStrategy is a type with the static methods
+    //    uint8_t normalize(uint8_t address) - selects significant part of the register address
+    //    uint8_t auto_increment(uint8_t count) - returns the address bits for multiple byte access
     template <typename Spi, typename AddressStrategy>
     class SpiTransportBase {
         static const uint8_t READ_MASK = 0x80;
@@ -44,6 +56,21 @@ namespace sensors {
             return count;
         }
 
+        //Reads count blocks of the specified size in one burst starting from the specified address.
+        //Each block is placed into dest and passed to the handler before reading the next one,
+        //so the caller needs the buffer only for one block.
+        template <typename Handler>
+        void readBlocks(uint8_t address, uint8_t* dest, uint8_t size, uint8_t count, Handler& handler) const {
+            Spi::transaction(READ_MASK | auto_increment(size) | normalize(address));
+
+            for (; count != 0; --count) {
+                for (uint8_t i = 0; i < size; ++i) {
+                    dest[i] = Spi::transaction(0);
+                }
+                handler(dest);
+            }
+        }
+
         //Writes one byte to the sensor by the address
         void writeByte(uint8_t address, uint8_t value) {
             // If write, bit 7 (MSB) should be 0
@@ -66,6 +93,11 @@ namespace sensors {
 
 
 
+    //SPI transport with the slave chip selection.
+    //
+    //SelectPin is a default constructible type with methods on() and off().
+    //on() is called before each register access and off() after it, so the pin
+    //marks the boundaries of the SPI transactions.
     template <typename Spi, typename SelectPin, typename AddressStrategy>
     class SpiTransport : public SpiTransportBase<Spi, AddressStrategy> {
         typedef SpiTransportBase<Spi, AddressStrategy> base_type;
@@ -84,6 +116,11 @@ namespace sensors {
         };
 
     public:
+        //Returns the error flags of the SPI peripheral (see stm8::SPI::get_errors)
+        static uint8_t getErrors() {
+            return Spi::get_errors();
+        }
+
         //reads one byte by the specified address
         uint8_t readByte(uint8_t address) const {
             ChipSelector cs;
@@ -98,6 +135,14 @@ namespace sensors {
             return base_type::readBytes(address, dest, count);
         }
 
+        //Reads count blocks of the specified size in one burst starting from the specified address
+        template <typename Handler>
+        void readBlocks(uint8_t address, uint8_t* dest, uint8_t size, uint8_t count, Handler& handler) const {
+            ChipSelector cs;
+
+            base_type::readBlocks(address, dest, size, count, handler);
+        }
+
         //Writes one byte to the sensor by the address
         void writeByte(uint8_t address, uint8_t value) {
             ChipSelector cs;
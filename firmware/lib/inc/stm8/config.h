@@ -2,9 +2,7 @@
 #define __STM8_CONFIG_H
 
 
-#ifndef INLINE
-#define INLINE _Pragma("inline=forced") inline
-#endif
+#include <utils/inline.h>
 
 
-#endif //__STM8_CONFIG_H
\ No newline at end of file
+#endif //__STM8_CONFIG_H
@@ -1,9 +1,13 @@
 #ifndef __STM8_EEPROM_H
 #define __STM8_EEPROM_H
 
+#include <stdint.h>
+#include <string.h>
+#include <os_services.h>
 #include <mpl/fold.h>
 #include <mpl/returns.h>
 #include <utils/copy.h>
+#include <utils/inline.h>
 #include <stm8s_flash.h>
 
 namespace stm8 {
@@ -56,23 +60,31 @@ namespace stm8 {
         struct apply : mpl::returns< EepromData<Tag> > {};
     };
 
-    //Enables write access to EEPROM
+    //Enables write access to EEPROM.
+    //The data is programmed by blocks: one block operation takes the same time
+    //as programming a single word, so a matrix is written several times faster.
     class EepromWriter {
     private:
-        void writeDword(uint16_t* dest, const uint16_t* src) {
-          // Enable Word Write Once
-          FLASH()->CR2 |= FLASH_CR2_WPRG;
-          FLASH()->NCR2 &= (uint8_t)(~FLASH_NCR2_NWPRG);
-
-          dest[0] = src[0]; // Write two bytes - from lowest address
-          dest[1] = src[1]; // Write two bytes - from higher address
-
-          //Does not have effect on low density stm8, because they don't have
-          //Read-While-Write (RWW) capability
-#if !defined(STM8S103) && !defined(STM8S003) && !defined(STM8S903) && !defined(STM8AF622x)
-          while ((FLASH()->IAPSR & FLASH_IAPSR_EOP) == 0) {
-          }
-#endif
+        static const uint8_t BLOCK_SIZE = FLASH_BLOCK_SIZE;
+
+        //The block image is prepared before the programming sequence,
+        //so the sequence does not read the EEPROM
+        static uint8_t stage[BLOCK_SIZE];
+
+        //Loads the staged block and waits for the end of its programming.
+        //The devices without Read-While-Write capability cannot read the program memory
+        //while the block is programmed, so the function is executed from RAM
+        //and does not call any other functions.
+        //mode - FLASH_CR2_PRG (erase and write) or FLASH_CR2_FPRG (write the erased block)
+        static RAMFUNC void programBlock(uint8_t* block, uint8_t mode);
+
+        //The erased EEPROM contains zeros, it can be written without the erase cycle
+        static bool isErased(const uint8_t* block) {
+            for (uint8_t i = 0; i < BLOCK_SIZE; ++i) {
+                if (block[i] != 0)
+                    return false;
+            }
+            return true;
         }
 
     public:
@@ -86,20 +98,30 @@ namespace stm8 {
             FLASH()->IAPSR &= (uint8_t)FLASH_MEMTYPE_DATA;
         }
 
-        //Writes the data block using packet writing
+        //Writes the data using block programming.
+        //The blocks that already contain the data are not programmed.
         void write(uint8_t* dest, const uint8_t* src, uint8_t size) {
-            uint8_t dwords = size >> 2;
-            uint8_t tail = size & 3;
-
-            while (dwords > 0) {
-                writeDword((uint16_t*)dest, (const uint16_t*)src);
-                dest += 4;
-                src  += 4;
-                --dwords;
-            }
-            while (tail > 0) {
-                *dest++ = *src++;
-                --tail;
+            while (size > 0) {
+                uint8_t offset = uint8_t(uintptr_t(dest)) & (BLOCK_SIZE - 1);
+                uint8_t part = BLOCK_SIZE - offset;
+                if (part > size)
+                    part = size;
+
+                if (memcmp(dest, src, part) != 0) {
+                    uint8_t* block = dest - offset;
+                    uint8_t mode = isErased(block) ? FLASH_CR2_FPRG : FLASH_CR2_PRG;
+                    //The bytes outside the part keep their current values
+                    memcpy(stage, block, BLOCK_SIZE);
+                    memcpy(stage + offset, src, part);
+                    //The interrupt vectors are in the program memory,
+                    //so the interrupts are disabled only while the block is programmed
+                    TCritSect cs;
+                    programBlock(block, mode);
+                }
+
+                dest += part;
+                src  += part;
+                size -= part;
             }
         }
 
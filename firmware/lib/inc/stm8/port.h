@@ -70,7 +70,7 @@ namespace stm8 {
 
         struct GPIO
         {
-            GPIO_TypeDef* operator-> () { return (GPIO_TypeDef*)GPIOx_BASE; }
+            GPIO_TypeDef* operator-> () { return STM8_PERIPHERAL(GPIO_TypeDef, GPIOx_BASE); }
 		};
 
 		static GPIO GPIOx;
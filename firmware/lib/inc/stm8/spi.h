@@ -11,7 +11,17 @@ namespace stm8 {
     template <typename Config>
     class SPI
     {
+        //Status register flags accumulated by the transactions
+        static uint8_t status;
+
     public:
+        //Error flags of the status register (SPI_ERROR_FLAGS) seen since the start.
+        //Collecting them costs one OR per byte. SPI::checkError of stm8/spi_stm8s.h
+        //is not used, because it converts the flags into one error code per byte.
+        static uint8_t get_errors() {
+            return status & SPI_ERROR_FLAGS;
+        }
+
         INLINE static void init() {
             Config::reset();
 			Config::configure();
@@ -51,7 +61,9 @@ namespace stm8 {
             ::SPI()->DR = data;
 
             // Waiting for putting incoming data into DR register
-            while ((::SPI()->SR & SPI_FLAG_RXNE) == RESET) { ; }
+            uint8_t sr;
+            while (((sr = ::SPI()->SR) & SPI_FLAG_RXNE) == RESET) { ; }
+            status |= sr;
 
             // Return the data in the DR register
             return ::SPI()->DR;
@@ -60,6 +72,9 @@ namespace stm8 {
 
 
     };
+
+    template <typename Config>
+    uint8_t SPI<Config>::status = 0;
 }
 
 #endif //__STM8_SPI_H
@@ -95,6 +95,10 @@ namespace stm8 {
         static const uint8_t mask = 1 << (interrupt & 0x0F);
     };
 
+    //Error flags of the status register: master mode fault, overrun and CRC error.
+    //SPI::checkError (stm8/spi_stm8s.h) tests the same flags.
+    static const uint8_t SPI_ERROR_FLAGS = SPI_FLAG_MODF | SPI_FLAG_OVR | SPI_FLAG_CRCERR;
+
 }
 
 
@@ -12,6 +12,7 @@ namespace stm8 {
     class SPI: public hal::SPI
     {
 	protected:
+	    //Tests SPI_ERROR_FLAGS (spi/spi_def.h), the last one set gives the error code
 	    static Error checkError(uint8_t statusReg) {
 	        Error error = NO_ERROR;
 
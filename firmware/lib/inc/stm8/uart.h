@@ -3,6 +3,7 @@
 
 #include <os_services.h>
 #include <stm8/uart/uart_base.h>
+#include <stm8/uart/uart_transmitter.h>
 #include <utils/ring_buffer.h>
 #include <utils/blocking_queue.h>
 #include <utils/inline.h>
@@ -10,13 +11,29 @@
 namespace stm8 {
 
     struct EmptyDiagnostic {
-        static void receive(uint8_t byte) {}
+        static void receive(uint8_t) {}
+    };
+
+    //Wakes up the receiving process on each byte
+    struct ByteFraming {
+        void reset() {}
+        bool receive(uint8_t) { return true; }
     };
 
     //UART class with interrupt handlers and FIFO buffers
-    template <UartType type, size_t buffer_size, typename Diagnostic = EmptyDiagnostic>
-    class Uart : public UartBase<type> {
+    //
+    //buffer_size - size of the receive buffer
+    //tx_buffer_size - size of the transmit buffer. Zero selects the direct transmitter
+    //                 that sends the data from the caller's buffer. Otherwise the whole
+    //                 frames are copied into the transmit ring buffer and the send calls
+    //                 return immediately (see stm8/uart/uart_transmitter.h).
+    //Framing - splits the received bytes into messages. The receive interrupt resumes the waiting
+    //          process only when Framing::receive(byte) returns true, that is the message is complete.
+    //          The byte dropped by the full buffer resets the framing and resumes the process.
+    template <UartType type, size_t buffer_size, typename Diagnostic = EmptyDiagnostic, size_t tx_buffer_size = 0, typename Framing = ByteFraming>
+    class Uart : public UartTransmitter<type, tx_buffer_size> {
     private:
+        typedef UartTransmitter<type, tx_buffer_size> transmitter_type;
         typedef UartBase<type> uart_base;
         using uart_base::uart_type;
         using uart_base::UARTx;
@@ -26,17 +43,17 @@ namespace stm8 {
         typedef typename uart_rx_buffer_type::size_type size_type;
 
         uart_rx_buffer_type uart_rx_buffer;
-
-        const uint8_t* tx_iterator;
-        const uint8_t* tx_end;
-
-        OS::TEventFlag tx_event;
+        Framing framing;
 
         void reset_buffers() {
             uart_rx_buffer.flush();
+            framing.reset();
+            transmitter_type::reset_tx();
         }
 
     public:
+        static const size_t rx_buffer_size = buffer_size;
+
         INLINE Uart() {
         }
 
@@ -60,30 +77,30 @@ namespace stm8 {
             return uart_rx_buffer.pop(byte, timeout);
         }
 
-        // UART data transmit function
-        // If UART transmitter's buffer does not have ehough space to
-        // send all data, it blocks until the buffer is ready to receive new data.
-        NOINLINE void send_data(const uint8_t* data, size_type size) {
-            tx_iterator = data;
-            tx_end = data + size;
-
-            uart_base::enable_transmitter();
-            tx_event.wait();
+        //Receives count bytes. Returns false if the timeout has expired.
+        bool read(uint8_t* data, size_type count, timeout_t timeout = 0) {
+            return uart_rx_buffer.read(data, count, timeout);
+        }
+
+        //Returns false immediately if the receive buffer has less than count bytes.
+        //The receive interrupt does not wait for the buffer space, so no process is resumed.
+        bool try_read(uint8_t* data, size_type count) {
+            if (uart_rx_buffer.size() < count)
+                return false;
+            uart_rx_buffer.read_isr(data, count);
+            return true;
         }
 
         // UART data transmit function
-        //  - checks if there's room in the transmit sw buffer
-        //  - if there's room, it transfers data byte to sw buffer
-        //  - automatically handles "uart_tx_buffer_full_flag"
-        //  - sets the overflow flag upon software buffer overflow (doesn't overwrite existing data)
-        //  - if this is the first data byte in the buffer, it enables the "hw buffer empty" interrupt
+        //  - sends one byte using send_data of the selected transmitter
         void send_byte(uint8_t byte) {
-            send_data(&byte, sizeof(byte));
-            //send_data(io::buffer(&byte, sizeof(byte)));
+            transmitter_type::send_data(&byte, sizeof(byte));
         }
 
         //These methods are called from interupt handlers
-        INLINE void handle_byte_receive() {
+
+        //Returns true if the received byte completes the message or has been dropped
+        INLINE bool handle_byte_receive() {
             uint8_t status = UARTx->SR;
             //This interrupt can be generated in two cases:
             // received data ready to be read.
@@ -92,34 +109,28 @@ namespace stm8 {
             uint8_t data = UARTx->DR;
             UartError last_error;
             last_error.error_flags = status & UartConstants::UART_SR_ERRORS_MASK; //copy error flags
+            bool complete = false;
 
             if (status & UartConstants::UART_SR_RXNE) {
                 if(uart_rx_buffer.is_full()) {                     // if the sw buffer is full
                     last_error.fifo_buffer_overflow = 1;           // set the overflow flag
+                    //The current message has lost the byte, so the framing restarts from the next byte
+                    //and the process is resumed to take the buffered bytes and reject the broken message
+                    framing.reset();
+                    uart_rx_buffer.resume_isr();
+                    complete = true;
                 } else {                                           // if there's room in the sw buffer
                     Diagnostic::receive(data);
-                    uart_rx_buffer.push_isr(data);                 // store the received data as the newest data element in the sw buffer
+                    complete = framing.receive(data);
+                    uart_rx_buffer.push_isr(data, complete);       // store the received data as the newest data element in the sw buffer
                 }
                 //Clear interrupt source.
                 //It is for IAR simulator, because reading of DR register clears RXNE flag
                 //UARTx->SR &= ~UartConstants::UART_SR_RXNE;
             }
-            error.error_flags = last_error.error_flags;
-        }
-
-        INLINE void handle_byte_transmit() {
-            if (UARTx->SR & UartConstants::UART_SR_TXE) {
-                if (tx_iterator != tx_end) { // if data exists in the sw buffer
-                    UARTx->DR = *tx_iterator;    // place oldest data element in the TX hardware buffer
-                    ++tx_iterator;
-                }
-                if(tx_iterator == tx_end) {           // if no more data exists
-                    uart_base::disable_transmitter();
-                    tx_event.signal_isr();
-                }
-                //It is for IAR simulator
-                //UARTx->SR &= ~UartConstants::UART_SR_TXE;
-            }
+            //The flags are kept until handle_errors call, so the diagnostics see them
+            error.error_flags |= last_error.error_flags;
+            return complete;
         }
     };
 
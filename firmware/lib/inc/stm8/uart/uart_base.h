@@ -33,7 +33,7 @@ namespace stm8 {
 
         struct UART
         {
-            uart_type* operator-> () { return (uart_type*)UartAddress; }
+            uart_type* operator-> () { return STM8_PERIPHERAL(uart_type, UartAddress); }
 		};
 
 		static UART UARTx;
@@ -85,6 +85,7 @@ namespace stm8 {
             to the UART1_SR register followed by a Read to the UART1_DR register */
             uint8_t dummy = UARTx->SR;
             dummy = UARTx->DR;
+            (void)dummy;
 
             UARTx->BRR2 = UartConstants::UART_BRR2_RESET_VALUE;
             UARTx->BRR1 = UartConstants::UART_BRR1_RESET_VALUE;
@@ -136,6 +137,11 @@ namespace stm8 {
             UARTx->CR2 &= ~UartConstants::UART_CR2_RIEN;
         }
 
+        //Returns UartError flags accumulated since the last handle_errors call
+        uint8_t get_errors() const {
+            return error.error_flags;
+        }
+
         void handle_errors() {
             // check for rx overflow condition
             if (error.error_flags != 0) {
@@ -0,0 +1,215 @@
+#ifndef __STM8_UART_TRANSMITTER_H
+#define __STM8_UART_TRANSMITTER_H
+
+#include <os_services.h>
+#include <stm8/uart/uart_base.h>
+#include <utils/ring_buffer.h>
+#include <utils/blocking_queue.h>
+#include <utils/inline.h>
+
+namespace stm8 {
+
+    //Transmitter part of the UART driver.
+    //
+    //tx_buffer_size - size of the transmit ring buffer. It should be a power of 2.
+    //                 The data is copied into the buffer, so the caller may reuse
+    //                 its buffer just after the send call returns.
+    //                 Zero size selects the direct transmitter (see the specialization below).
+    template <UartType type, size_t tx_buffer_size>
+    class UartTransmitter : public UartBase<type> {
+    protected:
+        typedef UartBase<type> uart_base;
+        using uart_base::UARTx;
+
+    private:
+        //Pushing into the buffer enables the transmitter interrupt
+        typedef typename uart_base::template isr_ring_buffer<utils::ring_buffer<uint8_t, tx_buffer_size> > tx_ring_type;
+        typedef utils::blocking_queue<uint8_t, tx_buffer_size, tx_ring_type> uart_tx_buffer_type;
+
+    public:
+        typedef typename uart_tx_buffer_type::size_type tx_size_type;
+
+        //The data is copied into the transmit buffer
+        static const bool buffered_tx = true;
+
+    private:
+        uart_tx_buffer_type uart_tx_buffer;
+
+        //It is set when the transmit buffer becomes empty
+        OS::TEventFlag tx_event;
+
+        //Number of frames rejected because of insufficient buffer space
+        uint16_t tx_overflow_count;
+
+    protected:
+        //Discards the data waiting for transmission
+        void reset_tx() {
+            uart_tx_buffer.flush();
+        }
+
+    public:
+        INLINE UartTransmitter()
+            : tx_overflow_count(0)
+        {
+        }
+
+        // UART data transmit function
+        // Copies the data into the transmit buffer. If the buffer does not have
+        // enough space, it blocks until the transmitter frees the space.
+        // It does not wait for the end of transmission.
+        NOINLINE void send_data(const uint8_t* data, tx_size_type size) {
+            TCritSect cs;
+            tx_event.clear();
+            uart_tx_buffer.write(data, size);
+        }
+
+        // Copies the whole frame into the transmit buffer and returns immediately.
+        // Returns false and counts the overflow if the buffer does not have
+        // enough space for the frame. A part of the frame is never queued.
+        bool start_send(const uint8_t* data, tx_size_type size) {
+            TCritSect cs;
+            if (uart_tx_buffer.get_free_size() < size) {
+                ++tx_overflow_count;
+                return false;
+            }
+            //The flag may have been set by the previous transmission
+            tx_event.clear();
+            //Does not block, because only the transmitter interrupt takes the data out
+            uart_tx_buffer.write(data, size);
+            return true;
+        }
+
+        // Waits until all queued data is placed into the transmitter.
+        // Returns false on timeout.
+        bool wait_sent(timeout_t timeout = 0) {
+            {
+                TCritSect cs;
+                if (uart_tx_buffer.empty())
+                    return true;
+            }
+            return tx_event.wait(timeout);
+        }
+
+        //Returns the number of bytes that can be queued without blocking
+        tx_size_type get_tx_free_size() const {
+            return uart_tx_buffer.get_free_size();
+        }
+
+        //Returns the number of frames rejected by start_send
+        uint16_t get_tx_overflow_count() const {
+            return tx_overflow_count;
+        }
+
+        //Returns true when the transmit buffer becomes empty
+        INLINE bool handle_byte_transmit() {
+            if (UARTx->SR & UartConstants::UART_SR_TXE) {
+                uint8_t data;
+                if (uart_tx_buffer.pop_isr(data)) {
+                    UARTx->DR = data;
+                }
+                if (uart_tx_buffer.empty()) {
+                    uart_base::disable_transmitter();
+                    tx_event.signal_isr();
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    //Direct transmitter. It sends the data from the caller's buffer,
+    //so send_data blocks until the last byte is placed into the transmitter.
+    template <UartType type>
+    class UartTransmitter<type, 0> : public UartBase<type> {
+    protected:
+        typedef UartBase<type> uart_base;
+        using uart_base::UARTx;
+
+    public:
+        typedef uint8_t tx_size_type;
+
+        //The caller's buffer is used during transmission
+        static const bool buffered_tx = false;
+
+    private:
+        const uint8_t* tx_iterator;
+        const uint8_t* tx_end;
+
+        OS::TEventFlag tx_event;
+
+    protected:
+        void reset_tx() {
+            tx_iterator = tx_end;
+        }
+
+    public:
+        INLINE UartTransmitter()
+            : tx_iterator(0), tx_end(0)
+        {
+        }
+
+        // UART data transmit function
+        // Blocks until the last byte of the data is placed into the transmitter.
+        NOINLINE void send_data(const uint8_t* data, tx_size_type size) {
+            //The flag may have been set by transmission started by start_send
+            tx_event.clear();
+            start_send(data, size);
+            tx_event.wait();
+        }
+
+        // Starts data transmission and returns immediately.
+        // The data should not be changed until handle_byte_transmit reports
+        // the end of transmission.
+        bool start_send(const uint8_t* data, tx_size_type size) {
+            tx_iterator = data;
+            tx_end = data + size;
+
+            uart_base::enable_transmitter();
+            return true;
+        }
+
+        // Waits until the data passed to start_send is placed into the transmitter.
+        // Returns false on timeout.
+        bool wait_sent(timeout_t timeout = 0) {
+            {
+                TCritSect cs;
+                if (tx_iterator == tx_end)
+                    return true;
+                tx_event.clear();
+            }
+            return tx_event.wait(timeout);
+        }
+
+        //The direct transmitter takes the data of any size when it is idle
+        tx_size_type get_tx_free_size() const {
+            TCritSect cs;
+            return tx_iterator == tx_end ? tx_size_type(~0) : 0;
+        }
+
+        //The direct transmitter never rejects the data
+        uint16_t get_tx_overflow_count() const {
+            return 0;
+        }
+
+        //Returns true when the last byte of the data has been placed into the transmitter
+        INLINE bool handle_byte_transmit() {
+            if (UARTx->SR & UartConstants::UART_SR_TXE) {
+                if (tx_iterator != tx_end) { // if data exists in the sw buffer
+                    UARTx->DR = *tx_iterator;    // place oldest data element in the TX hardware buffer
+                    ++tx_iterator;
+                }
+                if(tx_iterator == tx_end) {           // if no more data exists
+                    uart_base::disable_transmitter();
+                    tx_event.signal_isr();
+                    return true;
+                }
+                //It is for IAR simulator
+                //UARTx->SR &= ~UartConstants::UART_SR_TXE;
+            }
+            return false;
+        }
+    };
+
+}
+
+#endif // __STM8_UART_TRANSMITTER_H
@@ -77,6 +77,23 @@ namespace utils {
             }
             return false;
         }
+        //Resumes the consumers only if resume is true, so the consumer
+        //waiting for a block of data is not woken up by each item
+        bool push_isr(T item, bool resume) {
+            TCritSect cs;
+
+            if (pool.push(item)) {
+                if (resume)
+                    resume_all_isr(ConsumersProcessMap);
+                return true;
+            }
+            return false;
+        }
+        //Resumes the consumers without the new data, e.g. when the producer has lost an item
+        void resume_isr() {
+            TCritSect cs;
+            resume_all_isr(ConsumersProcessMap);
+        }
         bool pop_isr(T& item) {
             TCritSect cs;
 
@@ -20,6 +20,13 @@ namespace utils {
 		BigEndian    = MSB_FIRST
 	};
 
+    //Byte order of the MCU words. STM8 is big-endian, the host builds run on little-endian CPUs.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    static const Endianness NativeEndianness = LittleEndian;
+#else
+    static const Endianness NativeEndianness = BigEndian;
+#endif
+
 	//Copies data as bytes without changing byte order
 	//We using 8-bit size argument because IAR produces better code using this approach
 	//When we use iterators, IAR produces good code only when the source buffer is
@@ -90,10 +97,10 @@ namespace utils {
 extern "C" {
 #endif
 
-    //Converts 16-bit integer to/from little-endian format
+    //Converts 16-bit integer between MCU byte order and little-endian format
     int16_t swap_bytes(int16_t value);
 
-    //Converts array of 16-bit integer to/from little-endian format
+    //Converts array of 16-bit integer between MCU byte order and little-endian format
     extern "C" void swap_sample(int16_t (&data)[3]);
 #ifdef __cplusplus
 }
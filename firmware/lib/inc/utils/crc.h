@@ -0,0 +1,24 @@
+#ifndef __UTILS_CRC_H
+#define __UTILS_CRC_H
+
+#include <stdint.h>
+
+namespace utils {
+
+    //Calculates CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+    //The bitwise calculation does not need a table in the flash memory,
+    //it is used for rarely checked data like the EEPROM calibration.
+    inline uint16_t crc16(const uint8_t* data, uint16_t size, uint16_t crc = 0xFFFF) {
+        while (size != 0) {
+            crc ^= uint16_t(*data++) << 8;
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x8000) != 0 ? uint16_t((crc << 1) ^ 0x1021) : uint16_t(crc << 1);
+            }
+            --size;
+        }
+        return crc;
+    }
+
+}
+
+#endif //__UTILS_CRC_H
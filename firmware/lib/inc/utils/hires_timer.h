@@ -19,7 +19,9 @@ namespace utils {
         };
 
     public:
-        void start() {
+        //Starts the timer. The overflow interrupt extends the time to 32 bits,
+        //the 16-bit ticks do not need it.
+        static void start(bool overflow_interrupt = true) {
             //Convert period to micro-seconds and clock frequency to MHz
             typedef stm8::timer_16bit<0xffff, F_MASTER / 1000000> timer_cfg;
 
@@ -30,7 +32,7 @@ namespace utils {
             TIM2()->EGR = TIM2_EGR_UG; //apply the prescaler
             TIM2()->SR1 &= ~TIM2_SR1_UIF;
 
-            TIM2()->IER = TIM2_IER_UIE;
+            TIM2()->IER = overflow_interrupt ? TIM2_IER_UIE : 0;
             TIM2()->CR1 = TIM2_CR1_CEN;
         }
 
@@ -48,6 +50,13 @@ namespace utils {
             result.low = TIM2()->CNTRL;
             return result.time;
         }
+
+        //returns the low 16 bits of the time in microseconds.
+        //Reading of the high byte latches the low one.
+        static uint16_t ticks() {
+            uint8_t high = TIM2()->CNTRH;
+            return uint16_t(high) << 8 | TIM2()->CNTRL;
+        }
     };
 }
 
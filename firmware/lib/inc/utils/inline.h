@@ -1,12 +1,36 @@
 #ifndef __UTILS_INLINE_H
 #define __UTILS_INLINE_H
 
+//IAR uses pragmas to control inlining, GCC and Clang use function attributes.
+//Other compilers get plain inline hints so the library can be built on a host.
 #ifndef INLINE
+#if defined(__ICCSTM8__)
 #define INLINE _Pragma("inline=forced") inline
+#elif defined(__GNUC__)
+#define INLINE inline __attribute__((always_inline))
+#else
+#define INLINE inline
+#endif
 #endif
 
 #ifndef NOINLINE
+#if defined(__ICCSTM8__)
 #define NOINLINE _Pragma("inline=never")
+#elif defined(__GNUC__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+#endif
+
+//IAR copies the function code into RAM at start-up and executes it from there.
+//It is required for the code that runs while the program memory is not accessible.
+#ifndef RAMFUNC
+#if defined(__ICCSTM8__)
+#define RAMFUNC __ramfunc
+#else
+#define RAMFUNC
+#endif
 #endif
 
-#endif //__UTILS_INLINE_H
\ No newline at end of file
+#endif //__UTILS_INLINE_H
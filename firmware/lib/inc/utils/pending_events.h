@@ -0,0 +1,72 @@
+#ifndef __UTILS_PENDING_EVENTS_H
+#define __UTILS_PENDING_EVENTS_H
+
+#include <stdint.h>
+
+namespace utils {
+
+    //Single producer/single consumer channel of "event pending" flags.
+    //
+    //The producer (ISR) publishes the event by a single byte write, so it does not need
+    //a critical section. A published event that is still pending is coalesced with the new one.
+    //The producer should wake up the consumer only when publish returns WakeUp,
+    //that is the transition of the channel from empty to non-empty.
+    //
+    //The consumer calls acknowledge before taking the events, and it clears each flag before
+    //processing its event, so the event published during the processing is not lost.
+    //The producer and the consumer should not preempt each other's calls on other cores,
+    //it is true for the ISR and the process on the single core MCU.
+    template <uint8_t count>
+    class pending_events {
+    private:
+        volatile uint8_t flags[count];
+        //The consumer is signalled, the flags may be set
+        volatile uint8_t signalled;
+
+    public:
+        enum publish_result {
+            Coalesced,
+            Published,
+            WakeUp
+        };
+
+        pending_events()
+            : signalled(0)
+        {
+            for (uint8_t i = 0; i < count; ++i) {
+                flags[i] = 0;
+            }
+        }
+
+        //Producer side
+        publish_result publish(uint8_t index) {
+            if (flags[index] != 0)
+                return Coalesced;
+            flags[index] = 1;
+            //The flag is written before the signal check, so the consumer sees it
+            if (signalled != 0)
+                return Published;
+            signalled = 1;
+            return WakeUp;
+        }
+
+        //Consumer side. The next published event signals the consumer again.
+        //Returns true if the consumer has been signalled.
+        bool acknowledge() {
+            bool result = signalled != 0;
+            signalled = 0;
+            return result;
+        }
+
+        //Consumer side. Returns true and clears the flag if the event is pending.
+        bool take(uint8_t index) {
+            if (flags[index] == 0)
+                return false;
+            flags[index] = 0;
+            return true;
+        }
+    };
+
+}
+
+#endif //__UTILS_PENDING_EVENTS_H
@@ -0,0 +1,204 @@
+#ifndef __UTILS_PROFILER_H
+#define __UTILS_PROFILER_H
+
+#include <stdint.h>
+
+//Profiler of the sample pipeline. It measures the time between the data ready interrupt
+//and the stages of the sample processing with 1 microsecond resolution.
+//
+//The instrumentation is opt-in: the firmware built without PROFILER_ENABLED=1
+//does not contain the table, the timer code or the instrumentation points.
+//The same macros work on a host build, it measures the time by the standard clock
+//in PROFILER_HOST_TICK_NS units (1 microsecond by default).
+//
+//  PROFILE_INIT()            - starts the clock, it should be called once at start
+//  PROFILE_START()           - the data ready interrupt entry, it starts the sample measurement
+//  PROFILE_STAGE(stage)      - the sample has reached the stage (utils::ProfileStage)
+//  PROFILE_READ(stage, data) - puts the stage record (ProfileRecord) into data in the host byte order.
+//                              Returns false if the profiler is disabled.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+#ifndef PROFILER_HOST_TICK_NS
+#define PROFILER_HOST_TICK_NS 1000
+#endif
+
+namespace utils {
+
+    //Stages of the sample pipeline in the processing order
+    enum ProfileStage {
+        ProfileQueuePop,    //The event loop has taken the pending data
+        ProfileSpiRead,     //The sample has been read from the sensor
+        ProfileTransform,   //The sample has been corrected by the calibration
+        ProfileFrameQueued, //The data frame has been queued for transmission
+        ProfileTxDone,      //The last byte of the frames has been placed into the UART
+        PROFILE_STAGE_COUNT
+    };
+}
+
+#if PROFILER_ENABLED
+
+#if defined(__ICCSTM8__)
+#include <OS_Services.h>
+#include <utils/hires_timer.h>
+#else
+#include <chrono>
+#endif
+
+namespace utils {
+
+    //The statistics of one stage. The times are in clock ticks since the previous recorded stage,
+    //the tick is 1 microsecond on the MCU.
+    //The counters wrap around.
+    struct ProfileRecord {
+        static const uint8_t HISTOGRAM_SIZE = 4;
+
+        uint16_t count;
+        uint16_t min;
+        uint16_t average;
+        uint16_t max;
+        //Number of the measurements below 32, 128, 512 and from 512 ticks
+        uint16_t histogram[HISTOGRAM_SIZE];
+    };
+
+#if defined(__ICCSTM8__)
+    //TIM2 counts microseconds, the 16-bit time does not need the overflow interrupt
+    struct ProfilerClock {
+        static void start() {
+            CLK()->PCKENR1 |= CLK_PCKENR1_TIM2;
+            HiResTimer::start(false);
+        }
+
+        static uint16_t now() {
+            return HiResTimer::ticks();
+        }
+    };
+
+    typedef TCritSect ProfilerLock;
+
+    //The MCU is big-endian
+    inline uint16_t toLittleEndian(uint16_t value) {
+        return uint16_t(value << 8 | value >> 8);
+    }
+#else
+    //The host benchmark selects a finer tick to see the stages shorter than a microsecond
+    struct ProfilerClock {
+        static void start() {
+        }
+
+        static uint16_t now() {
+            using namespace std::chrono;
+            return uint16_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count() / PROFILER_HOST_TICK_NS);
+        }
+    };
+
+    //The host build measures a single thread
+    struct ProfilerLock {
+        ProfilerLock() {
+        }
+    };
+
+    inline uint16_t toLittleEndian(uint16_t value) {
+        return value;
+    }
+#endif
+
+    //The table of the stage statistics.
+    //A stage is recorded once per sample and only after the previous stages,
+    //the skipped stages are added to the next recorded one. The next data ready interrupt
+    //starts the new sample, so the rest stages of the interrupted sample are not recorded.
+    //The zero state is valid, the object is placed into bss section.
+    class Profiler {
+    private:
+        struct Stage {
+            uint32_t total;
+            uint16_t count;
+            uint16_t min;
+            uint16_t max;
+            uint16_t histogram[ProfileRecord::HISTOGRAM_SIZE];
+        };
+
+        Stage stages[PROFILE_STAGE_COUNT];
+        //Time of the previous recorded stage
+        uint16_t last;
+        //The stage that can be recorded next plus one, zero before the first sample
+        uint8_t next;
+
+        static uint8_t getBucket(uint16_t duration) {
+            if (duration < 32)
+                return 0;
+            if (duration < 128)
+                return 1;
+            if (duration < 512)
+                return 2;
+            return 3;
+        }
+
+    public:
+        //Called from the data ready interrupt
+        void start(uint16_t now) {
+            last = now;
+            next = ProfileQueuePop + 1;
+        }
+
+        void mark(ProfileStage stage, uint16_t now) {
+            ProfilerLock lock;
+            if (next == 0 || stage + 1 < next)
+                return;
+
+            uint16_t duration = now - last;
+            last = now;
+            next = stage + 2;
+
+            Stage& record = stages[stage];
+            if (record.count == 0 || duration < record.min)
+                record.min = duration;
+            if (duration > record.max)
+                record.max = duration;
+            record.total += duration;
+            ++record.count;
+            ++record.histogram[getBucket(duration)];
+        }
+
+        bool read(uint8_t stage, ProfileRecord& result) const {
+            if (stage >= PROFILE_STAGE_COUNT)
+                return false;
+
+            const Stage& record = stages[stage];
+            result.count = toLittleEndian(record.count);
+            result.min = toLittleEndian(record.min);
+            result.average = toLittleEndian(record.count != 0 ? uint16_t(record.total / record.count) : 0);
+            result.max = toLittleEndian(record.max);
+            for (uint8_t i = 0; i < ProfileRecord::HISTOGRAM_SIZE; ++i) {
+                result.histogram[i] = toLittleEndian(record.histogram[i]);
+            }
+            return true;
+        }
+    };
+
+    //The instance is defined in the header
+    template <typename T>
+    struct ProfilerInstance {
+        static Profiler profiler;
+    };
+
+    template <typename T>
+    Profiler ProfilerInstance<T>::profiler;
+}
+
+#define PROFILE_INIT()        utils::ProfilerClock::start()
+#define PROFILE_START()       utils::ProfilerInstance<void>::profiler.start(utils::ProfilerClock::now())
+#define PROFILE_STAGE(stage)  utils::ProfilerInstance<void>::profiler.mark(utils::stage, utils::ProfilerClock::now())
+#define PROFILE_READ(stage, data) utils::ProfilerInstance<void>::profiler.read(stage, *(utils::ProfileRecord*)(data))
+
+#else
+
+#define PROFILE_INIT()        ((void)0)
+#define PROFILE_START()       ((void)0)
+#define PROFILE_STAGE(stage)  ((void)0)
+#define PROFILE_READ(stage, data) false
+
+#endif
+
+#endif //__UTILS_PROFILER_H
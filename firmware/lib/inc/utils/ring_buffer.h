@@ -188,7 +188,7 @@ namespace utils {
             if (avail == 0)
                 return 0;
 
-	        output_count = std::min(output_count, avail);
+            output_count = std::min(output_count, (std::size_t)avail);
 
             size_type start_index = read_index();
 	        size_type new_read_count = read_count_ + output_count;
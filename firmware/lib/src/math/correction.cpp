@@ -1,9 +1,70 @@
 #include <math/correction.h>
 
 namespace math {
+    VectorCorrection::MatrixKind VectorCorrection::classify(const int16_t* matrix) {
+        for (uint8_t row = 0; row < COLUMNS; ++row) {
+            for (uint8_t col = 0; col < COLUMNS; ++col) {
+                if (row != col && get(matrix, row, col) != 0)
+                    return MatrixFull;
+            }
+        }
+
+        for (uint8_t i = 0; i < COLUMNS; ++i) {
+            if (get(matrix, i, i) != UNIT)
+                return MatrixDiagonal;
+        }
+
+        for (uint8_t i = 0; i < COLUMNS; ++i) {
+            if (get(matrix, 3, i) != 0)
+                return MatrixOffset;
+        }
+
+        return MatrixIdentity;
+    }
+
+    void VectorCorrection::addOffset(int16_t* matrix, const int16_t* offset) {
+        int16_t* row = matrix + 3 * COLUMNS;
+        for (uint8_t i = 0; i < COLUMNS; ++i) {
+            row[i] = saturate(int32_t(row[i]) + half(offset[i]));
+        }
+    }
+
+    void VectorCorrection::interpolate(const int16_t* m0, const int16_t* m1, int16_t t0, int16_t t1, int16_t t, int16_t* result) {
+        const int32_t one = int32_t(1) << INTERPOLATION_BITS;
+        if (t1 <= t0) {
+            memcpy(result, m0, MATRIX_SIZE * sizeof(int16_t));
+            return;
+        }
+
+        int32_t factor = ((int32_t(t) - t0) << INTERPOLATION_BITS) / (int32_t(t1) - t0);
+        if (factor < -one)
+            factor = -one;
+        else if (factor > 2 * one)
+            factor = 2 * one;
+
+        for (uint8_t i = 0; i < MATRIX_SIZE; ++i) {
+            int32_t delta = (int32_t(m1[i]) - m0[i]) * factor;
+            result[i] = saturate(m0[i] + ((delta + (one >> 1)) >> INTERPOLATION_BITS));
+        }
+    }
+
     //This method has been put into CPP file to set optimization level to maximum speed
     //The method produces 16-bit integers in little-endian format
-    void VectorCorrection::transform(const int16_t* matrix, uint8_t scale, const int16_t* data, int16_t* result) const {
-        vector_mul(getMatrixForScale(matrix, scale), data, result);
+    void VectorCorrection::transform(const int16_t* matrix, uint8_t kind, uint8_t scale, const int16_t* data, int16_t* result) const {
+        matrix = getMatrixForScale(matrix, scale);
+        switch (kind) {
+        case MatrixDiagonal:
+            diagonal_mul(matrix, data, result);
+            break;
+        case MatrixOffset:
+            offset_add(matrix, data, result);
+            break;
+        case MatrixIdentity:
+            identity(data, result);
+            break;
+        default:
+            vector_mul(matrix, data, result);
+            break;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,125 @@
+#include <math/fusion.h>
+
+namespace math {
+
+    namespace {
+        //Integration gain in Q15 format: 125dps gyro sensitivity in rad/s * 0.5 / 3.25Hz * 2^16.
+        //The product of Q14 quaternion, gyro sample and this gain is the Q30 increment
+        //for 125dps range and 3.25Hz rate. Other ranges and rates shift the increment.
+        const int16_t GYRO_GAIN = 25227;
+        //Feedback gain Kp = 1/s in 125dps gyro digits per Q14 error unit, Q15 format
+        const int16_t FEEDBACK_GAIN = 26192;
+
+        const int32_t ONE_Q28 = int32_t(1) << 28;
+
+        //Accel samples out of range [0.71g; 1.41g] are not used for the correction
+        const int32_t MIN_ACCEL_Q26 = int32_t(1) << 25;
+        const int32_t MAX_ACCEL_Q26 = int32_t(1) << 27;
+        //2g in Q13 format
+        const int16_t MAX_ACCEL_Q13 = 0x4000;
+
+        //Returns the high word of Q30 value as Q14 value
+        inline int16_t high(int32_t value) {
+            return int16_t(value >> 16);
+        }
+
+        inline int16_t saturate(int32_t value) {
+            if (value > 32767)
+                return 32767;
+            if (value < -32767)
+                return -32767;
+            return int16_t(value);
+        }
+
+        //Calculates a * b / 0x8000. b should not be -32768.
+        inline int32_t muls32x16_32x(int32_t a, int16_t b) {
+            bool negative = b < 0;
+            if (negative)
+                b = -b;
+            int32_t result = muls16x16_32(high(a), b) * 2 + int32_t(mulu16x16_32(uint16_t(a), uint16_t(b)) >> 15);
+            return negative ? -result : result;
+        }
+    }
+
+    //Adds the feedback that rotates the estimated gravity direction towards the measured one
+    void OrientationFilter::correct(const int16_t* accel, int16_t* rate, uint8_t boost) const {
+        int16_t a[3];
+        for (uint8_t i = 0; i < 3; ++i) {
+            int32_t value = int32_t(accel[i]) * (int32_t(1) << accelShift) / 2;
+            if (value > MAX_ACCEL_Q13 || value < -MAX_ACCEL_Q13)
+                return;
+            a[i] = int16_t(value);
+        }
+
+        //The acceleration differs from the gravity too much
+        int32_t norm = muls16x16_32(a[0], a[0]) + muls16x16_32(a[1], a[1]) + muls16x16_32(a[2], a[2]);
+        if (norm < MIN_ACCEL_Q26 || norm > MAX_ACCEL_Q26)
+            return;
+
+        int16_t q0 = high(q[0]), q1 = high(q[1]), q2 = high(q[2]), q3 = high(q[3]);
+
+        //Estimated gravity direction in Q14 format
+        int16_t vx = int16_t((muls16x16_32(q1, q3) - muls16x16_32(q0, q2)) >> 13);
+        int16_t vy = int16_t((muls16x16_32(q0, q1) + muls16x16_32(q2, q3)) >> 13);
+        int16_t vz = int16_t((muls16x16_32(q0, q0) - muls16x16_32(q1, q1) - muls16x16_32(q2, q2) + muls16x16_32(q3, q3)) >> 14);
+
+        //Error is the cross product of the measured and the estimated directions in Q14 format
+        int16_t error[3] = {
+            int16_t((muls16x16_32(a[1], vz) - muls16x16_32(a[2], vy)) >> 13),
+            int16_t((muls16x16_32(a[2], vx) - muls16x16_32(a[0], vz)) >> 13),
+            int16_t((muls16x16_32(a[0], vy) - muls16x16_32(a[1], vx)) >> 13)
+        };
+
+        for (uint8_t i = 0; i < 3; ++i) {
+            int32_t feedback = int32_t(muldivs16x16_16x(error[i], FEEDBACK_GAIN)) * (int32_t(1) << boost) >> feedbackShift;
+            rate[i] = saturate(rate[i] + feedback);
+        }
+    }
+
+    //Integrates q' = 0.5 * q * (0, rate)
+    void OrientationFilter::integrate(const int16_t* rate) {
+        int16_t q0 = high(q[0]), q1 = high(q[1]), q2 = high(q[2]), q3 = high(q[3]);
+        int16_t wx = rate[0], wy = rate[1], wz = rate[2];
+
+        int32_t delta[SIZE] = {
+            -muls16x16_32(q1, wx) - muls16x16_32(q2, wy) - muls16x16_32(q3, wz),
+             muls16x16_32(q0, wx) + muls16x16_32(q2, wz) - muls16x16_32(q3, wy),
+             muls16x16_32(q0, wy) - muls16x16_32(q1, wz) + muls16x16_32(q3, wx),
+             muls16x16_32(q0, wz) + muls16x16_32(q1, wy) - muls16x16_32(q2, wx)
+        };
+
+        for (uint8_t i = 0; i < SIZE; ++i) {
+            q[i] += muls32x16_32x(delta[i], GYRO_GAIN) >> gyroShift;
+        }
+    }
+
+    //The integration step changes the quaternion norm slightly, so the first order
+    //correction q *= (3 - |q|^2) / 2 is enough to keep it close to 1
+    void OrientationFilter::normalize() {
+        int32_t norm = 0;
+        for (uint8_t i = 0; i < SIZE; ++i) {
+            int16_t value = high(q[i]);
+            norm += muls16x16_32(value, value);
+        }
+
+        int16_t correction = saturate((ONE_Q28 - norm) >> 14);
+        for (uint8_t i = 0; i < SIZE; ++i) {
+            q[i] += muls32x16_32x(q[i], correction);
+        }
+    }
+
+    //This method has been put into CPP file to set optimization level to maximum speed
+    void OrientationFilter::update(const int16_t* gyro, const int16_t* accel) {
+        int16_t rate[3] = {gyro[0], gyro[1], gyro[2]};
+
+        uint8_t boost = 0;
+        if (settling != 0) {
+            --settling;
+            boost = SETTLING_BOOST;
+        }
+
+        correct(accel, rate, boost);
+        integrate(rate);
+        normalize();
+    }
+}
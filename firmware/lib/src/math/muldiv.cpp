@@ -0,0 +1,71 @@
+#include <math/muldiv.h>
+#include <utils/byte_order.h>
+
+//Portable implementations of the arithmetic kernels.
+//The STM8 build uses hand-written assembler versions (*.asm in this folder),
+//so this file is compiled only by other compilers, e.g. for a host build.
+//The code reproduces the assembler algorithms bit by bit, including the places
+//where they deviate from exact arithmetic.
+#ifndef __ICCSTM8__
+
+namespace {
+    //Splits the signed argument into the magnitude and the sign
+    //-32768 becomes 32768 as the assembler code does
+    inline uint16_t magnitude(int16_t value, bool& negative) {
+        if (value < 0) {
+            negative = !negative;
+            return uint16_t(-int32_t(value));
+        }
+        return uint16_t(value);
+    }
+}
+
+extern "C" {
+
+    int16_t muldivs16x16_16(int16_t a, int16_t b) {
+        bool negative = false;
+        uint32_t product = uint32_t(magnitude(a, negative)) * magnitude(b, negative);
+
+        uint16_t result = uint16_t(product >> 14);
+        //The assembler code checks only the sign bit of the shifted result
+        if (result & 0x8000)
+            result = 0x7fff;
+
+        return negative ? int16_t(-int16_t(result)) : int16_t(result);
+    }
+
+    int16_t muldivs16x16_16x(int16_t a, int16_t b) {
+        bool negative = false;
+        uint32_t product = uint32_t(magnitude(a, negative)) * magnitude(b, negative);
+
+        uint16_t result = uint16_t(product >> 15);
+
+        return int16_t(negative ? uint16_t(-result) : result);
+    }
+
+    int32_t muls16x16_32(int16_t a, int16_t b) {
+        bool negative = false;
+        uint32_t product = uint32_t(magnitude(a, negative)) * magnitude(b, negative);
+
+        return int32_t(negative ? uint32_t(-product) : product);
+    }
+
+    uint32_t mulu16x16_32(uint16_t a, uint16_t b) {
+        return uint32_t(a) * b;
+    }
+
+    int16_t scale2(int16_t value) {
+        int32_t result = int32_t(value) * 2;
+        if (result > 32767)
+            return 32767;
+        if (result < -32768)
+            return -32768;
+        return int16_t(result);
+    }
+
+    int16_t scale2le(int16_t value) {
+        return swap_bytes(scale2(value));
+    }
+}
+
+#endif //__ICCSTM8__
@@ -0,0 +1,23 @@
+#include <stm8/eeprom.h>
+
+namespace stm8 {
+    uint8_t EepromWriter::stage[EepromWriter::BLOCK_SIZE];
+
+    void EepromWriter::programBlock(uint8_t* block, uint8_t mode) {
+        //FLASH() accessor is not used because it may be a call into the program memory
+        FLASH_TypeDef* const flash = STM8_PERIPHERAL(FLASH_TypeDef, FLASH_BaseAddress);
+        //The bytes are written through volatile pointer, so each of them is loaded once and in order
+        volatile uint8_t* target = block;
+
+        flash->CR2 |= mode;
+        flash->NCR2 &= uint8_t(~mode);
+
+        for (uint8_t i = 0; i < BLOCK_SIZE; ++i) {
+            target[i] = stage[i];
+        }
+
+        //The programming starts when the last byte of the block is loaded
+        while ((flash->IAPSR & (FLASH_IAPSR_EOP | FLASH_IAPSR_WR_PG_DIS)) == 0) {
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#include <utils/byte_order.h>
+
+//Portable implementations of the byte order helpers.
+//The STM8 build uses byte_order.asm and swap_sample.asm instead.
+#ifndef __ICCSTM8__
+
+extern "C" {
+
+    //The little-endian host has nothing to convert
+    int16_t swap_bytes(int16_t value) {
+        if (utils::NativeEndianness == utils::LittleEndian)
+            return value;
+        uint16_t word = uint16_t(value);
+        return int16_t(uint16_t((word >> 8) | (word << 8)));
+    }
+
+    void swap_sample(int16_t (&data)[3]) {
+        data[0] = swap_bytes(data[0]);
+        data[1] = swap_bytes(data[1]);
+        data[2] = swap_bytes(data[2]);
+    }
+}
+
+#endif //__ICCSTM8__
@@ -42,6 +42,16 @@ namespace lsm330dlc {
         static uint8_t getEepromInfo(uint8_t command) {
             return 0;
         }
+
+        static bool isConfigCommand(uint8_t command) {
+            return false;
+        }
+
+        //Packs the device kind and the setting value into device config info byte
+        //See command_info.h file for detals
+        static uint8_t getConfigInfo(uint8_t command) {
+            return 0;
+        }
     };
 }
 }
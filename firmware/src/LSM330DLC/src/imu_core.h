@@ -5,6 +5,7 @@
 #include <sensors/lsm330dlc/Accelerometer.h>
 #include <sensors/lsm330dlc/Gyroscope.h>
 #include <ev3/command_info.h>
+#include <ev3/diagnostics.h>
 
 namespace ev3 {
 namespace lsm330dlc {
@@ -16,7 +17,8 @@ namespace lsm330dlc {
             StateInit, //Initial state should have zero value to place sensor object into bss section
             StateBoth,
             StateAccelerometer,
-            StateGyroscope
+            StateGyroscope,
+            StateDiagnostic
         };
 
 		typedef sensors::lsm330::Accelerometer<AccelTransport> Accelerometer;
@@ -24,7 +26,7 @@ namespace lsm330dlc {
 		typedef Accelerometer accel_type;
 		typedef Gyroscope gyro_type;
 
-        static const uint8_t MODE_COUNT = 3;
+        static const uint8_t MODE_COUNT = 4;
 
         static const uint8_t ACCEL_SAMPLES = 3;
         static const uint8_t GYRO_SAMPLES = 3;
@@ -33,17 +35,21 @@ namespace lsm330dlc {
         static const uint8_t FULL_SAMPLE_SIZE = FULL_SAMPLES * sizeof(uint16_t);
         static const uint8_t ACCEL_SAMPLE_SIZE = ACCEL_SAMPLES * sizeof(uint16_t);
         static const uint8_t GYRO_SAMPLE_SIZE = GYRO_SAMPLES * sizeof(uint16_t);
+        static const uint8_t DIAGNOSTIC_SAMPLE_SIZE = sizeof(ev3::Diagnostics);
 
     public:
         //Sensor modes info
         typedef mpl::make_type_list<
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'L', 'L'>::type,      FULL_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'C', 'C'>::type,      ACCEL_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
-            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'R', 'A', 'T', 'E'>::type, GYRO_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'R', 'A', 'T', 'E'>::type, GYRO_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            //Hidden mode, the host selects it by the index
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'D', 'I', 'A', 'G'>::type, ev3::Diagnostics::COUNT, ev3::Int16, 5, 0, false, SHRT_MIN, SHRT_MAX>
         >::type mode_list;
 
-        //Data sample size
-        static const uint8_t sample_size = FULL_SAMPLE_SIZE;
+        //Data sample size. The diagnostic sample is the largest one,
+        //it does not change the frame buffer size.
+        static const uint8_t sample_size = DIAGNOSTIC_SAMPLE_SIZE;
 
     private:
         Accelerometer accel;
@@ -62,7 +68,7 @@ namespace lsm330dlc {
 
         template <uint8_t offset, uint8_t size>
         void sendSample(uint8_t mode) {
-            sender()->sendData<offset, size>(mode);
+            sender()->template sendData<offset, size>(mode);
         }
 
         //Convert sensor mode to the state
@@ -87,6 +93,16 @@ namespace lsm330dlc {
             sendSample<ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE>(mode);
         }
 
+        //Sends the pipeline counters or the profiler record selected by the host
+        void readDiagnosticSample(uint8_t mode) {
+            //Reading the sample releases the data ready line
+            uint8_t sample[GYRO_SAMPLE_SIZE];
+            gyro.readSample(sample, sizeof(sample));
+
+            sender()->readDiagnostics(buffer(), GyroTransport::getErrors());
+            sendSample<0, DIAGNOSTIC_SAMPLE_SIZE>(mode);
+        }
+
     public:
         INLINE ImuCore()
             : currentState(StateInit)
@@ -128,6 +144,12 @@ namespace lsm330dlc {
                     gyro.init(Gyroscope::SCALE_250DPS, Gyroscope::ODR_760_BW_100, Gyroscope::InterruptEnabled, Gyroscope::NoSync);
                     accel.reset();
                     break;
+
+                case StateDiagnostic:
+                    //The gyro data ready interrupt sends the counters at the lowest rate
+                    gyro.init(Gyroscope::SCALE_250DPS, Gyroscope::ODR_95_BW_125, Gyroscope::InterruptEnabled, Gyroscope::NoSync);
+                    accel.reset();
+                    break;
                 }
             }
         }
@@ -137,12 +159,12 @@ namespace lsm330dlc {
             switch (scaleInfo & ScaleInfoMask::Device) {
             case ImuGyroscope:
                 if (currentState == StateBoth || currentState == StateGyroscope)
-                    gyro.setScale(Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
+                    gyro.setScale(typename Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
 
             case ImuAccelerometer:
                 if (currentState == StateBoth || currentState == StateAccelerometer)
-                    accel.setScale(Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
+                    accel.setScale(typename Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
             }
         }
@@ -152,6 +174,10 @@ namespace lsm330dlc {
             setMode(0);
         }
 
+        //Changes the device settings. The device has no configurable settings.
+        void configure(uint8_t configInfo) {
+        }
+
 /*
         void dataRequest() {
             switch (currentState) {
@@ -207,6 +233,12 @@ namespace lsm330dlc {
                     readGyroSample(mode);
                 }
                 break;
+
+            case StateDiagnostic:
+                if (event == GyroscopeAvailable) {
+                    readDiagnosticSample(mode);
+                }
+                break;
             }
         }
     };
@@ -0,0 +1,87 @@
+#ifndef __EV3_LSM6DS3_EEPROM_LAYOUT_H
+#define __EV3_LSM6DS3_EEPROM_LAYOUT_H
+
+#include <stdint.h>
+#include <stm8/eeprom.h>
+#include <sensors/traits/scale_count.h>
+#include <math/matrix.h>
+#include <utils/copy.h>
+#include <utils/crc.h>
+#include <utils/inline.h>
+
+//Each sensor supports a number of modes with different full-range scales
+//Each mode should be calibrated individually and we keep a transformation matrix
+//for each mode
+typedef math::DenseMatrix<int16_t, 4, 3, utils::WordCopy> TranformationMatrix;
+
+//The matrices are calibrated at several die temperatures and interpolated at runtime
+static const uint8_t TEMPERATURE_POINTS = 2;
+
+//Calibration record sent by the host: the matrix, the die temperature and the point index
+typedef math::DenseMatrix<int16_t, 1, TranformationMatrix::size + 2, utils::WordCopy> CalibrationRecord;
+
+//Version of the EEPROM data layout. It should be changed with any change of EepromData.
+static const uint8_t EEPROM_LAYOUT_VERSION = 1;
+
+//The sizes of all members are multiple of 4 bytes to keep the matrices
+//of the next device aligned for the word programming
+template <typename T>
+class EepromData {
+private:
+    static const uint8_t scales = sensors::traits::scale_count<T>::value;
+
+    //The header is written after the data, so the interrupted write leaves the wrong checksum
+    struct Header {
+        uint8_t version;
+        //Number of the device scales, it changes the section size
+        uint8_t scales;
+        uint16_t crc;
+    };
+
+    Header header;
+    //The matrices of the first point have the same layout as the single matrix per scale
+    TranformationMatrix matrices[TEMPERATURE_POINTS][scales];
+    int16_t temperatures[TEMPERATURE_POINTS][scales];
+    //Number of the calibrated points for each scale
+    uint8_t pointCounts[(scales + 3) & ~3];
+public:
+    static const uint8_t temperature_points = TEMPERATURE_POINTS;
+
+    static_assert(sizeof(matrices) <= 256, "Cannot use 8-bit index in pointer arithmetic");
+    
+    INLINE int16_t* get(uint8_t scale) {
+        return (int16_t*)((uint8_t*)(matrices[0]) + uint8_t(scale * sizeof(matrices[0][0])));
+    }
+
+    INLINE int16_t* get(uint8_t scale, uint8_t point) {
+        return (int16_t*)((uint8_t*)(matrices[0]) + uint8_t((point * scales + scale) * sizeof(matrices[0][0])));
+    }
+
+    INLINE int16_t* temperature(uint8_t scale, uint8_t point) {
+        return &temperatures[point][scale];
+    }
+
+    INLINE uint8_t* points(uint8_t scale) {
+        return &pointCounts[scale];
+    }
+
+    //Checks the section written by this firmware is not damaged.
+    //It is called at start, so it is not performance critical.
+    bool isValid() const {
+        return header.version == EEPROM_LAYOUT_VERSION && header.scales == scales && header.crc == checksum();
+    }
+
+    //Writes the header for the current section data
+    void seal(stm8::EepromWriter& writer) {
+        Header value = {EEPROM_LAYOUT_VERSION, scales, checksum()};
+        writer.write((uint8_t*)&header, (const uint8_t*)&value, sizeof(value));
+    }
+
+private:
+    //The checksum of the data following the header
+    uint16_t checksum() const {
+        return utils::crc16((const uint8_t*)matrices, uint16_t((const uint8_t*)(this + 1) - (const uint8_t*)matrices));
+    }
+};
+
+#endif //__EV3_LSM6DS3_EEPROM_LAYOUT_H
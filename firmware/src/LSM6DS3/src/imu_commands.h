@@ -14,6 +14,16 @@ namespace lsm6ds3 {
             //Return device to the state right after power on
             DEVICE_RESET  = 0x11,
 
+            //Data acquisition method in IMU-ALL mode
+            FIFO_DISABLE  = 0x12, //Read each sample on data ready interrupt
+            FIFO_ENABLE   = 0x13, //Sample at higher rate and average the batches collected by the sensor's FIFO
+
+            //Sets the angles accumulated in IMU-ANG mode to zero
+            ANGLE_RESET   = 0x14,
+
+            //Writes the gyro bias tracked during stillness into the calibration matrix of the current scale
+            BIAS_SAVE     = 0x15,
+
             //Accelerometer sensitivity
             ACC_SCALE_2G  = 0x20,
             ACC_SCALE_4G  = 0x21,
@@ -38,6 +48,30 @@ namespace lsm6ds3 {
             CALIBRATE_GYRO_1000DPS = 0x52,
             CALIBRATE_GYRO_2000DPS = 0x53,
             CALIBRATE_GYRO_125DPS  = 0x54,
+
+            //Accelerometer output data rate.
+            //It is limited by the number of data frames the UART link can carry per second.
+            //The gyroscope of LSM6DS3 runs up to 1660 Hz, so only the accelerometer has the higher rates.
+            ACC_ODR_13HZ   = 0x60,
+            ACC_ODR_26HZ   = 0x61,
+            ACC_ODR_52HZ   = 0x62,
+            ACC_ODR_104HZ  = 0x63,
+            ACC_ODR_208HZ  = 0x64,
+            ACC_ODR_416HZ  = 0x65,
+            ACC_ODR_833HZ  = 0x66,
+            ACC_ODR_1660HZ = 0x67,
+            ACC_ODR_3330HZ = 0x68,
+            ACC_ODR_6660HZ = 0x69,
+
+            //Gyroscope output data rate
+            GYRO_ODR_13HZ   = 0x70,
+            GYRO_ODR_26HZ   = 0x71,
+            GYRO_ODR_52HZ   = 0x72,
+            GYRO_ODR_104HZ  = 0x73,
+            GYRO_ODR_208HZ  = 0x74,
+            GYRO_ODR_416HZ  = 0x75,
+            GYRO_ODR_833HZ  = 0x76,
+            GYRO_ODR_1660HZ = 0x77,
         };
 
         //Checks if it is the command to change sensor's scale
@@ -60,6 +94,25 @@ namespace lsm6ds3 {
         static uint8_t getEepromInfo(uint8_t command) {
             return getInfo<0x40>(command);
         }
+
+        static bool isConfigCommand(uint8_t command) {
+            return (command >= FIFO_DISABLE && command <= BIAS_SAVE) ||
+                   (command >= ACC_ODR_13HZ && command <= ACC_ODR_6660HZ) ||
+                   (command >= GYRO_ODR_13HZ && command <= GYRO_ODR_1660HZ);
+        }
+
+        //Packs the device kind and the setting value into device config info byte
+        //See command_info.h file for detals
+        static uint8_t getConfigInfo(uint8_t command) {
+            if (command <= BIAS_SAVE)
+                return ImuReserved | (command - FIFO_DISABLE);
+            //The accelerometer rates above 1660 Hz do not fit the 3-bit setting value.
+            //LSM6DS3 has no magnetometer, so they use its device number.
+            if (command >= ACC_ODR_3330HZ && command <= ACC_ODR_6660HZ)
+                return ImuMagnetometer | (command - ACC_ODR_3330HZ);
+            //ODR index for the device
+            return getInfo<0x60>(command);
+        }
     };
 }
 }
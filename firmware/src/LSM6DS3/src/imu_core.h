@@ -1,10 +1,18 @@
 #ifndef __EV3_LSM6DS3_IMU_CORE_H
 #define __EV3_LSM6DS3_IMU_CORE_H
 
+#include <string.h>
 #include <mpl/vector_c.h>
+#include <mpl/math.h>
 #include <sensors/lsm6ds3/Accelerometer.h>
 #include <sensors/lsm6ds3/Gyroscope.h>
+#include <sensors/lsm6ds3/Fifo.h>
+#include <sensors/lsm6ds3/Imu.h>
+#include <math/fusion.h>
+#include <utils/byte_order.h>
 #include <ev3/command_info.h>
+#include <ev3/imu/imu.h>
+#include <ev3/diagnostics.h>
 
 namespace ev3 {
 namespace lsm6ds3 {
@@ -16,40 +24,168 @@ namespace lsm6ds3 {
             StateInit, //Initial state should have zero value to place sensor object into bss section
             StateBoth,
             StateAccelerometer,
-            StateGyroscope
+            StateGyroscope,
+            StateBothTimestamp,
+            StateQuaternion,
+            StateAngle,
+            StateStatus,
+            StateDiagnostic
         };
 
         typedef sensors::lsm6ds3::Accelerometer<ImuTransport> Accelerometer;
         typedef sensors::lsm6ds3::Gyroscope<ImuTransport> Gyroscope;
+        typedef sensors::lsm6ds3::Fifo<ImuTransport> Fifo;
+        typedef sensors::lsm6ds3::Imu<ImuTransport> Imu;
         typedef Accelerometer accel_type;
         typedef Gyroscope gyro_type;
 
-        static const uint8_t MODE_COUNT = 3;
+        //Values of the settings common for all devices
+        enum CommonSetting {
+            //Data acquisition methods in StateBoth
+            AcquisitionDirect, //Both samples are read in one burst on gyro data ready interrupt
+            AcquisitionFifo,   //The FIFO collects BATCH_SIZE samples, the MCU reads and averages them
+
+            ResetAngle,        //Sets the accumulated angles to zero
+            SaveBias           //Writes the tracked gyro bias into the calibration matrix
+        };
+
+        //EEPROM check result flags in the status mode
+        enum EepromStatus {
+            AccelEepromValid = 0x01,
+            GyroEepromValid = 0x02
+        };
+
+        //Number of samples averaged into one sample sent to the host.
+        //The output data rate is 1660Hz / BATCH_SIZE.
+        static const uint8_t BATCH_SIZE = 4;
+
+        //Output data rate index N selects 13 * 2^N Hz in the direct acquisition modes.
+        //The index is the ODR register value minus one.
+        static const uint8_t MIN_RATE = 13; //Hz
+        static const uint8_t DEFAULT_RATE = 5; //416Hz
+        //The first accelerometer rate index of the config events with the magnetometer device number
+        //(see Commands::getConfigInfo), 3330Hz
+        static const uint8_t ACCEL_HIGH_RATE = 8;
+
+        static const uint8_t MODE_COUNT = 8;
+
+        //The orientation filter runs at the gyro rate limited by this range.
+        //The upper limit keeps the filter within the MCU time budget.
+        static const uint8_t FUSION_MIN_RATE = math::OrientationFilter::MIN_RATE; //104Hz
+        static const uint8_t FUSION_MAX_RATE = 5; //416Hz
 
         static const uint8_t ACCEL_SAMPLES = 3;
         static const uint8_t GYRO_SAMPLES = 3;
         static const uint8_t FULL_SAMPLES = ACCEL_SAMPLES + GYRO_SAMPLES;
+        //The 24-bit timestamp is sent as two words: the low word and the high byte extended by zero
+        static const uint8_t TIMESTAMP_SAMPLES = FULL_SAMPLES + 2;
+        static const uint8_t QUATERNION_SAMPLES = math::OrientationFilter::SIZE;
+        static const uint8_t ANGLE_SAMPLES = 3;
+        //EEPROM status flags, the die temperature, the EEPROM write counter
+        //and the data event counters (ev3::imu::EventStatistics)
+        static const uint8_t STATUS_SAMPLES = 5;
 
         static const uint8_t FULL_SAMPLE_SIZE = FULL_SAMPLES * sizeof(uint16_t);
         static const uint8_t ACCEL_SAMPLE_SIZE = ACCEL_SAMPLES * sizeof(uint16_t);
         static const uint8_t GYRO_SAMPLE_SIZE = GYRO_SAMPLES * sizeof(uint16_t);
+        static const uint8_t TIMESTAMP_SAMPLE_SIZE = TIMESTAMP_SAMPLES * sizeof(uint16_t);
+        static const uint8_t QUATERNION_SAMPLE_SIZE = QUATERNION_SAMPLES * sizeof(uint16_t);
+        static const uint8_t ANGLE_SAMPLE_SIZE = ANGLE_SAMPLES * sizeof(uint32_t);
+        static const uint8_t STATUS_SAMPLE_SIZE = STATUS_SAMPLES * sizeof(uint16_t);
+        static const uint8_t DIAGNOSTIC_SAMPLE_SIZE = sizeof(ev3::Diagnostics);
+
+        //The angles are accumulated in units of 125dps gyro digit per 1664Hz sample, about 2.63e-6 degree.
+        //The accumulators wrap around, the host should use the difference of the values.
+        static const uint8_t ANGLE_RATE = 7; //1664Hz
+        //The host polls the status for the EEPROM write completion
+        static const uint8_t STATUS_RATE = 3; //104Hz
 
     public:
         //Sensor modes info
         typedef mpl::make_type_list<
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'L', 'L'>::type,      FULL_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'C', 'C'>::type,      ACCEL_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
-            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'R', 'A', 'T', 'E'>::type, GYRO_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'R', 'A', 'T', 'E'>::type, GYRO_SAMPLES,  ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'L', 'L', '-', 'T', 'S'>::type, TIMESTAMP_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'Q', 'U', 'A', 'T'>::type, QUATERNION_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'N', 'G'>::type,      ANGLE_SAMPLES, ev3::Int32, 10, 0, true, -INT32_MAX, INT32_MAX>,
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'S', 'T', 'A', 'T'>::type, STATUS_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            //Hidden mode, the host selects it by the index
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'D', 'I', 'A', 'G'>::type, ev3::Diagnostics::COUNT, ev3::Int16, 5, 0, false, SHRT_MIN, SHRT_MAX>
         >::type mode_list;
 
         //Data sample size
-        static const uint8_t sample_size = FULL_SAMPLE_SIZE;
+        static const uint8_t sample_size = TIMESTAMP_SAMPLE_SIZE;
 
     private:
         SampleProvider<Accelerometer> accel;
         SampleProvider<Gyroscope> gyro;
+        Fifo fifo;
+        Imu imu;
 
         State currentState;
+        uint8_t acquisition;
+        //EepromStatus flags of the calibration data check
+        uint8_t eepromStatus;
+        //Number of the processed EEPROM write commands, it wraps around
+        uint8_t eepromWrites;
+
+        //Output data rates requested by the host
+        uint8_t accelRate;
+        uint8_t gyroRate;
+
+        math::OrientationFilter orientation;
+
+        //Integrated gyro samples
+        int32_t angle[3];
+        //Converts the gyro sample to the angle units
+        uint8_t angleShift;
+
+        //The modes that process every sample send a frame once per (frameSkip + 1) samples
+        uint8_t frameSkip;
+        uint8_t frameCount;
+
+        //The die temperature is read once per 256 data events
+        uint8_t temperatureCount;
+
+        typedef int16_t sample_type[3];
+
+        //Sums the data sets read from the FIFO
+        class BatchAccumulator {
+            const ImuCore* core;
+        public:
+            int16_t pattern[Fifo::PATTERN_LENGTH];
+            int32_t sum[Fifo::PATTERN_LENGTH];
+
+            BatchAccumulator(const ImuCore* core_)
+                : core(core_)
+            {
+            }
+
+            void clear() {
+                memset(sum, 0, sizeof(sum));
+            }
+
+            //The FIFO data set keeps the gyro sample at first and then the accel sample
+            sample_type& gyroSample() { return *(sample_type*)pattern; }
+            sample_type& accelSample() { return *(sample_type*)(pattern + 3); }
+
+            //Adds the data set read into the pattern buffer
+            void operator()(uint8_t*) {
+                core->gyro.toNative(gyroSample());
+                core->accel.toNative(accelSample());
+                for (uint8_t i = 0; i < Fifo::PATTERN_LENGTH; ++i) {
+                    sum[i] += pattern[i];
+                }
+            }
+
+            //Places the average value into the pattern buffer
+            void average() {
+                for (uint8_t i = 0; i < Fifo::PATTERN_LENGTH; ++i) {
+                    pattern[i] = int16_t(sum[i] / BATCH_SIZE);
+                }
+            }
+        };
 
         Derived* sender() {
             return static_cast<Derived*>(this);
@@ -62,7 +198,7 @@ namespace lsm6ds3 {
 
         template <uint8_t offset, uint8_t size>
         void sendSample(uint8_t mode) {
-            sender()->sendData<offset, size>(mode);
+            sender()->template sendData<offset, size>(mode);
         }
 
         //Convert sensor mode to the state
@@ -76,30 +212,406 @@ namespace lsm6ds3 {
         }
 
         INLINE void readAccelerometerSample(uint8_t mode) {
-            accel.readSample(buffer(), ACCEL_SAMPLE_SIZE);
-            sendSample<0, ACCEL_SAMPLE_SIZE>(mode);
+            if (accel.readSample(buffer(), ACCEL_SAMPLE_SIZE))
+                sendSample<0, ACCEL_SAMPLE_SIZE>(mode);
         }
 
         INLINE void readGyroscopeSample(uint8_t mode) {
+            //The accelerometer is powered down, so the motion cannot be detected
+            //and the bias estimate is kept (see BiasTrackingProvider.h)
+            gyro.setMotion(true);
             //The gyro sample uses the same place in the buffer is all modes to avoid
             //data placement conflicts during switching from gyro to accel+gyro mode
-            gyro.readSample(buffer() + ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE);
-            sendSample<ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE>(mode);
+            if (gyro.readSample(buffer() + ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE))
+                sendSample<ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE>(mode);
+        }
+
+        //Converts the rate index to the ODR register value
+        template <typename Device>
+        static typename Device::ODR getODR(uint8_t rate) {
+            return static_cast<typename Device::ODR>((rate + 1) << 4);
+        }
+
+        //Returns the highest rate not exceeding the requested one and the number of
+        //frames with the specified payload the UART link can carry per second.
+        //The decimating provider sends one frame per factor samples.
+        template <uint8_t size, uint8_t factor>
+        uint8_t limitRate(uint8_t rate) {
+            uint16_t frameRate = sender()->template getFrameRate<size>();
+            while (rate != 0 && ((uint16_t(MIN_RATE) << rate) / factor) > frameRate) {
+                --rate;
+            }
+            return rate;
+        }
+
+        //The data ready interrupt of the device sends the frames, so its rate is limited by the link
+        template <typename Device, uint8_t size>
+        typename Device::ODR getFrameODR(uint8_t rate) {
+            return getODR<Device>(limitRate<size, SampleProvider<Device>::decimation_factor>(rate));
+        }
+
+        //The gyro data ready interrupt reads both sensors of the combined sample,
+        //so the accelerometer does not run faster than the gyro: its samples
+        //between the reads would be lost. The slower accelerometer repeats
+        //its last sample until the next one.
+        template <uint8_t size>
+        typename Accelerometer::ODR getCombinedAccelODR() {
+            uint8_t rate = limitRate<size, SampleProvider<Gyroscope>::decimation_factor>(gyroRate);
+            return getODR<Accelerometer>(accelRate < rate ? accelRate : rate);
+        }
+
+        //Reads gyro and accel samples in one burst and places them into the buffer.
+        //The burst follows the gyro data ready, the accelerometer sample is the latest one
+        //it has at that time (see getCombinedAccelODR).
+        //Returns true if the output sample is ready to be sent.
+        bool readCombinedSample() {
+            typename Imu::Sample sample;
+            imu.readAll(sample);
+
+            accel.toNative(*(sample_type*)sample.accel);
+            gyro.toNative(*(sample_type*)sample.gyro);
+            //Both providers are reset together, so they complete the output samples together
+            bool accelReady = accel.decimate(*(sample_type*)sample.accel);
+            if (gyro.decimate(*(sample_type*)sample.gyro) && accelReady) {
+                accel.fromNative(*(sample_type*)sample.accel, buffer());
+                gyro.setMotion(accel.isMoving());
+                gyro.fromNative(*(sample_type*)sample.gyro, buffer() + ACCEL_SAMPLE_SIZE);
+                return true;
+            }
+            return false;
+        }
+
+        //Appends the chip timestamp to the combined sample.
+        //The timestamp is read just after the sample, so it does not depend
+        //on the UART and host latency. The frame words are little-endian,
+        //so the counter bytes are placed in the order they are read.
+        INLINE void readTimestampedSample(uint8_t mode) {
+            if (readCombinedSample()) {
+                uint8_t* timestamp = buffer() + FULL_SAMPLE_SIZE;
+                imu.readTimestamp(timestamp);
+                timestamp[Imu::TIMESTAMP_SIZE] = 0;
+                sendSample<0, TIMESTAMP_SAMPLE_SIZE>(mode);
+            }
+        }
+
+        //Returns the orientation filter rate for the requested gyro rate
+        uint8_t getFusionRate() const {
+            if (gyroRate < FUSION_MIN_RATE)
+                return FUSION_MIN_RATE;
+            return gyroRate > FUSION_MAX_RATE ? FUSION_MAX_RATE : gyroRate;
+        }
+
+        //Passes the current sensor settings to the orientation filter.
+        //The filter runs at the full rate, and the quaternion frames are skipped
+        //if the link cannot carry all of them.
+        void configureFusion() {
+            uint8_t rate = getFusionRate();
+            orientation.configure(getGyroRange(), uint8_t(accel.getScale()), rate);
+
+            initFrameSkip<QUATERNION_SAMPLE_SIZE, 1>(rate);
+        }
+
+        //Skips the frames the link cannot carry at the specified sample rate
+        template <uint8_t size, uint8_t factor>
+        void initFrameSkip(uint8_t rate) {
+            frameSkip = (1 << (rate - limitRate<size, factor>(rate))) - 1;
+            frameCount = 0;
+        }
+
+        //Returns true if the current sample should be sent
+        bool isFrameDue() {
+            if (frameCount == frameSkip) {
+                frameCount = 0;
+                return true;
+            }
+            ++frameCount;
+            return false;
+        }
+
+        //Returns the gyro range: the full scale is 125dps * 2^N
+        uint8_t getGyroRange() const {
+            typename Gyroscope::Scale gyroScale = gyro.getScale();
+            //SCALE_125DPS is the only one out of order
+            return gyroScale == Gyroscope::SCALE_125DPS ? 0 : uint8_t(gyroScale) + 1;
+        }
+
+        //Passes the current gyro settings to the angle integration
+        void configureAngle() {
+            typedef SampleProvider<Gyroscope> gyro_provider;
+            //The decimating provider returns the average of the samples, so it is multiplied by the factor
+            angleShift = getGyroRange() + ANGLE_RATE + mpl::log2<gyro_provider::decimation_factor>::value - gyroRate;
+            initFrameSkip<ANGLE_SAMPLE_SIZE, gyro_provider::decimation_factor>(gyroRate);
+        }
+
+        void resetAngle() {
+            memset(angle, 0, sizeof(angle));
+        }
+
+        //Integrates the calibrated gyro sample and sends the angles
+        void readAngleSample(uint8_t mode) {
+            //The bias estimate is kept without the accelerometer, the same as in the gyro mode
+            gyro.setMotion(true);
+            sample_type sample;
+            if (!gyro.readSample((uint8_t*)sample, sizeof(sample)))
+                return;
+            //The provider produces little-endian output
+            swap_sample(sample);
+            //The left shift of a negative value is undefined, so the scale is multiplied
+            for (uint8_t i = 0; i < ANGLE_SAMPLES; ++i) {
+                angle[i] += int32_t(sample[i]) * (int32_t(1) << angleShift);
+            }
+
+            if (isFrameDue()) {
+                //Int32 values are sent in little-endian format
+                uint8_t* data = buffer();
+                for (uint8_t i = 0; i < ANGLE_SAMPLES; ++i) {
+                    uint32_t value = uint32_t(angle[i]);
+                    *data++ = uint8_t(value);
+                    *data++ = uint8_t(value >> 8);
+                    *data++ = uint8_t(value >> 16);
+                    *data++ = uint8_t(value >> 24);
+                }
+                sendSample<0, ANGLE_SAMPLE_SIZE>(mode);
+            }
         }
 
-        INLINE void initCombo() {
-            gyro.init(Gyroscope::SCALE_245DPS, Gyroscope::ODR_416Hz, Gyroscope::InterruptEnabled);
-            accel.init(Accelerometer::SCALE_2G, Accelerometer::ODR_416Hz, Accelerometer::InterruptEnabled);
+        //Updates the orientation with the calibrated samples and sends the quaternion
+        void readQuaternionSample(uint8_t mode) {
+            typename Imu::Sample sample;
+            imu.readAll(sample);
+
+            accel.toNative(*(sample_type*)sample.accel);
+            gyro.toNative(*(sample_type*)sample.gyro);
+            //The providers produce little-endian output, the filter needs MCU byte order
+            sample_type accelSample, gyroSample;
+            accel.fromNative(*(sample_type*)sample.accel, (uint8_t*)accelSample);
+            gyro.setMotion(accel.isMoving());
+            gyro.fromNative(*(sample_type*)sample.gyro, (uint8_t*)gyroSample);
+            swap_sample(accelSample);
+            swap_sample(gyroSample);
+
+            orientation.update(gyroSample, accelSample);
+
+            if (isFrameDue()) {
+                int16_t* quaternion = (int16_t*)buffer();
+                orientation.getQuaternion(quaternion);
+                for (uint8_t i = 0; i < QUATERNION_SAMPLES; ++i) {
+                    quaternion[i] = swap_bytes(quaternion[i]);
+                }
+                sendSample<0, QUATERNION_SAMPLE_SIZE>(mode);
+            }
+        }
+
+        //Passes the die temperature to the sample correction at a low rate
+        void updateTemperature() {
+            if (++temperatureCount == 0) {
+                int16_t temperature = imu.readTemperature();
+                accel.setTemperature(temperature);
+                gyro.setTemperature(temperature);
+            }
+        }
+
+        //Sends the EEPROM check result, the die temperature, the EEPROM write counter
+        //and the data event counters
+        void readStatusSample(uint8_t mode) {
+            //Reading the sample releases the data ready line
+            sample_type sample;
+            imu.readGyroSample((uint8_t*)sample, sizeof(sample));
+
+            int16_t* status = (int16_t*)buffer();
+            status[0] = swap_bytes(eepromStatus);
+            status[1] = swap_bytes(imu.readTemperature());
+            status[2] = swap_bytes(int16_t(eepromWrites));
+            const ev3::imu::EventStatistics& statistics = sender()->getStatistics();
+            status[3] = swap_bytes(int16_t(statistics.overruns));
+            status[4] = swap_bytes(int16_t(statistics.maxLatency));
+            sendSample<0, STATUS_SAMPLE_SIZE>(mode);
+        }
+
+        //Sends the pipeline counters or the profiler record selected by the host
+        void readDiagnosticSample(uint8_t mode) {
+            //Reading the sample releases the data ready line
+            sample_type sample;
+            imu.readGyroSample((uint8_t*)sample, sizeof(sample));
+
+            sender()->readDiagnostics(buffer(), ImuTransport::getErrors());
+            sendSample<0, DIAGNOSTIC_SAMPLE_SIZE>(mode);
+        }
+
+        //Checks the calibration data of the devices.
+        //The devices with damaged data use the identity transformation.
+        void checkEeprom() {
+            eepromStatus = (accel.validateEeprom() ? AccelEepromValid : 0) | (gyro.validateEeprom() ? GyroEepromValid : 0);
+        }
+
+        //Reads all batches collected by the FIFO and sends the last one.
+        //The FIFO threshold interrupt is generated by the rising edge only,
+        //so we read the data until the FIFO level drops below the threshold.
+        void readBatch(uint8_t mode) {
+            BatchAccumulator batch(this);
+            bool ready = false;
+            typename Fifo::Status status;
+            for (;;) {
+                fifo.getStatus(status);
+                if (status.isOverrun() || status.pattern() != 0) {
+                    //The data set alignment is lost, start collecting again
+                    fifo.restart();
+                    break;
+                }
+                if (status.unread() < BATCH_SIZE * Fifo::PATTERN_LENGTH)
+                    break;
+
+                batch.clear();
+                fifo.readPatterns(batch.pattern, BATCH_SIZE, batch);
+                ready = true;
+            }
+
+            if (ready) {
+                batch.average();
+                accel.fromNative(batch.accelSample(), buffer());
+                gyro.setMotion(accel.isMoving());
+                gyro.fromNative(batch.gyroSample(), buffer() + ACCEL_SAMPLE_SIZE);
+                sendSample<0, FULL_SAMPLE_SIZE>(mode);
+            }
+        }
+
+        //Configures the sensor according to the current state
+        void initState() {
+            accel.resetDecimation();
+            gyro.resetDecimation();
+
+            if (currentState != StateBothTimestamp)
+                imu.disableTimestamp();
+
+            switch (currentState) {
+            case StateBoth:
+                if (acquisition == AcquisitionFifo) {
+                    gyro.init(Gyroscope::SCALE_245DPS, Gyroscope::ODR_1660Hz, Gyroscope::InterruptDisabled);
+                    accel.init(Accelerometer::SCALE_2G, Accelerometer::ODR_1660Hz, Accelerometer::InterruptDisabled);
+                    fifo.init(Fifo::ODR_1660Hz, BATCH_SIZE);
+                } else {
+                    //Gyro data ready interrupt triggers reading of both samples
+                    fifo.reset();
+                    imu.enableBlockDataUpdate();
+                    gyro.init(Gyroscope::SCALE_245DPS, getFrameODR<Gyroscope, FULL_SAMPLE_SIZE>(gyroRate), Gyroscope::InterruptEnabled);
+                    accel.init(Accelerometer::SCALE_2G, getCombinedAccelODR<FULL_SAMPLE_SIZE>(), Accelerometer::InterruptDisabled);
+                }
+                break;
+
+            case StateAccelerometer:
+                fifo.reset();
+                gyro.reset();
+                accel.init(Accelerometer::SCALE_2G, getFrameODR<Accelerometer, ACCEL_SAMPLE_SIZE>(accelRate), Accelerometer::InterruptEnabled);
+                break;
+
+            case StateGyroscope:
+                fifo.reset();
+                gyro.init(Gyroscope::SCALE_245DPS, getFrameODR<Gyroscope, GYRO_SAMPLE_SIZE>(gyroRate), Gyroscope::InterruptEnabled);
+                accel.reset();
+                break;
+
+            case StateBothTimestamp:
+                //Always uses the direct acquisition, because the FIFO batch has no single sample time
+                fifo.reset();
+                imu.enableBlockDataUpdate();
+                imu.enableTimestamp();
+                gyro.init(Gyroscope::SCALE_245DPS, getFrameODR<Gyroscope, TIMESTAMP_SAMPLE_SIZE>(gyroRate), Gyroscope::InterruptEnabled);
+                accel.init(Accelerometer::SCALE_2G, getCombinedAccelODR<TIMESTAMP_SAMPLE_SIZE>(), Accelerometer::InterruptDisabled);
+                break;
+
+            case StateQuaternion:
+                //Both sensors run at the filter rate, the gyro data ready interrupt triggers the update
+                fifo.reset();
+                imu.enableBlockDataUpdate();
+                gyro.init(Gyroscope::SCALE_245DPS, getODR<Gyroscope>(getFusionRate()), Gyroscope::InterruptEnabled);
+                accel.init(Accelerometer::SCALE_2G, getODR<Accelerometer>(getFusionRate()), Accelerometer::InterruptDisabled);
+                configureFusion();
+                orientation.reset();
+                break;
+
+            case StateAngle:
+                //The gyro runs at the requested rate, and every sample is integrated
+                fifo.reset();
+                gyro.init(Gyroscope::SCALE_245DPS, getODR<Gyroscope>(gyroRate), Gyroscope::InterruptEnabled);
+                accel.reset();
+                configureAngle();
+                resetAngle();
+                break;
+
+            case StateStatus:
+                //The gyro data ready interrupt sends the status
+                fifo.reset();
+                gyro.init(Gyroscope::SCALE_245DPS, getODR<Gyroscope>(STATUS_RATE), Gyroscope::InterruptEnabled);
+                accel.reset();
+                break;
+
+            case StateDiagnostic:
+                //The gyro data ready interrupt sends the counters at the lowest rate
+                fifo.reset();
+                gyro.init(Gyroscope::SCALE_245DPS, getODR<Gyroscope>(0), Gyroscope::InterruptEnabled);
+                accel.reset();
+                break;
+
+            case StateInit:
+                //The mode has not been selected yet
+                break;
+            }
+        }
+
+        //Applies the requested output data rates without changing the scales.
+        //The FIFO acquisition uses its own fixed rate.
+        void updateRates() {
+            switch (currentState) {
+            case StateBoth:
+                if (acquisition == AcquisitionDirect) {
+                    gyro.setODR(getFrameODR<Gyroscope, FULL_SAMPLE_SIZE>(gyroRate));
+                    accel.setODR(getCombinedAccelODR<FULL_SAMPLE_SIZE>());
+                }
+                break;
+
+            case StateAccelerometer:
+                accel.setODR(getFrameODR<Accelerometer, ACCEL_SAMPLE_SIZE>(accelRate));
+                break;
+
+            case StateGyroscope:
+                gyro.setODR(getFrameODR<Gyroscope, GYRO_SAMPLE_SIZE>(gyroRate));
+                break;
+
+            case StateBothTimestamp:
+                gyro.setODR(getFrameODR<Gyroscope, TIMESTAMP_SAMPLE_SIZE>(gyroRate));
+                accel.setODR(getCombinedAccelODR<TIMESTAMP_SAMPLE_SIZE>());
+                break;
+
+            case StateQuaternion:
+                gyro.setODR(getODR<Gyroscope>(getFusionRate()));
+                accel.setODR(getODR<Accelerometer>(getFusionRate()));
+                configureFusion();
+                break;
+
+            case StateAngle:
+                gyro.setODR(getODR<Gyroscope>(gyroRate));
+                configureAngle();
+                break;
+
+            case StateStatus:
+            case StateDiagnostic:
+            case StateInit:
+                //The status and the diagnostic modes use the fixed rates
+                break;
+            }
         }
 
     public:
         INLINE ImuCore()
-            : currentState(StateInit)
+            : currentState(StateInit), acquisition(AcquisitionDirect), eepromStatus(0), eepromWrites(0),
+              accelRate(DEFAULT_RATE), gyroRate(DEFAULT_RATE),
+              angleShift(0), frameSkip(0), frameCount(0), temperatureCount(0)
         {
         }
 
         //Stops generation of data events
         INLINE void stop() {
+            fifo.reset();
             accel.reset();
             gyro.reset();
             currentState = StateInit;
@@ -108,6 +620,7 @@ namespace lsm6ds3 {
         //Starts generation of data events
         INLINE void start() {
              if (gyro.checkDevice()) {
+                checkEeprom();
                 setMode(0);
              }
         }
@@ -117,23 +630,7 @@ namespace lsm6ds3 {
             State newState = getState(mode);
             if (newState != currentState) {
                 currentState = newState;
-
-                switch (currentState) {
-                case StateBoth:
-                    gyro.init(Gyroscope::SCALE_245DPS, Gyroscope::ODR_416Hz, Gyroscope::InterruptEnabled);
-                    accel.init(Accelerometer::SCALE_2G, Accelerometer::ODR_416Hz, Accelerometer::InterruptEnabled);
-                    break;
-
-                case StateAccelerometer:
-                    gyro.reset();
-                    accel.init(Accelerometer::SCALE_2G, Accelerometer::ODR_416Hz, Accelerometer::InterruptEnabled);
-                    break;
-
-                case StateGyroscope:
-                    gyro.init(Gyroscope::SCALE_245DPS, Gyroscope::ODR_416Hz, Gyroscope::InterruptEnabled);
-                    accel.reset();
-                    break;
-                }
+                initState();
             }
         }
 
@@ -141,15 +638,20 @@ namespace lsm6ds3 {
         void setScale(uint8_t scaleInfo) {
             switch (scaleInfo & ScaleInfoMask::Device) {
             case ImuGyroscope:
-                if (currentState == StateBoth || currentState == StateGyroscope)
-                    gyro.setScale(Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
+                if (currentState == StateBoth || currentState == StateGyroscope || currentState == StateBothTimestamp || currentState == StateQuaternion || currentState == StateAngle)
+                    gyro.setScale(typename Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
 
             case ImuAccelerometer:
-                if (currentState == StateBoth || currentState == StateAccelerometer)
-                    accel.setScale(Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
+                if (currentState == StateBoth || currentState == StateAccelerometer || currentState == StateBothTimestamp || currentState == StateQuaternion)
+                    accel.setScale(typename Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
             }
+
+            if (currentState == StateQuaternion)
+                configureFusion();
+            else if (currentState == StateAngle)
+                configureAngle();
         }
 
         //Sets the sensor to initial state
@@ -157,16 +659,55 @@ namespace lsm6ds3 {
             setMode(0);
         }
 
+        //Changes the device settings
+        void configure(uint8_t configInfo) {
+            switch (configInfo & ScaleInfoMask::Device) {
+            case ImuReserved: {
+                    uint8_t newAcquisition = configInfo & ScaleInfoMask::Scale;
+                    if (newAcquisition == ResetAngle) {
+                        resetAngle();
+                    } else if (newAcquisition == SaveBias) {
+                        gyro.saveBias();
+                    } else if (newAcquisition != acquisition) {
+                        acquisition = newAcquisition;
+                        //Apply the new acquisition method if the sensor is running
+                        if (currentState == StateBoth)
+                            initState();
+                    }
+                }
+                break;
+
+            case ImuAccelerometer:
+                accelRate = configInfo & ScaleInfoMask::Scale;
+                updateRates();
+                break;
+
+            case ImuMagnetometer:
+                accelRate = ACCEL_HIGH_RATE + (configInfo & ScaleInfoMask::Scale);
+                updateRates();
+                break;
+
+            case ImuGyroscope:
+                gyroRate = configInfo & ScaleInfoMask::Scale;
+                updateRates();
+                break;
+            }
+        }
+
         void updateEeprom(uint8_t eepromInfo, const uint8_t* data, uint8_t size) {
             switch (eepromInfo & ScaleInfoMask::Device) {
             case ImuGyroscope:
-                gyro.updateEeprom(Gyroscope::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
+                gyro.updateEeprom(typename Gyroscope::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
                 break;
 
             case ImuAccelerometer:
-                accel.updateEeprom(Accelerometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
+                accel.updateEeprom(typename Accelerometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
                 break;
             }
+            //The written data replaces the damaged one
+            checkEeprom();
+            //The host waits for the counter change instead of the worst case write time
+            ++eepromWrites;
         }
 
 /*
@@ -198,18 +739,19 @@ namespace lsm6ds3 {
 
         //Process data ready event
         void handleEvent(EventSource event) {
+            updateTemperature();
+
             uint8_t mode = getMode(currentState);
             switch (currentState) {
             case StateBoth:
-                switch (event) {
-                case AccelerometerAvailable:
-                    accel.readSample(buffer(), ACCEL_SAMPLE_SIZE);
-                    break;
-                case GyroscopeAvailable:
-                    //Gyroscope event follows the accel event
-                    gyro.readSample(buffer() + ACCEL_SAMPLE_SIZE, GYRO_SAMPLE_SIZE);
-                    sendSample<0, FULL_SAMPLE_SIZE>(mode);
-                    break;
+                if (acquisition == AcquisitionFifo) {
+                    //The FIFO threshold interrupt uses INT1 line, the same as accel data ready interrupt
+                    if (event == AccelerometerAvailable) {
+                        readBatch(mode);
+                    }
+                } else if (event == GyroscopeAvailable) {
+                    if (readCombinedSample())
+                        sendSample<0, FULL_SAMPLE_SIZE>(mode);
                 }
                 break;
 
@@ -224,6 +766,40 @@ namespace lsm6ds3 {
                     readGyroscopeSample(mode);
                 }
                 break;
+
+            case StateBothTimestamp:
+                if (event == GyroscopeAvailable) {
+                    readTimestampedSample(mode);
+                }
+                break;
+
+            case StateQuaternion:
+                if (event == GyroscopeAvailable) {
+                    readQuaternionSample(mode);
+                }
+                break;
+
+            case StateAngle:
+                if (event == GyroscopeAvailable) {
+                    readAngleSample(mode);
+                }
+                break;
+
+            case StateStatus:
+                if (event == GyroscopeAvailable) {
+                    readStatusSample(mode);
+                }
+                break;
+
+            case StateDiagnostic:
+                if (event == GyroscopeAvailable) {
+                    readDiagnosticSample(mode);
+                }
+                break;
+
+            case StateInit:
+                //The data ready interrupts are disabled until the mode is selected
+                break;
             }
         }
     };
@@ -19,9 +19,13 @@
 
 #include <stm8/eeprom.h>
 #include <sensors/SimpleProvider.h>
-#include <sensors/TransformProvider.h>
+#include <sensors/ThermalTransformProvider.h>
+#include <sensors/BiasTrackingProvider.h>
+#include <sensors/DecimationProvider.h>
 #include <math/matrix.h>
+#include <utils/crc.h>
 
+#include "eeprom_layout.h"
 #include "imu_core.h"
 #include "imu_commands.h"
 
@@ -32,18 +36,51 @@ using namespace sensors;
 //
 //      Process types
 //
-typedef OS::process<OS::pr0, 150> CommandHandler;
-typedef OS::process<OS::pr1, 150> SensorHandler;
+//Stack sizes in bytes, the diagnostic mode reports the stack usage.
+//The single event loop (EV3_SINGLE_PROCESS) processes the sensor events on top
+//of the protocol handler calls, so it needs more stack than each of the separate processes.
+#if EV3_SINGLE_PROCESS
+static const size_t COMMAND_STACK_SIZE = 200;
+static const size_t SENSOR_STACK_SIZE = 0;
+#else
+static const size_t COMMAND_STACK_SIZE = 150;
+static const size_t SENSOR_STACK_SIZE = 150;
+#endif
 
+typedef OS::process<OS::pr0, COMMAND_STACK_SIZE> CommandHandler;
 template<> void CommandHandler::exec();
+
+#if !EV3_SINGLE_PROCESS
+typedef OS::process<OS::pr1, SENSOR_STACK_SIZE> SensorHandler;
 template<> void SensorHandler::exec();
+#endif
 
 //---------------------------------------------------------------------------
 //
 //      Process objects
 //
 CommandHandler commandHandler @ "HW_STACK";
+#if !EV3_SINGLE_PROCESS
 SensorHandler sensorHandler  @ "HW_STACK";
+#endif
+
+//Counted by the context switch hook (scmRTOS_extensions.h)
+volatile uint16_t OS::context_switch_count = 0;
+
+//Reports the unused part of the stacks painted by the OS at start
+void ev3::getStackUsage(ev3::StackUsage& usage) {
+    usage.size[0] = COMMAND_STACK_SIZE;
+    usage.size[1] = SENSOR_STACK_SIZE;
+    usage.size[2] = scmRTOS_IDLE_PROCESS_STACK_SIZE;
+    usage.slack[0] = uint16_t(commandHandler.stack_slack());
+#if EV3_SINGLE_PROCESS
+    usage.slack[1] = 0;
+#else
+    usage.slack[1] = uint16_t(sensorHandler.stack_slack());
+#endif
+    usage.slack[2] = uint16_t(OS::IdleProc.stack_slack());
+    usage.contextSwitches = OS::context_switch_count;
+}
 
 //---------------------------------------------------------------------------
 //
@@ -119,23 +156,7 @@ typedef lsm6ds3::Accelerometer<ImuTransport> Accelerometer;
 //      EEPROM data layout
 //
 
-//Each sensor supports a number of modes with different full-range scales
-//Each mode should be calibrated individually and we keep a transformation matrix
-//for each mode
-typedef math::DenseMatrix<int16_t, 4, 3, utils::WordCopy> TranformationMatrix;
-
-template <typename T>
-class EepromData {
-private:
-    TranformationMatrix matrices[sensors::traits::scale_count<T>::value];
-public:
-    static_assert(sizeof(matrices) <= 256, "Cannot use 8-bit index in pointer arithmetic");
-    
-    INLINE int16_t* get(uint8_t scale) {
-        return (int16_t*)((uint8_t*)(matrices[0]) + uint8_t(scale * sizeof(matrices[0])));
-    }
-};
-
+//The device sections are defined in eeprom_layout.h, the host build uses the same layout
 typedef mpl::make_type_list<Gyroscope, Accelerometer>::type devices;
 typedef stm8::Eeprom<EepromData, devices> eeprom_type;
 
@@ -147,19 +168,35 @@ __no_init eeprom_type eeprom;
 //      UART configuration
 //
 
-typedef UartConfig<F_MASTER, 115200> uart_config;
-typedef Uart<Uart1, 32> uart_type;
+//Speeds advertised to the host, the fastest first
+typedef mpl::make_type_list<
+    ev3::Ev3UartConfig<F_MASTER, 460800>,
+    ev3::Ev3UartConfig<F_MASTER, 230400>,
+    ev3::Ev3UartConfig<F_MASTER, 115200>
+>::type uart_speeds;
+//The receive interrupt wakes up the command handler once per host message.
+//The buffer keeps the 32 byte calibration writes (34 bytes with the command and the checksum),
+//it takes 32 bytes more RAM than the buffer of the byte by byte handler.
+//The transmit buffer takes IMU-ALL frame (18 bytes) at once, so the frame buffer is released
+//as soon as the frame is queued. The next frame waits in the frame queue if it does not fit.
+typedef Uart<Uart1, 64, EmptyDiagnostic, 32, ev3::MessageFraming> uart_type;
 
 //---------------------------------------------------------------------------
 //
 //      IMU class that integrates all devices
 //
+//EV3_DECIMATION_FACTOR averages the chip samples into one output sample (see DecimationProvider.h),
+//the chip runs up to the factor times the rate the link carries. The factor 1 sends every sample.
+#ifndef EV3_DECIMATION_FACTOR
+#define EV3_DECIMATION_FACTOR 1
+#endif
 
 #if 1
+typedef sensors::DecimationProvider<EV3_DECIMATION_FACTOR, sensors::ThermalTransformProvider<eeprom_type, eeprom>::Provider> calibrated_provider;
 template <typename Derived>
-struct imu_core_type : ev3::lsm6ds3::ImuCore<ImuTransport, sensors::TransformProvider<eeprom_type, eeprom>::Provider, Derived> {};
+struct imu_core_type : ev3::lsm6ds3::ImuCore<ImuTransport, sensors::BiasTrackingProvider<Gyroscope, calibrated_provider::Provider>::Provider, Derived> {};
 template <typename Derived>
-struct imu_type : ev3::imu::IMU<imu_core_type, ev3::lsm6ds3::Commands, 32, ev3::EepromWriter<TranformationMatrix>, Derived> {};
+struct imu_type : ev3::imu::IMU<imu_core_type, ev3::lsm6ds3::Commands, 32, ev3::EepromWriter<CalibrationRecord>, Derived> {};
 #else
 template <typename Derived>
 struct imu_core_type : ev3::lsm6ds3::ImuCore<ImuTransport, sensors::SimpleProvider, Derived> {};
@@ -173,7 +210,7 @@ struct imu_type : ev3::imu::IMU<imu_core_type, ev3::lsm6ds3::Commands, 32, ev3::
 //      EV3 UART sensor that provides data to EV3 host
 //
 
-typedef ev3::Ev3UartSensor<97, uart_type, uart_config, imu_type> sensor_type;
+typedef ev3::Ev3UartSensor<97, uart_type, uart_speeds, imu_type> sensor_type;
 sensor_type sensor;
 
 //Configure HSE as the clock source
@@ -197,6 +234,9 @@ int main()
     Spi::init();
     Spi::enable();
 
+    //The pipeline profiler is enabled by PROFILER_ENABLED=1
+    PROFILE_INIT();
+
     // Start System Timer
     // TODO: Set lowest priority for system timer ISR
     TIM4()->PSCR = timer4cfg::prescaler;
@@ -230,6 +270,7 @@ bool initClock() {
 
 namespace OS {
 
+//The single process build runs the sensor events from the protocol handler
 template<> void CommandHandler::exec()
 {
     for(;;) {
@@ -237,12 +278,14 @@ template<> void CommandHandler::exec()
     }
 }
 
+#if !EV3_SINGLE_PROCESS
 template<> void SensorHandler::exec()
 {
     for(;;) {
         sensor.processIMU();
     }
 }
+#endif
 } // namespace OS
 
 INTERRUPT_HANDLER(GYRO_DataReady_ISR, ITC_IRQ_PORTD)
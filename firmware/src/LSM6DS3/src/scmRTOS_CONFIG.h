@@ -56,8 +56,19 @@ typedef uint_fast32_t tick_count_t;
 //
 //    Specify scmRTOS Process Count. Must be less then 31
 //
+//    EV3_SINGLE_PROCESS=1 selects the single event loop process that handles
+//    both the sensor events and the EV3 protocol (see ev3::Ev3UartSensor),
+//    otherwise the command handler and the sensor handler are separate processes.
 //
+#ifndef EV3_SINGLE_PROCESS
+#define EV3_SINGLE_PROCESS                  0
+#endif
+
+#if EV3_SINGLE_PROCESS
+#define  scmRTOS_PROCESS_COUNT              1
+#else
 #define  scmRTOS_PROCESS_COUNT              2
+#endif
 
 //------------------------------------------------------------------------------
 //
@@ -161,8 +172,9 @@ typedef uint_fast32_t tick_count_t;
 //    The macro enables/disables user defined hook called from system
 //    Context Switch Hook function.
 //
+//    The hook counts the context switches for the diagnostic mode (see ev3::StackUsage).
 //
-#define  scmRTOS_CONTEXT_SWITCH_USER_HOOK_ENABLE  0
+#define  scmRTOS_CONTEXT_SWITCH_USER_HOOK_ENABLE  1
 
 //-----------------------------------------------------------------------------
 //
@@ -171,12 +183,10 @@ typedef uint_fast32_t tick_count_t;
 //    The macro enables debug mode which allows debug functionality
 //    such as finding process's stack slack and some other.
 //
+//    The release build keeps it to fill the stacks with the pattern at start,
+//    the diagnostic mode reports the stack slack (see ev3::StackUsage).
 //
-#ifdef NDEBUG
-#define scmRTOS_DEBUG_ENABLE  0
-#else
 #define scmRTOS_DEBUG_ENABLE  1
-#endif
 
 #endif // scmRTOS_CONFIG_H
 //-----------------------------------------------------------------------------
@@ -69,6 +69,16 @@ namespace lsm9ds0 {
         static uint8_t getEepromInfo(uint8_t command) {
             return getInfo<0x50>(command);
         }
+
+        static bool isConfigCommand(uint8_t command) {
+            return false;
+        }
+
+        //Packs the device kind and the setting value into device config info byte
+        //See command_info.h file for detals
+        static uint8_t getConfigInfo(uint8_t command) {
+            return 0;
+        }
     };
 }
 }
@@ -6,6 +6,7 @@
 #include <sensors/lsm9ds0/Gyroscope.h>
 #include <sensors/lsm9ds0/Magnetometer.h>
 #include <ev3/command_info.h>
+#include <ev3/diagnostics.h>
 
 namespace ev3 {
 namespace lsm9ds0 {
@@ -19,6 +20,7 @@ namespace lsm9ds0 {
             StateAccelerometer,
             StateGyroscope,
             StateMagnetometer,
+            StateDiagnostic,
         };
 
 		typedef sensors::lsm9ds0::Accelerometer<AccelTransport> Accelerometer;
@@ -28,7 +30,7 @@ namespace lsm9ds0 {
 		typedef Gyroscope gyro_type;
 		typedef Magnetometer magnetometer_type;
 
-        static const uint8_t MODE_COUNT = 4;
+        static const uint8_t MODE_COUNT = 5;
 
         static const uint8_t ACCEL_SAMPLES = 3;
         static const uint8_t GYRO_SAMPLES = 3;
@@ -39,6 +41,7 @@ namespace lsm9ds0 {
         static const uint8_t ACCEL_SAMPLE_SIZE = ACCEL_SAMPLES * sizeof(uint16_t);
         static const uint8_t GYRO_SAMPLE_SIZE = GYRO_SAMPLES * sizeof(uint16_t);
         static const uint8_t MAGNETOMETER_SAMPLE_SIZE = MAGNETOMETER_SAMPLES * sizeof(uint16_t);
+        static const uint8_t DIAGNOSTIC_SAMPLE_SIZE = sizeof(ev3::Diagnostics);
 
         static const uint8_t GYRO_SAMPLE_OFFSET = ACCEL_SAMPLE_SIZE;
         static const uint8_t MAGNETOMETER_SAMPLE_OFFSET = ACCEL_SAMPLE_SIZE + GYRO_SAMPLE_SIZE;
@@ -48,7 +51,9 @@ namespace lsm9ds0 {
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'L', 'L'>::type,      FULL_SAMPLES,         ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'A', 'C', 'C'>::type,      ACCEL_SAMPLES,        ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
             ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'R', 'A', 'T', 'E'>::type, GYRO_SAMPLES,         ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
-            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'M', 'A', 'G'>::type,      MAGNETOMETER_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'M', 'A', 'G'>::type,      MAGNETOMETER_SAMPLES, ev3::Int16, 5, 0, true, SHRT_MIN, SHRT_MAX>,
+            //Hidden mode, the host selects it by the index
+            ev3::SensorMode<mpl::vector_c<char, 'I', 'M', 'U', '-', 'D', 'I', 'A', 'G'>::type,      ev3::Diagnostics::COUNT, ev3::Int16, 5, 0, false, SHRT_MIN, SHRT_MAX>
         >::type mode_list;
 
         //Data sample size
@@ -72,7 +77,7 @@ namespace lsm9ds0 {
 
         template <uint8_t offset, uint8_t size>
         void sendSample(uint8_t mode) {
-            sender()->sendData<offset, size>(mode);
+            sender()->template sendData<offset, size>(mode);
         }
 
         //Convert sensor mode to the state
@@ -86,22 +91,32 @@ namespace lsm9ds0 {
         }
 
         INLINE void readAccelSample(uint8_t mode) {
-            accel.readSample(buffer(), ACCEL_SAMPLE_SIZE);
-            sendSample<0, ACCEL_SAMPLE_SIZE>(mode);
+            if (accel.readSample(buffer(), ACCEL_SAMPLE_SIZE))
+                sendSample<0, ACCEL_SAMPLE_SIZE>(mode);
         }
 
         INLINE void readGyroSample(uint8_t mode) {
             //The gyro sample uses the same place in the buffer is all modes to avoid
             //data placement conflicts during switching from gyro to accel+gyro mode
-            gyro.readSample(buffer() + GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE);
-            sendSample<GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE>(mode);
+            if (gyro.readSample(buffer() + GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE))
+                sendSample<GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE>(mode);
         }
 
         INLINE void readMagnetometerSample(uint8_t mode) {
             //The gyro sample uses the same place in the buffer is all modes to avoid
             //data placement conflicts during switching from gyro to accel+gyro mode
-            magnetometer.readSample(buffer() + MAGNETOMETER_SAMPLE_OFFSET, MAGNETOMETER_SAMPLE_SIZE);
-            sendSample<MAGNETOMETER_SAMPLE_OFFSET, MAGNETOMETER_SAMPLE_SIZE>(mode);
+            if (magnetometer.readSample(buffer() + MAGNETOMETER_SAMPLE_OFFSET, MAGNETOMETER_SAMPLE_SIZE))
+                sendSample<MAGNETOMETER_SAMPLE_OFFSET, MAGNETOMETER_SAMPLE_SIZE>(mode);
+        }
+
+        //Sends the pipeline counters or the profiler record selected by the host
+        void readDiagnosticSample(uint8_t mode) {
+            //Reading the sample releases the data ready line
+            uint8_t sample[GYRO_SAMPLE_SIZE];
+            gyro.readSample(sample, sizeof(sample));
+
+            sender()->readDiagnostics(buffer(), GyroTransport::getErrors());
+            sendSample<0, DIAGNOSTIC_SAMPLE_SIZE>(mode);
         }
 
     public:
@@ -155,7 +170,17 @@ namespace lsm9ds0 {
                     accel.init(Accelerometer::SCALE_2G, Accelerometer::ODR_100, Accelerometer::InterruptDisabled, Accelerometer::BW_50);
                     magnetometer.init(Magnetometer::SCALE_2GS, Magnetometer::ODR_100, Magnetometer::InterruptEnabled);
                     break;
+
+                case StateDiagnostic:
+                    //The gyro data ready interrupt sends the counters at the lowest rate
+                    gyro.init(Gyroscope::SCALE_245DPS, Gyroscope::ODR_95_BW_125, Gyroscope::InterruptEnabled, Gyroscope::NoSync);
+                    accel.reset();
+                    magnetometer.reset();
+                    break;
                 }
+                accel.resetDecimation();
+                gyro.resetDecimation();
+                magnetometer.resetDecimation();
             }
         }
 
@@ -164,17 +189,17 @@ namespace lsm9ds0 {
             switch (scaleInfo & ScaleInfoMask::Device) {
             case ImuGyroscope:
                 if (currentState == StateAll || currentState == StateGyroscope)
-                    gyro.setScale(Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
+                    gyro.setScale(typename Gyroscope::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
 
             case ImuAccelerometer:
                 if (currentState == StateAll || currentState == StateAccelerometer)
-                    accel.setScale(Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
+                    accel.setScale(typename Accelerometer::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
 
             case ImuMagnetometer:
                 if (currentState == StateAll || currentState == StateMagnetometer)
-                    magnetometer.setScale(Magnetometer::Scale(scaleInfo & ScaleInfoMask::Scale));
+                    magnetometer.setScale(typename Magnetometer::Scale(scaleInfo & ScaleInfoMask::Scale));
                 break;
             }
         }
@@ -184,19 +209,23 @@ namespace lsm9ds0 {
             setMode(0);
         }
 
+        //Changes the device settings. The device has no configurable settings.
+        void configure(uint8_t configInfo) {
+        }
+
         //Updates EEPROM data for the device and scale specified by eepromInfo
         void updateEeprom(uint8_t eepromInfo, const uint8_t* data, uint8_t size) {
             switch (eepromInfo & ScaleInfoMask::Device) {
             case ImuGyroscope:
-                gyro.updateEeprom(Gyroscope::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
+                gyro.updateEeprom(typename Gyroscope::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
                 break;
 
             case ImuAccelerometer:
-                accel.updateEeprom(Accelerometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
+                accel.updateEeprom(typename Accelerometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
                 break;
 
             case ImuMagnetometer:
-                magnetometer.updateEeprom(Magnetometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
+                magnetometer.updateEeprom(typename Magnetometer::Scale(eepromInfo & ScaleInfoMask::Scale), data, size);
                 break;
             }
         }
@@ -245,10 +274,11 @@ namespace lsm9ds0 {
                     accel.readSample(buffer(), ACCEL_SAMPLE_SIZE);
                     break;
                 case GyroscopeAvailable:
-                    //Gyroscope event follows the accelerometer event
-                    gyro.readSample(buffer() + GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE);
+                    //Gyroscope event follows the accelerometer event.
+                    //The other samples keep the last output of their providers.
                     magnetometer.readSample(buffer() + MAGNETOMETER_SAMPLE_OFFSET, MAGNETOMETER_SAMPLE_SIZE);
-                    sendSample<0, FULL_SAMPLE_SIZE>(mode);
+                    if (gyro.readSample(buffer() + GYRO_SAMPLE_OFFSET, GYRO_SAMPLE_SIZE))
+                        sendSample<0, FULL_SAMPLE_SIZE>(mode);
                     break;
                 }
                 break;
@@ -271,6 +301,12 @@ namespace lsm9ds0 {
                     readMagnetometerSample(mode);
                 }
                 break;
+
+            case StateDiagnostic:
+                if (event == GyroscopeAvailable) {
+                    readDiagnosticSample(mode);
+                }
+                break;
             }
         }
     };
@@ -32,18 +32,51 @@ using namespace sensors;
 //
 //      Process types
 //
-typedef OS::process<OS::pr0, 150> CommandHandler;
-typedef OS::process<OS::pr1, 150> SensorHandler;
+//Stack sizes in bytes, the diagnostic mode reports the stack usage.
+//The single event loop (EV3_SINGLE_PROCESS) processes the sensor events on top
+//of the protocol handler calls, so it needs more stack than each of the separate processes.
+#if EV3_SINGLE_PROCESS
+static const size_t COMMAND_STACK_SIZE = 200;
+static const size_t SENSOR_STACK_SIZE = 0;
+#else
+static const size_t COMMAND_STACK_SIZE = 150;
+static const size_t SENSOR_STACK_SIZE = 150;
+#endif
 
+typedef OS::process<OS::pr0, COMMAND_STACK_SIZE> CommandHandler;
 template<> void CommandHandler::exec();
+
+#if !EV3_SINGLE_PROCESS
+typedef OS::process<OS::pr1, SENSOR_STACK_SIZE> SensorHandler;
 template<> void SensorHandler::exec();
+#endif
 
 //---------------------------------------------------------------------------
 //
 //      Process objects
 //
 CommandHandler commandHandler @ "HW_STACK";
+#if !EV3_SINGLE_PROCESS
 SensorHandler sensorHandler  @ "HW_STACK";
+#endif
+
+//Counted by the context switch hook (scmRTOS_extensions.h)
+volatile uint16_t OS::context_switch_count = 0;
+
+//Reports the unused part of the stacks painted by the OS at start
+void ev3::getStackUsage(ev3::StackUsage& usage) {
+    usage.size[0] = COMMAND_STACK_SIZE;
+    usage.size[1] = SENSOR_STACK_SIZE;
+    usage.size[2] = scmRTOS_IDLE_PROCESS_STACK_SIZE;
+    usage.slack[0] = uint16_t(commandHandler.stack_slack());
+#if EV3_SINGLE_PROCESS
+    usage.slack[1] = 0;
+#else
+    usage.slack[1] = uint16_t(sensorHandler.stack_slack());
+#endif
+    usage.slack[2] = uint16_t(OS::IdleProc.stack_slack());
+    usage.contextSwitches = OS::context_switch_count;
+}
 
 
 //---------------------------------------------------------------------------
@@ -150,8 +183,16 @@ __no_init eeprom_type eeprom;
 //      UART configuration
 //
 
-typedef UartConfig<F_MASTER, 115200> uart_config;
-typedef Uart<Uart1, 32> uart_type;
+//Speeds advertised to the host, the fastest first
+typedef mpl::make_type_list<
+    ev3::Ev3UartConfig<F_MASTER, 460800>,
+    ev3::Ev3UartConfig<F_MASTER, 230400>,
+    ev3::Ev3UartConfig<F_MASTER, 115200>
+>::type uart_speeds;
+//The receive interrupt wakes up the command handler once per host message.
+//The buffer keeps the 32 byte calibration writes (34 bytes with the command and the checksum),
+//it takes 32 bytes more RAM than the buffer of the byte by byte handler.
+typedef Uart<Uart1, 64, EmptyDiagnostic, 0, ev3::MessageFraming> uart_type;
 
 //---------------------------------------------------------------------------
 //
@@ -175,7 +216,7 @@ struct imu_type : ev3::imu::IMU<imu_core_type,  ev3::lsm9ds0::Commands, 32, ev3:
 //      EV3 UART sensor that provides data to EV3 host
 //
 
-typedef ev3::Ev3UartSensor<96, uart_type, uart_config, imu_type> sensor_type;
+typedef ev3::Ev3UartSensor<96, uart_type, uart_speeds, imu_type> sensor_type;
 sensor_type sensor;
 
 //Configure HSE as the clock source
@@ -199,6 +240,9 @@ int main()
     Spi::init();
     Spi::enable();
 
+    //The pipeline profiler is enabled by PROFILER_ENABLED=1
+    PROFILE_INIT();
+
     // Start System Timer
     // TODO: Set lowest priority for system timer ISR
     TIM4()->PSCR = timer4cfg::prescaler;
@@ -232,6 +276,7 @@ bool initClock() {
 
 namespace OS {
 
+//The single process build runs the sensor events from the protocol handler
 template<> void CommandHandler::exec()
 {
     for(;;) {
@@ -239,12 +284,14 @@ template<> void CommandHandler::exec()
     }
 }
 
+#if !EV3_SINGLE_PROCESS
 template<> void SensorHandler::exec()
 {
     for(;;) {
         sensor.processIMU();
     }
 }
+#endif
 } // namespace OS
 
 INTERRUPT_HANDLER(GYRO_DataReady_ISR, ITC_IRQ_PORTD)
@@ -50,6 +50,13 @@ namespace OS {
 	    __wait_for_interrupt();
 	}
 
+	//Number of the context switches since power on, it wraps around
+	extern volatile uint16_t context_switch_count;
+
+	INLINE void context_switch_user_hook() {
+	    ++context_switch_count;
+	}
+
 }
 
 #endif // scmRTOS_EXTENSIONS_H
@@ -16,6 +16,16 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
     //Return device to the state right after power on
     public static final byte DEVICE_RESET  = 0x11;
 
+    //Data acquisition method in combined mode
+    public static final byte FIFO_DISABLE  = 0x12;
+    public static final byte FIFO_ENABLE   = 0x13;
+
+    //Sets the angles accumulated in the angle mode to zero
+    public static final byte ANGLE_RESET   = 0x14;
+
+    //Writes the gyroscope bias tracked during stillness into the calibration matrix
+    public static final byte BIAS_SAVE     = 0x15;
+
     //Accelerometer sensitivity
     public static final byte ACC_SCALE_2G  = 0x20;
     public static final byte ACC_SCALE_4G  = 0x21;
@@ -41,11 +51,65 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
     public static final byte CALIBRATE_GYRO_2000DPS = 0x53;
     public static final byte CALIBRATE_GYRO_125DPS  = 0x54;
 
+    //Output data rate: 13 Hz * 2^N, N = 0..9 (13 Hz .. 6660 Hz) for the accelerometer
+    //and N = 0..7 (13 Hz .. 1660 Hz) for the gyroscope.
+    //The device limits the rate to the number of frames the UART link can carry.
+    public static final byte ACC_ODR_13HZ  = 0x60;
+    public static final byte GYRO_ODR_13HZ = 0x70;
+    public static final int ACC_ODR_COUNT = 10;
+    public static final int GYRO_ODR_COUNT = 8;
+
+    //Timestamp counter resolution in the timestamped mode, in seconds.
+    //The 24-bit counter wraps around in about 419 seconds.
+    public static final float TIMESTAMP_TICK = 25e-6f;
+    public static final int TIMESTAMP_RANGE = 1 << 24;
+
+    //The orientation mode sends the quaternion components in Q14 format
+    private static final float QUATERNION_SCALE = 1f / (1 << 14);
+
+    //The angle mode unit is 125 dps gyro digit integrated over one 1664 Hz sample period
+    private static final double ANGLE_UNIT = 4.375e-3 / 1664; //in degrees
+
     private static final int ACCEL_SCALE = Short.MAX_VALUE + 1;
 
+    //Die temperature sensitivity in digits per degree, the zero value is 25 degrees
+    private static final float TEMPERATURE_SCALE = 16;
+    private static final float TEMPERATURE_ZERO = 25;
+    //Selection of the diagnostic mode block
+    public static final byte DIAGNOSTIC_COUNTERS = 0x18;
+    public static final byte DIAGNOSTIC_PROFILE  = 0x19;
+    public static final byte DIAGNOSTIC_STACKS   = 0x1E;
+    //Pipeline stages of the profiler records
+    public static final int PROFILE_QUEUE_POP = 0;
+    public static final int PROFILE_SPI_READ = 1;
+    public static final int PROFILE_TRANSFORM = 2;
+    public static final int PROFILE_FRAME_QUEUED = 3;
+    public static final int PROFILE_TX_DONE = 4;
+
+    //Number of the die temperatures the device keeps the calibration matrices for
+    public static final int TEMPERATURE_POINTS = 2;
+
+    //Flags of the status mode: the calibration data of the device is valid.
+    //The device with the missing or damaged calibration sends uncorrected samples.
+    public static final int EEPROM_ACCEL_VALID = 0x01;
+    public static final int EEPROM_GYRO_VALID  = 0x02;
+
+    private static final int STATUS_MODE = 6;
+    //The status mode sample: EEPROM flags, die temperature, number of the processed EEPROM writes,
+    //number of the lost data samples and the maximum data processing latency in ms
+    private static final int STATUS_SIZE = 5;
+    //The device reports the status at 104 Hz
+    private static final long EEPROM_POLL_PERIOD = 10;
+    private static final long EEPROM_WRITE_TIMEOUT = 1000;
+
+    private static final int DIAGNOSTIC_MODE = 7;
+    //The diagnostic mode sample: the pipeline counters (firmware ev3/diagnostics.h)
+    private static final int DIAGNOSTIC_SIZE = 8;
+
     private static final float[] gyroScale = {8.75e-3f, 17.5e-3f, 35e-3f, 70e-3f, 4.375e-3f};//in degree per second / digit
     private static final float[] accelScale = {2f / ACCEL_SCALE, 4f / ACCEL_SCALE, 8f / ACCEL_SCALE , 16f / ACCEL_SCALE}; //in g / digit
     private boolean rawMode;
+    private final short[] status = new short[STATUS_SIZE];
 
     public ImuLsm6ds3(Port port) {
         this(port, false);
@@ -54,7 +118,7 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
     public ImuLsm6ds3(Port port, boolean rawMode) {
         super(port);
         this.rawMode = rawMode;
-        setModes(new SensorMode[]{new CombinedMode(), new AccelerationMode(), new GyroMode()});
+        setModes(new SensorMode[]{new CombinedMode(), new AccelerationMode(), new GyroMode(), new TimestampedMode(), new OrientationMode(), new AngleMode(), new StatusMode(), new DiagnosticMode()});
     }
 
     public void reset() {
@@ -62,6 +126,51 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
         port.write(buffer, 0, buffer.length);
     }
 
+    /**
+     * Selects the data acquisition method in the combined mode.
+     * In the batching mode the sensor samples the data at 1660 Hz and
+     * the device sends the average of 4 samples.
+     *
+     * @param enabled true to use the sensor's FIFO, false to read each sample separately
+     * @return true if the command has been sent successfully
+     */
+    public boolean setFifoBatching(boolean enabled) {
+        byte[] buffer = new byte[] {enabled ? FIFO_ENABLE : FIFO_DISABLE};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
+    /**
+     * Selects the accelerometer output data rate.
+     * The rate is used when the accelerometer sends the data by itself or in the combined mode without FIFO.
+     * The combined modes send a frame per gyroscope sample, so there the accelerometer rate
+     * is limited by the gyroscope rate. A lower accelerometer rate repeats the accelerometer sample in the frames.
+     *
+     * @param rateNo rate index, the rate is 13 Hz * 2^rateNo
+     * @return true if the command has been sent successfully
+     */
+    public boolean setAccelerometerRate(int rateNo) {
+        return setRate(ACC_ODR_13HZ, rateNo, ACC_ODR_COUNT);
+    }
+
+    /**
+     * Selects the gyroscope output data rate.
+     * The rate is used when the gyroscope sends the data by itself or in the combined mode without FIFO.
+     *
+     * @param rateNo rate index, the rate is 13 Hz * 2^rateNo
+     * @return true if the command has been sent successfully
+     */
+    public boolean setGyroscopeRate(int rateNo) {
+        return setRate(GYRO_ODR_13HZ, rateNo, GYRO_ODR_COUNT);
+    }
+
+    private boolean setRate(int rateCommand, int rateNo, int rateCount) {
+        if (rateNo >= 0 && rateNo < rateCount) {
+            byte[] buffer = new byte[] {(byte)(rateCommand + rateNo)};
+            return port.write(buffer, 0, buffer.length) == buffer.length;
+        }
+        return false;
+    }
+
     @Override
     public boolean setGyroscopeScale(int scaleNo) {
         if (scaleNo >= 0 && scaleNo < 5) {
@@ -97,6 +206,45 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
         return writeEeprom(CALIBRATE_GYRO_245DPS + scaleNo, data);
     }
 
+    /**
+     * Updates the accelerometer matrix calibrated at the specified die temperature.
+     * The device interpolates the matrices by the die temperature. The points should be written
+     * in the ascending temperature order starting from the point 0, writing the point discards the points above it.
+     * The matrix written by writeAccelerometerEeprom is the single point 0.
+     *
+     * @param scaleNo     scale index
+     * @param point       calibration point index, 0..TEMPERATURE_POINTS-1
+     * @param temperature die temperature of the calibration, in degrees
+     * @param data        EEPROM data (4x3 matrix of 16-bit integers)
+     * @return true if the EEPROM data has been successfully written
+     */
+    public boolean writeAccelerometerEeprom(int scaleNo, int point, float temperature, short[] data) {
+        return writeEeprom(CALIBRATE_ACC_2G + scaleNo, getCalibrationRecord(point, temperature, data));
+    }
+
+    /**
+     * Updates the gyroscope matrix calibrated at the specified die temperature.
+     * See writeAccelerometerEeprom(int, int, float, short[]) for the point order.
+     *
+     * @param scaleNo     scale index
+     * @param point       calibration point index, 0..TEMPERATURE_POINTS-1
+     * @param temperature die temperature of the calibration, in degrees
+     * @param data        EEPROM data (4x3 matrix of 16-bit integers)
+     * @return true if the EEPROM data has been successfully written
+     */
+    public boolean writeGyroscopeEeprom(int scaleNo, int point, float temperature, short[] data) {
+        return writeEeprom(CALIBRATE_GYRO_245DPS + scaleNo, getCalibrationRecord(point, temperature, data));
+    }
+
+    //The record is the matrix followed by the die temperature in the sensor's digits and the point index
+    private static short[] getCalibrationRecord(int point, float temperature, short[] data) {
+        short[] record = new short[data.length + 2];
+        System.arraycopy(data, 0, record, 0, data.length);
+        record[data.length] = (short) Math.round((temperature - TEMPERATURE_ZERO) * TEMPERATURE_SCALE);
+        record[data.length + 1] = (short) point;
+        return record;
+    }
+
     /**
      * Update magnetometer EEPROM
      *
@@ -118,14 +266,35 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
             command.putShort(aData);
         }
         byte[] array = command.array();
+
+        //The status mode counts the processed EEPROM writes, so the completion is detected
+        //by the counter change instead of waiting for the worst case write time.
+        //The mode is switched only once for a series of writes.
+        switchMode(STATUS_MODE, SWITCHDELAY);
+        int writes = readEepromWrites();
         boolean success = port.write(array, 0, array.length) == array.length;
         if (success) {
-            //Wait for writing the data to EEPROM
-            Delay.msDelay(array.length * 3);
+            success = waitForEepromWrite(writes);
         }
         return success;
     }
 
+    //Returns the counter of the processed EEPROM writes. The status mode should be selected.
+    private int readEepromWrites() {
+        port.getShorts(status, 0, status.length);
+        return status[2] & 0xFF;
+    }
+
+    private boolean waitForEepromWrite(int writes) {
+        long deadline = System.currentTimeMillis() + EEPROM_WRITE_TIMEOUT;
+        do {
+            Delay.msDelay(EEPROM_POLL_PERIOD);
+            if (readEepromWrites() != writes)
+                return true;
+        } while (System.currentTimeMillis() < deadline);
+        return false;
+    }
+
     private boolean setScale(int scaleCommand) {
         byte[] buffer = new byte[] {(byte)scaleCommand};
         boolean success = port.write(buffer, 0, buffer.length) == buffer.length;
@@ -161,6 +330,121 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
         return getMode(2);
     }
 
+    /**
+     * Returns the combined mode with the sensor-side timestamp.
+     * The sample contains 6 values of the combined mode and the timestamp counter
+     * value taken when the sample is read by the device. The counter counts
+     * in TIMESTAMP_TICK units and wraps around at TIMESTAMP_RANGE, so the time
+     * between the samples is ((t1 - t0 + TIMESTAMP_RANGE) % TIMESTAMP_RANGE) * TIMESTAMP_TICK.
+     * The counter is restarted each time the mode is selected.
+     */
+    public SensorMode getTimestampedMode() {
+        return getMode(3);
+    }
+
+    /**
+     * Returns the orientation mode. The device fuses the gyroscope and accelerometer
+     * samples at the gyroscope rate (104..416 Hz) and sends the quaternion w, x, y, z.
+     * The yaw is not corrected by the accelerometer, so it drifts with the gyroscope offset.
+     * The device restarts the filter each time the mode is selected, the filter aligns
+     * with the gravity in a few seconds.
+     */
+    public SensorMode getOrientationMode() {
+        return getMode(4);
+    }
+
+    /**
+     * Returns the angle mode. The device integrates every calibrated gyroscope sample
+     * at the gyroscope rate and sends the accumulated angles around X, Y and Z axes in degrees.
+     * The accumulators are set to zero when the mode is selected or by resetAngles().
+     * The device accumulators wrap around after about 5600 degrees, so the raw values
+     * should be used to calculate the difference between the distant samples.
+     */
+    public SensorMode getAngleMode() {
+        return getMode(5);
+    }
+
+    /**
+     * Returns the status mode. The sample contains the EEPROM check flags
+     * (EEPROM_ACCEL_VALID, EEPROM_GYRO_VALID), the die temperature in degrees,
+     * the number of the samples lost by the device (it wraps around at 65536)
+     * and the maximum time between the data ready interrupt and the sample processing, in ms.
+     * The counters are cleared by the device reset.
+     * The device checks the calibration data at start and after writing it.
+     * The EEPROM writes select this mode to detect the write completion.
+     */
+    public SensorMode getStatusMode() {
+        return getMode(STATUS_MODE);
+    }
+
+    /**
+     * Returns the hidden diagnostic mode. The sample contains the counters of the device pipeline:
+     * the data ready events received and processed, the coalesced (lost) data events,
+     * the event queue high-water mark, the data frames sent and dropped,
+     * the UART (low byte) and SPI (high byte) error flags and the number of the handshake restarts.
+     * The counters wrap around at 65536. The event counters are cleared by the device reset,
+     * the frame, error and restart counters are kept since power on.
+     */
+    public SensorMode getDiagnosticMode() {
+        return getMode(DIAGNOSTIC_MODE);
+    }
+
+    /**
+     * Selects the block sent by the diagnostic mode: the pipeline counters or the profiler record
+     * of the pipeline stage. The record contains the number of the measurements, the minimum, average
+     * and maximum time since the previous recorded stage in microseconds and the histogram
+     * of the times below 32, 128, 512 and from 512 microseconds.
+     * The first stage is measured from the data ready interrupt.
+     * The firmware built without the profiler always sends the counters.
+     *
+     * @param stage the pipeline stage (PROFILE_QUEUE_POP...PROFILE_TX_DONE) or -1 to select the counters
+     * @return true if the command has been sent successfully
+     */
+    public boolean selectDiagnostics(int stage) {
+        if (stage < -1 || stage > PROFILE_TX_DONE)
+            return false;
+        byte[] buffer = new byte[] {(byte) (DIAGNOSTIC_PROFILE + stage)};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
+    /**
+     * Selects the stack usage block of the diagnostic mode. The block contains the stack sizes
+     * of the command handler, the sensor handler and the idle process, then the number of the bytes
+     * of each stack that have never been used since power on, then the number of the context switches
+     * since power on (it wraps around at 65536, the switch rate is the difference of two readings)
+     * and a reserved value. The firmware built with the single event loop process reports
+     * zero size of the sensor handler.
+     *
+     * @return true if the command has been sent successfully
+     */
+    public boolean selectStackUsage() {
+        byte[] buffer = new byte[] {DIAGNOSTIC_STACKS};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
+    /**
+     * Sets the angles accumulated in the angle mode to zero.
+     *
+     * @return true if the command has been sent successfully
+     */
+    public boolean resetAngles() {
+        byte[] buffer = new byte[] {ANGLE_RESET};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
+    /**
+     * Writes the gyroscope bias tracked by the device into the calibration matrix
+     * of the current gyroscope scale, so the bias is kept after power off.
+     * The device tracks the bias while it is still and subtracts it from the gyroscope samples,
+     * the estimate is discarded when the gyroscope scale is changed.
+     *
+     * @return true if the command has been sent successfully
+     */
+    public boolean saveGyroBias() {
+        byte[] buffer = new byte[] {BIAS_SAVE};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
 
     private class CombinedMode extends BaseSensorMode {
         @Override
@@ -241,6 +525,152 @@ public class ImuLsm6ds3 extends UARTSensor implements ImuEepromWriter, ScaleSele
         }
     }
 
+    private class TimestampedMode extends CombinedMode {
+        //The timestamp is sent as two words: the low word and the high byte
+        private short[] frame = new short[8];
+
+        @Override
+        public int sampleSize() {
+            return 7;
+        }
+
+        @Override
+        public String getName() {
+            return "Timestamped";
+        }
+
+        @Override
+        public int getMode() {
+            return 3;
+        }
+
+        @Override
+        public void setGyroScale(float scale) {
+            for (int i = 3; i < 6; ++i) {
+                this.scale[i] = scale;
+            }
+        }
+
+        @Override
+        public void fetchSample(float[] sample, int offset) {
+            switchMode(getMode(), SWITCHDELAY);
+            port.getShorts(frame, 0, frame.length);
+            for(int i=0;i<6;++i) {
+                sample[offset + i] = frame[i] * scale[i];
+            }
+            //The counter value fits float mantissa exactly
+            sample[offset + 6] = ((frame[7] & 0xFF) << 16) | (frame[6] & 0xFFFF);
+        }
+    }
+
+    private class OrientationMode extends BaseSensorMode {
+        public OrientationMode() {
+            for (int i = 0; i < sampleSize(); ++i) {
+                this.scale[i] = rawMode ? 1 : QUATERNION_SCALE;
+            }
+        }
+
+        @Override
+        public int sampleSize() {
+            return 4;
+        }
+
+        @Override
+        public String getName() {
+            return "Orientation";
+        }
+
+        @Override
+        public int getMode() {
+            return 4;
+        }
+    }
+
+    private class AngleMode extends BaseSensorMode {
+        private byte[] frame = new byte[3 * 4];
+
+        @Override
+        public int sampleSize() {
+            return 3;
+        }
+
+        @Override
+        public String getName() {
+            return "Angle";
+        }
+
+        @Override
+        public int getMode() {
+            return 5;
+        }
+
+        @Override
+        public void fetchSample(float[] sample, int offset) {
+            switchMode(getMode(), SWITCHDELAY);
+            port.getBytes(frame, 0, frame.length);
+            ByteBuffer data = ByteBuffer.wrap(frame).order(ByteOrder.LITTLE_ENDIAN);
+            for (int i = 0; i < sampleSize(); ++i) {
+                int value = data.getInt();
+                sample[offset + i] = rawMode ? value : (float) (value * ANGLE_UNIT);
+            }
+        }
+    }
+
+    private class StatusMode extends BaseSensorMode {
+        @Override
+        public int sampleSize() {
+            return 4;
+        }
+
+        @Override
+        public String getName() {
+            return "Status";
+        }
+
+        @Override
+        public int getMode() {
+            return STATUS_MODE;
+        }
+
+        @Override
+        public void fetchSample(float[] sample, int offset) {
+            switchMode(getMode(), SWITCHDELAY);
+            port.getShorts(status, 0, status.length);
+            sample[offset] = status[0];
+            sample[offset + 1] = rawMode ? status[1] : TEMPERATURE_ZERO + status[1] / TEMPERATURE_SCALE;
+            sample[offset + 2] = status[3] & 0xFFFF;
+            sample[offset + 3] = status[4] & 0xFFFF;
+        }
+    }
+
+    private class DiagnosticMode extends BaseSensorMode {
+        private short[] counters = new short[DIAGNOSTIC_SIZE];
+
+        @Override
+        public int sampleSize() {
+            return DIAGNOSTIC_SIZE;
+        }
+
+        @Override
+        public String getName() {
+            return "Diagnostic";
+        }
+
+        @Override
+        public int getMode() {
+            return DIAGNOSTIC_MODE;
+        }
+
+        @Override
+        public void fetchSample(float[] sample, int offset) {
+            switchMode(getMode(), SWITCHDELAY);
+            port.getShorts(counters, 0, counters.length);
+            for (int i = 0; i < counters.length; ++i) {
+                sample[offset + i] = counters[i] & 0xFFFF;
+            }
+        }
+    }
+
     abstract class BaseSensorMode implements ImuSensorMode {
         protected float[] scale;
         private short[] buffer;
@@ -50,8 +50,22 @@ public class ImuLsm9ds0 extends UARTSensor implements ScaleSelector, ImuEepromWr
     public static final byte CALIBRATE_MAG_5GS = 0x72;
     public static final byte CALIBRATE_MAG_12GS = 0x73;
 
+    //Selection of the diagnostic mode block
+    public static final byte DIAGNOSTIC_COUNTERS = 0x18;
+    public static final byte DIAGNOSTIC_PROFILE  = 0x19;
+    public static final byte DIAGNOSTIC_STACKS   = 0x1E;
+    //Pipeline stages of the profiler records
+    public static final int PROFILE_QUEUE_POP = 0;
+    public static final int PROFILE_SPI_READ = 1;
+    public static final int PROFILE_TRANSFORM = 2;
+    public static final int PROFILE_FRAME_QUEUED = 3;
+    public static final int PROFILE_TX_DONE = 4;
+
     private static final int ACCEL_SCALE = Short.MAX_VALUE + 1;
 
+    //The diagnostic mode sample: the pipeline counters (firmware ev3/diagnostics.h)
+    private static final int DIAGNOSTIC_SIZE = 8;
+
     private static final float[] gyroScale = {8.75e-3f, 17.5e-3f, 70e-3f};//in degree per second / digit
     private static final float[] accelScale = {2f / ACCEL_SCALE, 4f / ACCEL_SCALE, 6f / ACCEL_SCALE, 8f / ACCEL_SCALE , 24f / ACCEL_SCALE}; //in g / digit
     private static final float[] magScale = {0.08f, 0.16f, 0.32f, 0.48f}; //in mgauss / digit
@@ -64,7 +78,7 @@ public class ImuLsm9ds0 extends UARTSensor implements ScaleSelector, ImuEepromWr
     public ImuLsm9ds0(Port port, boolean rawMode) {
         super(port);
         this.rawMode = rawMode;
-        setModes(new SensorMode[]{new CombinedMode(), new AccelerationMode(), new GyroMode(), new MagnetometerMode()});
+        setModes(new SensorMode[]{new CombinedMode(), new AccelerationMode(), new GyroMode(), new MagnetometerMode(), new DiagnosticMode()});
     }
 
     public void reset() {
@@ -201,6 +215,51 @@ public class ImuLsm9ds0 extends UARTSensor implements ScaleSelector, ImuEepromWr
         return getMode(3);
     }
 
+    /**
+     * Returns the hidden diagnostic mode. The sample contains the counters of the device pipeline:
+     * the data ready events received and processed, the coalesced (lost) data events,
+     * the event queue high-water mark, the data frames sent and dropped,
+     * the UART (low byte) and SPI (high byte) error flags and the number of the handshake restarts.
+     * The counters wrap around at 65536. The event counters are cleared by the device reset,
+     * the frame, error and restart counters are kept since power on.
+     */
+    public SensorMode getDiagnosticMode() {
+        return getMode(4);
+    }
+
+    /**
+     * Selects the block sent by the diagnostic mode: the pipeline counters or the profiler record
+     * of the pipeline stage. The record contains the number of the measurements, the minimum, average
+     * and maximum time since the previous recorded stage in microseconds and the histogram
+     * of the times below 32, 128, 512 and from 512 microseconds.
+     * The first stage is measured from the data ready interrupt.
+     * The firmware built without the profiler always sends the counters.
+     *
+     * @param stage the pipeline stage (PROFILE_QUEUE_POP...PROFILE_TX_DONE) or -1 to select the counters
+     * @return true if the command has been sent successfully
+     */
+    public boolean selectDiagnostics(int stage) {
+        if (stage < -1 || stage > PROFILE_TX_DONE)
+            return false;
+        byte[] buffer = new byte[] {(byte) (DIAGNOSTIC_PROFILE + stage)};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
+    /**
+     * Selects the stack usage block of the diagnostic mode. The block contains the stack sizes
+     * of the command handler, the sensor handler and the idle process, then the number of the bytes
+     * of each stack that have never been used since power on, then the number of the context switches
+     * since power on (it wraps around at 65536, the switch rate is the difference of two readings)
+     * and a reserved value. The firmware built with the single event loop process reports
+     * zero size of the sensor handler.
+     *
+     * @return true if the command has been sent successfully
+     */
+    public boolean selectStackUsage() {
+        byte[] buffer = new byte[] {DIAGNOSTIC_STACKS};
+        return port.write(buffer, 0, buffer.length) == buffer.length;
+    }
+
     private class CombinedMode extends BaseSensorMode {
         @Override
         public int sampleSize() {
@@ -311,6 +370,34 @@ public class ImuLsm9ds0 extends UARTSensor implements ScaleSelector, ImuEepromWr
         }
     }
 
+    private class DiagnosticMode extends BaseSensorMode {
+        private short[] counters = new short[DIAGNOSTIC_SIZE];
+
+        @Override
+        public int sampleSize() {
+            return DIAGNOSTIC_SIZE;
+        }
+
+        @Override
+        public String getName() {
+            return "Diagnostic";
+        }
+
+        @Override
+        public int getMode() {
+            return 4;
+        }
+
+        @Override
+        public void fetchSample(float[] sample, int offset) {
+            switchMode(getMode(), SWITCHDELAY);
+            port.getShorts(counters, 0, counters.length);
+            for (int i = 0; i < counters.length; ++i) {
+                sample[offset + i] = counters[i] & 0xFFFF;
+            }
+        }
+    }
+
     abstract class BaseSensorMode implements ImuSensorMode {
         protected float[] scale;
         private short[] buffer;
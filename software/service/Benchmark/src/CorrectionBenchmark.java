@@ -0,0 +1,165 @@
+import java.util.Random;
+
+/**
+ * Compares the per-sample cost of the firmware correction kernels (math/correction.h)
+ * for each matrix kind: full, diagonal, offset-only and identity.
+ *
+ * The STM8 cost is estimated from the kernel calls and the instruction timings
+ * of the assembler kernels, including the call and the argument loading.
+ * The host cost is measured on the Java ports of the kernels. The benchmark also
+ * checks that the specialized kernels give the same results as the full one.
+ *
+ * Usage: CorrectionBenchmark
+ */
+public class CorrectionBenchmark {
+    //Estimated STM8 cycles per operation
+    private static final int MULDIV_CYCLES = 60;   //muldivs16x16_16x call
+    private static final int SCALE2LE_CYCLES = 20; //scale2le call
+    private static final int ADD_CYCLES = 4;       //loading the matrix element and 16-bit addition
+    private static final int HALF_CYCLES = 4;      //signed division by 2
+
+    private static final int UNIT = 0x4000;
+
+    private static final String[] KINDS = {"full", "diagonal", "offset", "identity"};
+
+    public static void main(String[] args) {
+        short[][] matrices = {
+                {0x3ff0, 0x0010, -0x0020, 0x0008, 0x4010, 0x0004, -0x0012, 0x0002, 0x3fe0, 12, -7, 3},
+                {0x3ff0, 0, 0, 0, 0x4010, 0, 0, 0, 0x3fe0, 12, -7, 3},
+                {UNIT, 0, 0, 0, UNIT, 0, 0, 0, UNIT, 12, -7, 3},
+                {UNIT, 0, 0, 0, UNIT, 0, 0, 0, UNIT, 0, 0, 0}
+        };
+
+        Random random = new Random(1);
+        short[][] samples = new short[4096][3];
+        for (short[] sample : samples) {
+            for (int i = 0; i < 3; ++i) {
+                sample[i] = (short) random.nextInt(1 << 16);
+            }
+        }
+
+        System.out.println("kind       STM8 full  STM8 kernel  saving  host full ns  host kernel ns  exact");
+        for (int kind = 0; kind < KINDS.length; ++kind) {
+            short[] matrix = matrices[kind];
+            if (classify(matrix) != kind) {
+                throw new IllegalStateException("Unexpected matrix kind: " + KINDS[kind]);
+            }
+
+            boolean exact = true;
+            short[] full = new short[3];
+            short[] specialized = new short[3];
+            for (short[] sample : samples) {
+                transform(matrix, 0, sample, full);
+                transform(matrix, kind, sample, specialized);
+                for (int i = 0; i < 3; ++i) {
+                    exact &= full[i] == specialized[i];
+                }
+            }
+
+            int fullCycles = cycles(0);
+            int kernelCycles = cycles(kind);
+            System.out.println(String.format("%-10s %9d  %11d  %5.0f%%  %12.1f  %14.1f  %s",
+                    KINDS[kind], fullCycles, kernelCycles, 100.0 * (fullCycles - kernelCycles) / fullCycles,
+                    measure(matrix, 0, samples), measure(matrix, kind, samples), exact));
+        }
+    }
+
+    //Estimated STM8 cycles per sample
+    private static int cycles(int kind) {
+        switch (kind) {
+            case 1:
+                return 3 * (MULDIV_CYCLES + ADD_CYCLES + SCALE2LE_CYCLES);
+            case 2:
+                return 3 * (HALF_CYCLES + ADD_CYCLES + SCALE2LE_CYCLES);
+            case 3:
+                return 3 * (HALF_CYCLES + SCALE2LE_CYCLES);
+            default:
+                return 3 * (3 * MULDIV_CYCLES + 3 * ADD_CYCLES + SCALE2LE_CYCLES);
+        }
+    }
+
+    private static double measure(short[] matrix, int kind, short[][] samples) {
+        short[] result = new short[3];
+        int sink = 0;
+        //Warm up the JIT
+        for (int pass = 0; pass < 100; ++pass) {
+            for (short[] sample : samples) {
+                transform(matrix, kind, sample, result);
+                sink += result[0];
+            }
+        }
+        int passes = 1000;
+        long start = System.nanoTime();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (short[] sample : samples) {
+                transform(matrix, kind, sample, result);
+                sink += result[0];
+            }
+        }
+        long time = System.nanoTime() - start;
+        if (sink == 42) {
+            System.out.print("");
+        }
+        return (double) time / passes / samples.length;
+    }
+
+    //VectorCorrection::classify
+    private static int classify(short[] matrix) {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                if (row != col && get(matrix, row, col) != 0) {
+                    return 0;
+                }
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (get(matrix, i, i) != UNIT) {
+                return 1;
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (get(matrix, 3, i) != 0) {
+                return 2;
+            }
+        }
+        return 3;
+    }
+
+    //VectorCorrection::transform. The result is in MCU byte order.
+    private static void transform(short[] matrix, int kind, short[] data, short[] result) {
+        for (int col = 0; col < 3; ++col) {
+            int sum;
+            switch (kind) {
+                case 1:
+                    sum = mul(data[col], get(matrix, col, col)) + get(matrix, 3, col);
+                    break;
+                case 2:
+                    sum = data[col] / 2 + get(matrix, 3, col);
+                    break;
+                case 3:
+                    sum = data[col] / 2;
+                    break;
+                default:
+                    sum = mul(data[0], get(matrix, 0, col)) + mul(data[1], get(matrix, 1, col))
+                            + mul(data[2], get(matrix, 2, col)) + get(matrix, 3, col);
+                    break;
+            }
+            result[col] = scale2((short) sum);
+        }
+    }
+
+    private static short get(short[] matrix, int row, int col) {
+        return matrix[row * 3 + col];
+    }
+
+    //muldivs16x16_16x
+    private static int mul(int a, int b) {
+        int result = (Math.abs(a) * Math.abs(b)) >>> 15;
+        return (short) ((a < 0) != (b < 0) ? -result : result);
+    }
+
+    //scale2 without the byte order conversion
+    private static short scale2(short value) {
+        return (short) Math.max(Short.MIN_VALUE, Math.min(Short.MAX_VALUE, value * 2));
+    }
+}
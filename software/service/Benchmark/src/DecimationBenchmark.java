@@ -0,0 +1,99 @@
+import deviation.DeviationCalc3D;
+import deviation.FloatValue;
+
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Shows the noise floor reduction given by the firmware decimation stage (sensors/DecimationProvider.h).
+ * The input traces are recorded from the steady sensor, so the deviation of the samples is the sensor noise.
+ * The trace format is the same as the calibration programs save: one sample per line, "x,y,z,".
+ *
+ * Usage: DecimationBenchmark trace1.txt [trace2.txt ...]
+ */
+public class DecimationBenchmark {
+    private static final int[] FACTORS = {1, 2, 4, 8, 16, 32};
+
+    public static void main(String[] args) throws IOException {
+        if (args.length == 0) {
+            System.out.println("Usage: DecimationBenchmark trace1.txt [trace2.txt ...]");
+            return;
+        }
+
+        for (String fileName : args) {
+            List<int[]> trace = readTrace(fileName);
+            System.out.println(fileName + ": " + trace.size() + " samples");
+            System.out.println("factor  outputs  dev x     dev y     dev z     gain    ideal");
+
+            float baseline = 0;
+            for (int factor : FACTORS) {
+                List<int[]> output = decimate(trace, factor);
+                if (output.size() < 2) {
+                    break;
+                }
+                DeviationCalc3D calc = new DeviationCalc3D();
+                for (int[] sample : output) {
+                    calc.add(sample);
+                }
+                FloatValue deviation = calc.getDeviation();
+                float noise = (deviation.x + deviation.y + deviation.z) / 3;
+                if (factor == 1) {
+                    baseline = noise;
+                }
+                System.out.println(String.format("%6d  %7d  %8.3f  %8.3f  %8.3f  %6.2f  %6.2f",
+                        factor, output.size(), deviation.x, deviation.y, deviation.z,
+                        noise > 0 ? baseline / noise : 0, Math.sqrt(factor)));
+            }
+            System.out.println();
+        }
+    }
+
+    /**
+     * Repeats the firmware decimation: 32-bit sums of factor samples, the average is rounded
+     * by adding factor / 2 and shifting right.
+     *
+     * @param trace source samples
+     * @param factor number of the source samples in one output sample, a power of 2
+     * @return decimated samples
+     */
+    private static List<int[]> decimate(List<int[]> trace, int factor) {
+        int shift = Integer.numberOfTrailingZeros(factor);
+        List<int[]> result = new ArrayList<>();
+        int[] sum = new int[3];
+        int count = 0;
+        for (int[] sample : trace) {
+            for (int i = 0; i < 3; ++i) {
+                sum[i] += sample[i];
+            }
+            if (++count == factor) {
+                int[] output = new int[3];
+                for (int i = 0; i < 3; ++i) {
+                    output[i] = (short) ((sum[i] + factor / 2) >> shift);
+                    sum[i] = 0;
+                }
+                result.add(output);
+                count = 0;
+            }
+        }
+        return result;
+    }
+
+    private static List<int[]> readTrace(String fileName) throws IOException {
+        List<int[]> trace = new ArrayList<>();
+        for (String line : Files.readAllLines(Paths.get(fileName))) {
+            String[] parts = line.split("\\,");
+            if (parts.length < 3) {
+                continue;
+            }
+            int[] row = new int[3];
+            for (int i = 0; i < row.length; ++i) {
+                row[i] = Short.valueOf(parts[i].trim());
+            }
+            trace.add(row);
+        }
+        return trace;
+    }
+}
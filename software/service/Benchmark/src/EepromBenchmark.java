@@ -0,0 +1,203 @@
+import java.util.Random;
+
+/**
+ * Estimates the time of writing the full LSM6DS3 calibration (4 accelerometer and 5 gyroscope scales,
+ * all temperature points) with the word programming and the block programming of the firmware
+ * EEPROM writer (stm8/eeprom.h).
+ *
+ * The model replays the EEPROM writes of the calibration records on the firmware data layout
+ * (LSM6DS3 main.cpp) and counts the programming operations. The block writer skips the blocks
+ * that already contain the data and uses the fast programming for the erased blocks.
+ * The host time includes the fixed delay of the previous driver and the completion polling
+ * of the status mode of the current one.
+ *
+ * Usage: EepromBenchmark
+ */
+public class EepromBenchmark {
+    //STM8S103 data EEPROM
+    private static final int EEPROM_SIZE = 640;
+    private static final int BLOCK_SIZE = 64;
+
+    //Programming times, ms
+    private static final double PROGRAM_TIME = 6;      //erase and write of a byte, a word or a block
+    private static final double FAST_PROGRAM_TIME = 3; //write of the erased block
+
+    //Driver timings, ms
+    private static final double SWITCH_DELAY = 200;    //status mode selection, once per series
+    private static final double POLL_PERIOD = 10;
+    private static final double STATUS_PERIOD = 1000.0 / 104;
+
+    private static final int MATRIX_SIZE = 24;
+    private static final int RECORD_SIZE = MATRIX_SIZE + 4;
+    private static final int TEMPERATURE_POINTS = 2;
+    private static final int HEADER_SIZE = 4;
+
+    private static final int ACCEL_SCALES = 4;
+    private static final int GYRO_SCALES = 5;
+
+    //The section of one device: header, matrices[points][scales], temperatures[points][scales], pointCounts
+    private static class Section {
+        final int start;
+        final int scales;
+
+        Section(int start, int scales) {
+            this.start = start;
+            this.scales = scales;
+        }
+
+        int matrix(int scale, int point) {
+            return start + HEADER_SIZE + (point * scales + scale) * MATRIX_SIZE;
+        }
+
+        int temperature(int scale, int point) {
+            return start + HEADER_SIZE + TEMPERATURE_POINTS * scales * MATRIX_SIZE + (point * scales + scale) * 2;
+        }
+
+        int points(int scale) {
+            return start + HEADER_SIZE + TEMPERATURE_POINTS * scales * (MATRIX_SIZE + 2) + scale;
+        }
+
+        int end() {
+            return points(0) + ((scales + 3) & ~3);
+        }
+    }
+
+    //EEPROM image and the programming time of one writer
+    private static abstract class Writer {
+        final byte[] memory = new byte[EEPROM_SIZE];
+        double time;
+        int operations;
+
+        abstract void write(int dest, byte[] data);
+
+        void program(double duration) {
+            time += duration;
+            ++operations;
+        }
+    }
+
+    //The previous writer: dwords and the tail bytes
+    private static class WordWriter extends Writer {
+        @Override
+        void write(int dest, byte[] data) {
+            int dwords = data.length / 4;
+            int tail = data.length % 4;
+            for (int i = 0; i < dwords + tail; ++i) {
+                program(PROGRAM_TIME);
+            }
+            System.arraycopy(data, 0, memory, dest, data.length);
+        }
+    }
+
+    private static class BlockWriter extends Writer {
+        @Override
+        void write(int dest, byte[] data) {
+            int src = 0;
+            while (src < data.length) {
+                int offset = dest % BLOCK_SIZE;
+                int part = Math.min(BLOCK_SIZE - offset, data.length - src);
+                if (!equals(dest, data, src, part)) {
+                    program(isErased(dest - offset) ? FAST_PROGRAM_TIME : PROGRAM_TIME);
+                    System.arraycopy(data, src, memory, dest, part);
+                }
+                dest += part;
+                src += part;
+            }
+        }
+
+        private boolean equals(int dest, byte[] data, int src, int size) {
+            for (int i = 0; i < size; ++i) {
+                if (memory[dest + i] != data[src + i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        private boolean isErased(int block) {
+            for (int i = 0; i < BLOCK_SIZE; ++i) {
+                if (memory[block + i] != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    public static void main(String[] args) {
+        //The base class of the EEPROM hierarchy is the last device of the list
+        Section accel = new Section(0, ACCEL_SCALES);
+        Section gyro = new Section(accel.end(), GYRO_SCALES);
+
+        System.out.println("EEPROM state   writer  operations  EEPROM ms  host ms");
+        for (boolean erased : new boolean[] {true, false}) {
+            Writer[] writers = {new WordWriter(), new BlockWriter()};
+            String[] names = {"word", "block"};
+            for (int i = 0; i < writers.length; ++i) {
+                Writer writer = writers[i];
+                if (!erased) {
+                    new Random(1).nextBytes(writer.memory);
+                }
+                //The calibration data differs from the previous one
+                Random random = new Random(2);
+                double host = 0;
+                int records = 0;
+                for (Section section : new Section[] {accel, gyro}) {
+                    for (int scale = 0; scale < section.scales; ++scale) {
+                        for (int point = 0; point < TEMPERATURE_POINTS; ++point) {
+                            double start = writer.time;
+                            writeRecord(writer, section, scale, point, random);
+                            host += hostTime(i == 0, writer.time - start);
+                            ++records;
+                        }
+                    }
+                }
+                if (i != 0) {
+                    host += SWITCH_DELAY;
+                }
+                System.out.println(String.format("%-14s %-6s  %10d  %9.0f  %7.0f",
+                        erased ? "erased" : "programmed", names[i], writer.operations, writer.time, host));
+                if (records != (ACCEL_SCALES + GYRO_SCALES) * TEMPERATURE_POINTS) {
+                    throw new IllegalStateException("Unexpected record count");
+                }
+            }
+        }
+    }
+
+    //ThermalTransformProvider::updateEeprom
+    private static void writeRecord(Writer writer, Section section, int scale, int point, Random random) {
+        byte[] matrix = new byte[MATRIX_SIZE];
+        random.nextBytes(matrix);
+        byte[] temperature = new byte[2];
+        random.nextBytes(temperature);
+
+        writer.write(section.matrix(scale, point), matrix);
+        writer.write(section.temperature(scale, point), temperature);
+        writer.write(section.points(scale), new byte[] {(byte) (point + 1)});
+
+        int crc = crc16(writer.memory, section.start + HEADER_SIZE, section.end() - section.start - HEADER_SIZE);
+        writer.write(section.start, new byte[] {1, (byte) section.scales, (byte) (crc >> 8), (byte) crc});
+    }
+
+    //Host time of one record: the previous driver waited 3 ms per command byte,
+    //the current one polls the write counter of the status mode
+    private static double hostTime(boolean fixedDelay, double eepromTime) {
+        if (fixedDelay) {
+            return Math.max((RECORD_SIZE + 1) * 3, eepromTime);
+        }
+        double ready = eepromTime + STATUS_PERIOD;
+        return Math.ceil(ready / POLL_PERIOD) * POLL_PERIOD;
+    }
+
+    //utils::crc16
+    private static int crc16(byte[] data, int offset, int size) {
+        int crc = 0xFFFF;
+        for (int i = 0; i < size; ++i) {
+            crc ^= (data[offset + i] & 0xFF) << 8;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x8000) != 0 ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+            }
+        }
+        return crc;
+    }
+}
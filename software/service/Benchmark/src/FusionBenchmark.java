@@ -0,0 +1,373 @@
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Random;
+
+/**
+ * Compares the firmware fixed-point orientation filter (math/fusion.h) with the same
+ * filter in double precision and measures the host throughput of both.
+ *
+ * The fixed-point filter repeats the firmware arithmetic bit by bit, including
+ * the rounding of the math/muldiv.h kernels. The input trace has one IMU-ALL sample
+ * per line: "ax,ay,az,gx,gy,gz," in calibrated digits. Without a trace the benchmark
+ * generates a synthetic one and also reports the error against the true orientation.
+ *
+ * Usage: FusionBenchmark [gyroRange accelRange rate [trace.txt]]
+ *   gyroRange - gyro full scale is 125dps * 2^gyroRange (default 1, 245dps)
+ *   accelRange - accel full scale is 2g * 2^accelRange (default 0)
+ *   rate - sample rate is 13Hz * 2^rate, 3..5 (default 5, 416Hz)
+ */
+public class FusionBenchmark {
+    private static final int SETTLING_SAMPLES = 1024;
+    private static final int SETTLING_BOOST = 3;
+    //The error statistics skip the settling time
+    private static final int SKIP_SAMPLES = 2 * SETTLING_SAMPLES;
+
+    private static final double GYRO_125DPS = 4.375e-3 * Math.PI / 180; //rad/s per digit
+    private static final double KP = 1;
+
+    public static void main(String[] args) throws IOException {
+        int gyroRange = args.length >= 3 ? Integer.parseInt(args[0]) : 1;
+        int accelRange = args.length >= 3 ? Integer.parseInt(args[1]) : 0;
+        int rate = args.length >= 3 ? Integer.parseInt(args[2]) : 5;
+        double sampleRate = 13.0 * (1 << rate);
+
+        List<short[]> trace;
+        List<double[]> truth = null;
+        if (args.length >= 4) {
+            trace = readTrace(args[3]);
+        } else {
+            truth = new ArrayList<>();
+            trace = generateTrace(gyroRange, accelRange, sampleRate, 120, truth);
+        }
+        System.out.println(trace.size() + " samples, " + sampleRate + " Hz");
+
+        FixedFilter fixed = new FixedFilter(gyroRange, accelRange, rate);
+        DoubleFilter reference = new DoubleFilter(gyroRange, accelRange, sampleRate);
+
+        ErrorStats fixedToReference = new ErrorStats();
+        ErrorStats fixedToTruth = new ErrorStats();
+        ErrorStats referenceToTruth = new ErrorStats();
+        short[] q = new short[4];
+        for (int i = 0; i < trace.size(); ++i) {
+            short[] sample = trace.get(i);
+            fixed.update(sample);
+            reference.update(sample);
+            if (i >= SKIP_SAMPLES) {
+                fixed.getQuaternion(q);
+                double[] fq = {q[0] / 16384.0, q[1] / 16384.0, q[2] / 16384.0, q[3] / 16384.0};
+                fixedToReference.add(angle(fq, reference.q));
+                if (truth != null) {
+                    fixedToTruth.add(angle(fq, truth.get(i)));
+                    referenceToTruth.add(angle(reference.q, truth.get(i)));
+                }
+            }
+        }
+
+        System.out.println("                       mean deg  max deg");
+        fixedToReference.print("fixed vs double");
+        if (truth != null) {
+            fixedToTruth.print("fixed vs truth");
+            referenceToTruth.print("double vs truth");
+        }
+
+        System.out.println(String.format("host ns/sample: fixed %.1f, double %.1f",
+                measure(trace, new FixedFilter(gyroRange, accelRange, rate)),
+                measure(trace, new DoubleFilter(gyroRange, accelRange, sampleRate))));
+        System.out.println("STM8 kernel calls/sample: " + FixedFilter.KERNEL_CALLS);
+    }
+
+    interface Filter {
+        void update(short[] sample);
+    }
+
+    private static double measure(List<short[]> trace, Filter filter) {
+        //Warm up the JIT
+        for (short[] sample : trace) {
+            filter.update(sample);
+        }
+        int passes = 10;
+        long start = System.nanoTime();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (short[] sample : trace) {
+                filter.update(sample);
+            }
+        }
+        return (double) (System.nanoTime() - start) / passes / trace.size();
+    }
+
+    /**
+     * Firmware filter: Q30 quaternion, the products are calculated by 16-bit kernels.
+     */
+    static class FixedFilter implements Filter {
+        //Kernel calls in correct (norm, gravity, error, feedback), integrate and normalize.
+        //muls32x16_32x takes two kernel calls.
+        static final int KERNEL_CALLS = 3 + 8 + 6 + 3 + 12 + 4 * 2 + 4 + 4 * 2;
+
+        private static final int GYRO_GAIN = 25227;
+        private static final int FEEDBACK_GAIN = 26192;
+        private static final int ONE_Q28 = 1 << 28;
+        private static final int MIN_ACCEL_Q26 = 1 << 25;
+        private static final int MAX_ACCEL_Q26 = 1 << 27;
+        private static final int MAX_ACCEL_Q13 = 0x4000;
+
+        private final int[] q = {1 << 30, 0, 0, 0};
+        private final int gyroShift;
+        private final int feedbackShift;
+        private final int accelShift;
+        private int settling = SETTLING_SAMPLES;
+
+        FixedFilter(int gyroRange, int accelRange, int rate) {
+            gyroShift = rate + 2 - gyroRange;
+            feedbackShift = gyroRange;
+            accelShift = accelRange;
+        }
+
+        private static int high(int value) {
+            return (short) (value >> 16);
+        }
+
+        private static int saturate(int value) {
+            return Math.max(-32767, Math.min(32767, value));
+        }
+
+        private static int muls16x16_32(int a, int b) {
+            return a * b;
+        }
+
+        private static int muldivs16x16_16x(int a, int b) {
+            int result = (Math.abs(a) * Math.abs(b)) >>> 15;
+            return (short) ((a < 0) != (b < 0) ? -result : result);
+        }
+
+        private static int muls32x16_32x(int a, int b) {
+            boolean negative = b < 0;
+            if (negative) {
+                b = -b;
+            }
+            int result = muls16x16_32(high(a), b) * 2 + (int) (((long) (a & 0xFFFF) * b) >>> 15);
+            return negative ? -result : result;
+        }
+
+        private void correct(short[] sample, int[] rate, int boost) {
+            int[] a = new int[3];
+            for (int i = 0; i < 3; ++i) {
+                int value = (sample[i] << accelShift) / 2;
+                if (value > MAX_ACCEL_Q13 || value < -MAX_ACCEL_Q13) {
+                    return;
+                }
+                a[i] = value;
+            }
+            int norm = muls16x16_32(a[0], a[0]) + muls16x16_32(a[1], a[1]) + muls16x16_32(a[2], a[2]);
+            if (norm < MIN_ACCEL_Q26 || norm > MAX_ACCEL_Q26) {
+                return;
+            }
+
+            int q0 = high(q[0]), q1 = high(q[1]), q2 = high(q[2]), q3 = high(q[3]);
+            int vx = (short) ((muls16x16_32(q1, q3) - muls16x16_32(q0, q2)) >> 13);
+            int vy = (short) ((muls16x16_32(q0, q1) + muls16x16_32(q2, q3)) >> 13);
+            int vz = (short) ((muls16x16_32(q0, q0) - muls16x16_32(q1, q1) - muls16x16_32(q2, q2) + muls16x16_32(q3, q3)) >> 14);
+
+            int[] error = {
+                    (short) ((muls16x16_32(a[1], vz) - muls16x16_32(a[2], vy)) >> 13),
+                    (short) ((muls16x16_32(a[2], vx) - muls16x16_32(a[0], vz)) >> 13),
+                    (short) ((muls16x16_32(a[0], vy) - muls16x16_32(a[1], vx)) >> 13)
+            };
+            for (int i = 0; i < 3; ++i) {
+                int feedback = (muldivs16x16_16x(error[i], FEEDBACK_GAIN) << boost) >> feedbackShift;
+                rate[i] = saturate(rate[i] + feedback);
+            }
+        }
+
+        private void integrate(int[] rate) {
+            int q0 = high(q[0]), q1 = high(q[1]), q2 = high(q[2]), q3 = high(q[3]);
+            int wx = rate[0], wy = rate[1], wz = rate[2];
+            int[] delta = {
+                    -muls16x16_32(q1, wx) - muls16x16_32(q2, wy) - muls16x16_32(q3, wz),
+                    muls16x16_32(q0, wx) + muls16x16_32(q2, wz) - muls16x16_32(q3, wy),
+                    muls16x16_32(q0, wy) - muls16x16_32(q1, wz) + muls16x16_32(q3, wx),
+                    muls16x16_32(q0, wz) + muls16x16_32(q1, wy) - muls16x16_32(q2, wx)
+            };
+            for (int i = 0; i < 4; ++i) {
+                q[i] += muls32x16_32x(delta[i], GYRO_GAIN) >> gyroShift;
+            }
+        }
+
+        private void normalize() {
+            int norm = 0;
+            for (int i = 0; i < 4; ++i) {
+                int value = high(q[i]);
+                norm += muls16x16_32(value, value);
+            }
+            int correction = saturate((ONE_Q28 - norm) >> 14);
+            for (int i = 0; i < 4; ++i) {
+                q[i] += muls32x16_32x(q[i], correction);
+            }
+        }
+
+        @Override
+        public void update(short[] sample) {
+            int[] rate = {sample[3], sample[4], sample[5]};
+            int boost = 0;
+            if (settling != 0) {
+                --settling;
+                boost = SETTLING_BOOST;
+            }
+            correct(sample, rate, boost);
+            integrate(rate);
+            normalize();
+        }
+
+        void getQuaternion(short[] result) {
+            for (int i = 0; i < 4; ++i) {
+                result[i] = (short) ((q[i] + 0x8000) >> 16);
+            }
+        }
+    }
+
+    /**
+     * The same filter in double precision with the exact normalization.
+     */
+    static class DoubleFilter implements Filter {
+        final double[] q = {1, 0, 0, 0};
+        private final double gyroScale;
+        private final double accelScale;
+        private final double dt;
+        private int settling = SETTLING_SAMPLES;
+
+        DoubleFilter(int gyroRange, int accelRange, double sampleRate) {
+            gyroScale = GYRO_125DPS * (1 << gyroRange);
+            accelScale = (1 << accelRange) / 16384.0;
+            dt = 1 / sampleRate;
+        }
+
+        @Override
+        public void update(short[] sample) {
+            double[] w = {sample[3] * gyroScale, sample[4] * gyroScale, sample[5] * gyroScale};
+            double ax = sample[0] * accelScale, ay = sample[1] * accelScale, az = sample[2] * accelScale;
+            double kp = KP;
+            if (settling != 0) {
+                --settling;
+                kp *= 1 << SETTLING_BOOST;
+            }
+
+            double norm = ax * ax + ay * ay + az * az;
+            boolean inRange = Math.abs(ax) <= 2 && Math.abs(ay) <= 2 && Math.abs(az) <= 2;
+            if (inRange && norm >= 0.5 && norm <= 2) {
+                double[] v = gravity(q);
+                w[0] += kp * (ay * v[2] - az * v[1]);
+                w[1] += kp * (az * v[0] - ax * v[2]);
+                w[2] += kp * (ax * v[1] - ay * v[0]);
+            }
+
+            double h = dt / 2;
+            double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+            q[0] += h * (-q1 * w[0] - q2 * w[1] - q3 * w[2]);
+            q[1] += h * (q0 * w[0] + q2 * w[2] - q3 * w[1]);
+            q[2] += h * (q0 * w[1] - q1 * w[2] + q3 * w[0]);
+            q[3] += h * (q0 * w[2] + q1 * w[1] - q2 * w[0]);
+
+            double length = Math.sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+            for (int i = 0; i < 4; ++i) {
+                q[i] /= length;
+            }
+        }
+    }
+
+    private static class ErrorStats {
+        private double sum;
+        private double max;
+        private int count;
+
+        void add(double value) {
+            sum += value;
+            max = Math.max(max, value);
+            ++count;
+        }
+
+        void print(String name) {
+            System.out.println(String.format("%-20s %10.4f %8.4f", name, count > 0 ? sum / count : 0, max));
+        }
+    }
+
+    //Gravity direction in the sensor frame
+    private static double[] gravity(double[] q) {
+        return new double[]{
+                2 * (q[1] * q[3] - q[0] * q[2]),
+                2 * (q[0] * q[1] + q[2] * q[3]),
+                q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]
+        };
+    }
+
+    //Rotation angle between two orientations in degrees
+    private static double angle(double[] a, double[] b) {
+        double dot = 0, la = 0, lb = 0;
+        for (int i = 0; i < 4; ++i) {
+            dot += a[i] * b[i];
+            la += a[i] * a[i];
+            lb += b[i] * b[i];
+        }
+        double cos = Math.min(1, Math.abs(dot) / Math.sqrt(la * lb));
+        return Math.toDegrees(2 * Math.acos(cos));
+    }
+
+    /**
+     * Generates samples of the sensor rotating with smoothly varying rates. The sensor starts tilted by 20 degrees.
+     * The true orientation is integrated exactly.
+     */
+    private static List<short[]> generateTrace(int gyroRange, int accelRange, double sampleRate, double seconds, List<double[]> truth) {
+        Random random = new Random(1);
+        double gyroScale = GYRO_125DPS * (1 << gyroRange);
+        double oneG = 16384 >> accelRange;
+        double dt = 1 / sampleRate;
+        double tilt = Math.toRadians(20);
+        double[] q = {Math.cos(tilt / 2), Math.sin(tilt / 2), 0, 0};
+
+        List<short[]> trace = new ArrayList<>();
+        int count = (int) (seconds * sampleRate);
+        for (int i = 0; i < count; ++i) {
+            double t = i * dt;
+            double[] w = {0.8 * Math.sin(0.5 * t), 0.6 * Math.cos(0.3 * t), 1.5 * Math.sin(0.2 * t)};
+            double[] g = gravity(q);
+            short[] sample = new short[6];
+            for (int axis = 0; axis < 3; ++axis) {
+                sample[axis] = (short) Math.round(g[axis] * oneG + random.nextGaussian() * 3);
+                sample[axis + 3] = (short) Math.round(w[axis] / gyroScale + random.nextGaussian() * 2);
+            }
+            trace.add(sample);
+
+            //Rotation by w * dt in the sensor frame
+            double rate = Math.sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+            double half = rate * dt / 2;
+            double s = rate > 0 ? Math.sin(half) / rate : 0;
+            double[] d = {Math.cos(half), w[0] * s, w[1] * s, w[2] * s};
+            q = new double[]{
+                    q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+                    q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+                    q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+                    q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0]
+            };
+            //The sample is taken before the rotation, the filter output follows it
+            truth.add(q);
+        }
+        return trace;
+    }
+
+    private static List<short[]> readTrace(String fileName) throws IOException {
+        List<short[]> trace = new ArrayList<>();
+        for (String line : Files.readAllLines(Paths.get(fileName))) {
+            String[] parts = line.split("\\,");
+            if (parts.length < 6) {
+                continue;
+            }
+            short[] row = new short[6];
+            for (int i = 0; i < row.length; ++i) {
+                row[i] = (short) Double.parseDouble(parts[i].trim());
+            }
+            trace.add(row);
+        }
+        return trace;
+    }
+}
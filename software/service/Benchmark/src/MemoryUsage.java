@@ -0,0 +1,189 @@
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.TreeSet;
+
+/**
+ * RAM and flash usage of the firmware from the IAR linker map files.
+ *
+ * The linker writes the totals at the end of the map file:
+ *     7 851 bytes of readonly  code memory
+ *       269 bytes of readonly  data memory
+ *       784 bytes of readwrite data memory
+ * and the "ro code", "ro data" and "rw data" of each object file in the MODULE SUMMARY section.
+ * The numbers use the space as the thousands separator.
+ *
+ * The flash keeps the code and the read-only data, the initializers of the variables included.
+ * The RAM keeps the read-write data: the variables, the process stacks (HW_STACK section)
+ * and the CSTACK block of main and the interrupt handlers.
+ * The totals are compared with the STM8S103 memory: 8 KB flash and 1 KB RAM.
+ *
+ * With two map files it prints the difference of each module, for example the build
+ * before and after a change.
+ *
+ * Usage: MemoryUsage map-file [map-file-after]
+ */
+public class MemoryUsage {
+    private static final int FLASH_SIZE = 8192;
+    private static final int RAM_SIZE = 1024;
+
+    private static final String MODULE_SECTION = "MODULE SUMMARY";
+    private static final String[] COLUMNS = {"ro code", "ro data", "rw data"};
+    private static final int RO_CODE = 0;
+    private static final int RO_DATA = 1;
+    private static final int RW_DATA = 2;
+
+    private static class MapFile {
+        final String name;
+        //ro code, ro data, rw data
+        final int[] total = new int[COLUMNS.length];
+        final Map<String, int[]> modules = new LinkedHashMap<>();
+
+        MapFile(String name) {
+            this.name = name;
+        }
+
+        int flash() {
+            return total[RO_CODE] + total[RO_DATA];
+        }
+
+        int ram() {
+            return total[RW_DATA];
+        }
+    }
+
+    public static void main(String[] args) throws IOException {
+        if (args.length == 0 || args.length > 2) {
+            System.out.println("Usage: MemoryUsage map-file [map-file-after]");
+            return;
+        }
+
+        List<MapFile> maps = new ArrayList<>();
+        for (String arg : args) {
+            MapFile map = load(new File(arg));
+            if (map.flash() == 0 && map.ram() == 0) {
+                System.out.println(arg + " does not contain the memory totals, enable the map file output of the linker");
+                return;
+            }
+            maps.add(map);
+        }
+
+        for (MapFile map : maps) {
+            System.out.println(String.format("%s: flash %d of %d bytes (code %d, data %d), RAM %d of %d bytes",
+                    map.name, map.flash(), FLASH_SIZE, map.total[RO_CODE], map.total[RO_DATA], map.ram(), RAM_SIZE));
+        }
+        if (maps.size() == 1) {
+            printModules(maps.get(0));
+        } else {
+            printDifference(maps.get(0), maps.get(1));
+        }
+    }
+
+    private static MapFile load(File file) throws IOException {
+        MapFile map = new MapFile(file.getName());
+        boolean inModules = false;
+        int[] columnEnds = null;
+        for (String line : Files.readAllLines(file.toPath(), StandardCharsets.ISO_8859_1)) {
+            String text = line.trim();
+            if (text.contains(MODULE_SECTION)) {
+                inModules = true;
+                continue;
+            }
+            if (text.startsWith("***") && text.length() > 3 && columnEnds != null) {
+                //The next section
+                inModules = false;
+            }
+
+            if (parseTotal(text, map)) {
+                continue;
+            }
+            if (!inModules) {
+                continue;
+            }
+
+            if (line.contains(COLUMNS[0]) && line.contains(COLUMNS[RW_DATA])) {
+                columnEnds = new int[COLUMNS.length];
+                for (int i = 0; i < COLUMNS.length; ++i) {
+                    columnEnds[i] = line.indexOf(COLUMNS[i]) + COLUMNS[i].length();
+                }
+            } else if (columnEnds != null && text.contains(".o ")) {
+                //    module.o      1 473      106      449
+                String name = text.substring(0, text.indexOf(".o ") + 2);
+                int[] sizes = map.modules.get(name);
+                if (sizes == null) {
+                    sizes = new int[COLUMNS.length];
+                    map.modules.put(name, sizes);
+                }
+                int start = line.indexOf(name) + name.length();
+                for (int i = 0; i < COLUMNS.length; ++i) {
+                    int end = Math.min(columnEnds[i], line.length());
+                    if (start < end) {
+                        sizes[i] += parseNumber(line.substring(start, end));
+                    }
+                    start = Math.max(start, end);
+                }
+            }
+        }
+        return map;
+    }
+
+    //Parses "N bytes of readonly code memory" and the similar lines
+    private static boolean parseTotal(String text, MapFile map) {
+        int index = text.indexOf(" bytes of ");
+        if (index < 0 || !text.endsWith(" memory")) {
+            return false;
+        }
+        int value = parseNumber(text.substring(0, index));
+        String kind = text.substring(index + " bytes of ".length()).replaceAll("\\s+", " ");
+        if (kind.startsWith("readonly code")) {
+            map.total[RO_CODE] = value;
+        } else if (kind.startsWith("readonly data")) {
+            map.total[RO_DATA] = value;
+        } else if (kind.startsWith("readwrite data")) {
+            map.total[RW_DATA] = value;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    //The spaces are the thousands separators, an empty column is zero
+    private static int parseNumber(String text) {
+        String digits = text.replace(" ", "").replace("'", "");
+        return digits.matches("\\d+") ? Integer.parseInt(digits) : 0;
+    }
+
+    private static void printModules(MapFile map) {
+        System.out.println();
+        System.out.println(String.format("%-32s %8s %8s %8s", "Module", COLUMNS[RO_CODE], COLUMNS[RO_DATA], COLUMNS[RW_DATA]));
+        for (Map.Entry<String, int[]> module : map.modules.entrySet()) {
+            int[] sizes = module.getValue();
+            System.out.println(String.format("%-32s %8d %8d %8d", module.getKey(), sizes[RO_CODE], sizes[RO_DATA], sizes[RW_DATA]));
+        }
+    }
+
+    private static void printDifference(MapFile before, MapFile after) {
+        System.out.println(String.format("difference: flash %+d bytes, RAM %+d bytes", after.flash() - before.flash(), after.ram() - before.ram()));
+
+        Set<String> names = new TreeSet<>(before.modules.keySet());
+        names.addAll(after.modules.keySet());
+        int[] none = new int[COLUMNS.length];
+
+        System.out.println();
+        System.out.println(String.format("%-32s %8s %8s %8s", "Module (after - before)", COLUMNS[RO_CODE], COLUMNS[RO_DATA], COLUMNS[RW_DATA]));
+        for (String name : names) {
+            int[] old = before.modules.containsKey(name) ? before.modules.get(name) : none;
+            int[] sizes = after.modules.containsKey(name) ? after.modules.get(name) : none;
+            if (old[RO_CODE] != sizes[RO_CODE] || old[RO_DATA] != sizes[RO_DATA] || old[RW_DATA] != sizes[RW_DATA]) {
+                System.out.println(String.format("%-32s %+8d %+8d %+8d", name,
+                        sizes[RO_CODE] - old[RO_CODE], sizes[RO_DATA] - old[RO_DATA], sizes[RW_DATA] - old[RW_DATA]));
+            }
+        }
+    }
+}
@@ -0,0 +1,263 @@
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * Static estimate of the firmware stack depth from the IAR list files of a build.
+ *
+ * The compiler lists the stack usage of each function and its direct calls in the
+ * "Maximum stack usage in bytes" section of the list file, the template instances included.
+ * The program joins the call graphs of all list files and finds the deepest call chain
+ * of each uncalled function: the process exec() functions, the interrupt handlers and main.
+ * The interrupts use the stack of the current process, so the estimate of a process stack
+ * adds the deepest interrupt handler and the frame the MCU pushes on the interrupt.
+ * The nested interrupts and the OS context are not taken into account.
+ * The functions without the list file (assembler, library) are counted as zero depth.
+ *
+ * The device reports the measured stack slack in the diagnostic mode (ImuLsm6ds3.selectStackUsage).
+ *
+ * Usage: StackUsage list-directory-or-file [...]
+ */
+public class StackUsage {
+    private static final String SECTION_START = "Maximum stack usage in bytes";
+    private static final String CALL = "->";
+    //STM8 pushes PC, Y, X, A and CC on the interrupt
+    private static final int INTERRUPT_FRAME = 9;
+
+    private static class Function {
+        final String name;
+        int frame;
+        //Callee names and the stack usage at the call
+        final Map<String, Integer> calls = new LinkedHashMap<>();
+
+        Function(String name) {
+            this.name = name;
+        }
+    }
+
+    private static class Depth {
+        final int bytes;
+        final List<String> path;
+
+        Depth(int bytes, List<String> path) {
+            this.bytes = bytes;
+            this.path = path;
+        }
+    }
+
+    private final Map<String, Function> functions = new HashMap<>();
+    private final Map<String, Depth> depths = new HashMap<>();
+    private final Set<String> unknown = new HashSet<>();
+    private final Set<String> recursive = new HashSet<>();
+
+    public static void main(String[] args) throws IOException {
+        if (args.length == 0) {
+            System.out.println("Usage: StackUsage list-directory-or-file [...]");
+            return;
+        }
+
+        StackUsage usage = new StackUsage();
+        for (String arg : args) {
+            usage.load(new File(arg));
+        }
+        if (usage.functions.isEmpty()) {
+            System.out.println("The list files do not contain the stack usage, enable the list file output of the compiler");
+            return;
+        }
+        usage.report();
+    }
+
+    private void load(File file) throws IOException {
+        if (file.isDirectory()) {
+            File[] files = file.listFiles();
+            if (files != null) {
+                for (File child : files) {
+                    load(child);
+                }
+            }
+        } else if (file.getName().endsWith(".lst")) {
+            parse(Files.readAllLines(file.toPath(), StandardCharsets.ISO_8859_1));
+        }
+    }
+
+    //Parses the table:
+    //    <stack> [other columns] Function
+    //      <stack at call> [other columns] -> Callee
+    private void parse(List<String> lines) {
+        boolean inSection = false;
+        boolean inTable = false;
+        Function current = null;
+        for (String line : lines) {
+            String text = line.trim();
+            if (!inSection) {
+                inSection = text.startsWith(SECTION_START);
+                continue;
+            }
+            if (!inTable) {
+                inTable = text.startsWith("---");
+                continue;
+            }
+            if (text.isEmpty()) {
+                continue;
+            }
+
+            //The leading numbers are the stack columns, the first one is the stack
+            String[] tokens = text.split("\\s+", -1);
+            int index = 0;
+            int stack = -1;
+            while (index < tokens.length && tokens[index].matches("\\d+")) {
+                if (stack < 0) {
+                    stack = Integer.parseInt(tokens[index]);
+                }
+                ++index;
+            }
+            if (stack < 0 || index == tokens.length) {
+                //The end of the table
+                inSection = false;
+                inTable = false;
+                current = null;
+                continue;
+            }
+
+            String name = join(tokens, index);
+            if (name.startsWith(CALL)) {
+                if (current != null) {
+                    String callee = name.substring(CALL.length()).trim();
+                    Integer previous = current.calls.get(callee);
+                    if (previous == null || previous < stack) {
+                        current.calls.put(callee, stack);
+                    }
+                }
+            } else {
+                current = functions.get(name);
+                if (current == null) {
+                    current = new Function(name);
+                    functions.put(name, current);
+                }
+                current.frame = Math.max(current.frame, stack);
+            }
+        }
+    }
+
+    private static String join(String[] tokens, int from) {
+        StringBuilder result = new StringBuilder();
+        for (int i = from; i < tokens.length; ++i) {
+            if (result.length() != 0) {
+                result.append(' ');
+            }
+            result.append(tokens[i]);
+        }
+        return result.toString();
+    }
+
+    private Depth getDepth(String name, Set<String> chain) {
+        Depth depth = depths.get(name);
+        if (depth != null) {
+            return depth;
+        }
+
+        Function function = functions.get(name);
+        if (function == null) {
+            unknown.add(name);
+            return new Depth(0, Collections.singletonList(name + " (no list file)"));
+        }
+        if (!chain.add(name)) {
+            recursive.add(name);
+            return new Depth(0, Collections.singletonList(name + " (recursion)"));
+        }
+
+        int bytes = function.frame;
+        List<String> deepest = Collections.emptyList();
+        for (Map.Entry<String, Integer> call : function.calls.entrySet()) {
+            Depth callee = getDepth(call.getKey(), chain);
+            if (call.getValue() + callee.bytes > bytes) {
+                bytes = call.getValue() + callee.bytes;
+                deepest = callee.path;
+            }
+        }
+        chain.remove(name);
+
+        List<String> path = new ArrayList<>();
+        path.add(name);
+        path.addAll(deepest);
+        depth = new Depth(bytes, path);
+        depths.put(name, depth);
+        return depth;
+    }
+
+    private void report() {
+        Set<String> called = new HashSet<>();
+        for (Function function : functions.values()) {
+            called.addAll(function.calls.keySet());
+        }
+
+        List<String> roots = new ArrayList<>();
+        for (String name : functions.keySet()) {
+            if (!called.contains(name)) {
+                roots.add(name);
+            }
+        }
+        Collections.sort(roots);
+
+        int interruptDepth = 0;
+        String deepestInterrupt = null;
+        for (String root : roots) {
+            if (isInterrupt(root)) {
+                Depth depth = getDepth(root, new HashSet<String>());
+                if (depth.bytes >= interruptDepth) {
+                    interruptDepth = depth.bytes;
+                    deepestInterrupt = root;
+                }
+            }
+        }
+
+        System.out.println("Call graph roots, the deepest call chain in bytes:");
+        for (String root : roots) {
+            Depth depth = getDepth(root, new HashSet<String>());
+            System.out.println(String.format("%5d  %s", depth.bytes, root));
+            for (int i = 1; i < depth.path.size(); ++i) {
+                System.out.println(String.format("%7s-> %s", "", depth.path.get(i)));
+            }
+        }
+
+        System.out.println();
+        if (deepestInterrupt != null) {
+            System.out.println(String.format("Deepest interrupt handler: %s, %d bytes", deepestInterrupt, interruptDepth));
+        }
+        System.out.println("Process stack estimate (exec + interrupt handler + interrupt frame):");
+        for (String root : roots) {
+            if (root.contains("::exec()")) {
+                int bytes = getDepth(root, new HashSet<String>()).bytes + interruptDepth + INTERRUPT_FRAME;
+                System.out.println(String.format("%5d  %s", bytes, root));
+            }
+        }
+
+        if (!unknown.isEmpty()) {
+            System.out.println();
+            System.out.println("Functions without the stack information (counted as zero):");
+            List<String> names = new ArrayList<>(unknown);
+            Collections.sort(names);
+            for (String name : names) {
+                System.out.println("       " + name);
+            }
+        }
+        if (!recursive.isEmpty()) {
+            System.out.println();
+            System.out.println("Recursive functions (the depth is not bounded): " + recursive);
+        }
+    }
+
+    //The interrupt handlers are declared by INTERRUPT_HANDLER with the _ISR suffix
+    private static boolean isInterrupt(String name) {
+        return name.contains("_ISR");
+    }
+}
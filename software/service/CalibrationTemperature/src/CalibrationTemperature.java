@@ -0,0 +1,181 @@
+import lejos.hardware.port.SensorPort;
+import lejos.hardware.sensor.imu.ImuLsm6ds3;
+
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Fits the temperature coefficients of the LSM6DS3 calibration matrices and writes
+ * the matrices for the device's temperature points.
+ *
+ * The input is the result of the 6-point calibration (Calibration program) repeated
+ * at several die temperatures: each directory contains X[scale].txt matrices.
+ * Each matrix element is fitted by a line over the temperature using the least squares method,
+ * and the lines are evaluated at TEMPERATURE_POINTS temperatures evenly spaced over the captured range.
+ * The device interpolates the matrices between the points by the current die temperature.
+ *
+ * Usage: CalibrationTemperature accel|gyro temperature1=directory1 temperature2=directory2 [...] [--dry-run]
+ */
+public class CalibrationTemperature {
+    private static final int ROWS = 4;
+    private static final int COLUMNS = 3;
+
+    public static void main(String[] args) throws IOException {
+        if (args.length < 3) {
+            System.out.println("Usage: CalibrationTemperature accel|gyro temperature1=directory1 temperature2=directory2 [...] [--dry-run]");
+            return;
+        }
+
+        boolean gyro = args[0].equals("gyro");
+        int scaleCount = gyro ? 5 : 4;
+        boolean dryRun = false;
+
+        List<Double> temperatures = new ArrayList<>();
+        List<String> directories = new ArrayList<>();
+        for (int i = 1; i < args.length; ++i) {
+            if (args[i].equals("--dry-run")) {
+                dryRun = true;
+            } else {
+                String[] parts = args[i].split("=", 2);
+                temperatures.add(Double.valueOf(parts[0]));
+                directories.add(parts[1]);
+            }
+        }
+        if (temperatures.size() < 2) {
+            System.out.println("At least two temperatures are required");
+            return;
+        }
+
+        double minTemperature = Double.MAX_VALUE;
+        double maxTemperature = -Double.MAX_VALUE;
+        for (double temperature : temperatures) {
+            minTemperature = Math.min(minTemperature, temperature);
+            maxTemperature = Math.max(maxTemperature, temperature);
+        }
+
+        int points = ImuLsm6ds3.TEMPERATURE_POINTS;
+        float[] pointTemperatures = new float[points];
+        for (int point = 0; point < points; ++point) {
+            pointTemperatures[point] = (float) (minTemperature + (maxTemperature - minTemperature) * point / (points - 1));
+        }
+
+        short[][][] eeprom = new short[scaleCount][points][];
+        for (int scale = 0; scale < scaleCount; ++scale) {
+            List<double[][]> matrices = new ArrayList<>();
+            for (String directory : directories) {
+                matrices.add(readMatrix(Paths.get(directory, String.format("X[%d].txt", scale)).toString()));
+            }
+
+            System.out.println(String.format("Scale %d: coefficient per degree at %.1f degrees", scale, (minTemperature + maxTemperature) / 2));
+            double[][] slope = new double[ROWS][COLUMNS];
+            double[][] intercept = new double[ROWS][COLUMNS];
+            for (int row = 0; row < ROWS; ++row) {
+                StringBuilder line = new StringBuilder();
+                for (int col = 0; col < COLUMNS; ++col) {
+                    double[] values = new double[matrices.size()];
+                    for (int i = 0; i < values.length; ++i) {
+                        values[i] = matrices.get(i)[row][col];
+                    }
+                    double[] fit = fitLine(temperatures, values);
+                    intercept[row][col] = fit[0];
+                    slope[row][col] = fit[1];
+                    line.append(String.format("%12.4e,", fit[1]));
+                }
+                System.out.println(line);
+            }
+
+            for (int point = 0; point < points; ++point) {
+                eeprom[scale][point] = toEeprom(intercept, slope, pointTemperatures[point]);
+            }
+        }
+
+        if (dryRun) {
+            return;
+        }
+
+        try (ImuLsm6ds3 sensor = new ImuLsm6ds3(SensorPort.S1, true)) {
+            for (int scale = 0; scale < scaleCount; ++scale) {
+                //The points are written in the ascending temperature order
+                for (int point = 0; point < points; ++point) {
+                    if (gyro) {
+                        sensor.writeGyroscopeEeprom(scale, point, pointTemperatures[point], eeprom[scale][point]);
+                    } else {
+                        sensor.writeAccelerometerEeprom(scale, point, pointTemperatures[point], eeprom[scale][point]);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Fits the line value = a + b * temperature using the least squares method
+     *
+     * @param temperatures temperatures of the captures
+     * @param values matrix element values of the captures
+     * @return a and b coefficients
+     */
+    private static double[] fitLine(List<Double> temperatures, double[] values) {
+        int count = values.length;
+        double meanTemperature = 0;
+        double meanValue = 0;
+        for (int i = 0; i < count; ++i) {
+            meanTemperature += temperatures.get(i) / count;
+            meanValue += values[i] / count;
+        }
+
+        double covariance = 0;
+        double variance = 0;
+        for (int i = 0; i < count; ++i) {
+            double dt = temperatures.get(i) - meanTemperature;
+            covariance += dt * (values[i] - meanValue);
+            variance += dt * dt;
+        }
+        double slope = covariance / variance;
+        return new double[] {meanValue - slope * meanTemperature, slope};
+    }
+
+    /**
+     * Converts the matrix evaluated at the temperature to the EEPROM format
+     * the same way as the 6-point calibration does.
+     */
+    private static short[] toEeprom(double[][] intercept, double[][] slope, double temperature) {
+        short[] result = new short[ROWS * COLUMNS];
+        int index = 0;
+        for (int row = 0; row < ROWS - 1; ++row) {
+            for (int col = 0; col < COLUMNS; ++col) {
+                result[index++] = toShort((intercept[row][col] + slope[row][col] * temperature) * 0x4000);
+            }
+        }
+        //The firmware multiplies the result by 2
+        for (int col = 0; col < COLUMNS; ++col) {
+            result[index++] = toShort((intercept[ROWS - 1][col] + slope[ROWS - 1][col] * temperature) / 2);
+        }
+        return result;
+    }
+
+    private static short toShort(double value) {
+        return (short) Math.max(Short.MIN_VALUE, Math.min(Short.MAX_VALUE, Math.round(value)));
+    }
+
+    /**
+     * Loads the 4x3 matrix saved by the calibration programs
+     *
+     * @param fileName file name to load CSV data from
+     * @return matrix with loaded data
+     * @throws IOException
+     */
+    private static double[][] readMatrix(String fileName) throws IOException {
+        double[][] matrix = new double[ROWS][COLUMNS];
+        List<String> lines = Files.readAllLines(Paths.get(fileName));
+        for (int row = 0; row < ROWS; ++row) {
+            String[] parts = lines.get(row).split(",");
+            for (int col = 0; col < COLUMNS; ++col) {
+                matrix[row][col] = Double.parseDouble(parts[col].trim());
+            }
+        }
+        return matrix;
+    }
+}